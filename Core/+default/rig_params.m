@@ -193,6 +193,8 @@ function rig_params = default_rig()
     rig_params.log_bkg_mc           = false;
     rig_params.log_live_image_mc    = false;
     rig_params.bg_mc_monitoring     = [];
+    rig_params.mc_sampling_rate     = 0;    % Hz. MC registers sampling rate for MC logs (e.g. 2000). 0 to read them at each acquisition loop, without background thread
+    rig_params.mc_log_format        = 'text'; % MC log file format. 'text' (.txt) or 'binary' (.mcbin, see import_MC_binary_log)
     rig_params.create_daq_fpga      = @(x) DaqFpgaDc('RIO0');
     rig_params.create_synth_fpga    = [];
     rig_params.create_encoder       = [];
@@ -35,6 +35,10 @@
 %   [norm_xyz] = obj.convert_xyz_pixels_to_norm(pixels_xyz,...
 %              mainscan_x_pixel_density)
 %
+% * Get a transform converting large arrays of points in one operation
+%   [transform] = obj.get_transform(acceptance_angle,...
+%               mainscan_x_pixel_density, stage_pos_z)
+%
 % * Convert cubic voxels to normalized units
 %   [pixel_size_um] = obj.get_pixel_size(acceptance_angle,...
 %                   mainscan_x_pixel_density)
@@ -92,7 +96,7 @@
 % Revision Date:
 %   24-02-2020
 %
-% See also: default.aol_params, ScanParams
+% See also: default.aol_params, ScanParams, AolTransform
 %
 
 % TODO :
@@ -293,6 +297,9 @@ classdef AolParams < handle
             %       distance in um from natural plane           
             % -------------------------------------------------------------
             % Extra Notes:
+            %   Unlike convert_z_um_to_norm, there is no stage_pos_z input.
+            % AolTransform.norm_to_um adds stage_pos_z to this value, so
+            % that it is the exact inverse of convert_z_um_to_norm.
             % -------------------------------------------------------------
             % Author(s):
             %   Antoine Valera, Geoffrey Evans
@@ -453,6 +460,51 @@ classdef AolParams < handle
             norm_xyz(3,:) = obj.xy_z_norm_ratio * (((pixels_xyz(3,:) ./ mainscan_x_pixel_density) * 2));
         end
         
+        function transform = get_transform(obj, acceptance_angle, mainscan_x_pixel_density, stage_pos_z)
+            %% Get a transform converting large arrays of points at once
+            % -------------------------------------------------------------
+            % Syntax: 
+            %   transform = AolParams.get_transform(acceptance_angle,
+            %               mainscan_x_pixel_density, stage_pos_z)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   acceptance_angle (FLOAT) - Optional
+            %       current acceptance_angle value as in
+            %       ScanParams.acceptance_angle 
+            %   mainscan_x_pixel_density (FLOAT) - Optional
+            %       current mainscan_x_pixel_density value as in
+            %       ScanParams.mainscan_x_pixel_density 
+            %   stage_pos_z (FLOAT) - Optional - default is 0
+            %       reference position from which z distance is calculated.
+            %       See AolParams.convert_z_um_to_norm
+            % -------------------------------------------------------------
+            % Outputs: 
+            %   transform (AolTransform object)
+            %       Converts [3 x N] points between norm, um and pixels
+            % -------------------------------------------------------------
+            % Extra Notes:
+            % Calibration and scan values are read once. Use the transform
+            % instead of the convert_* functions when converting points in
+            % a loop, or many points at once.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            %---------------------------------------------
+            % Revision Date:
+            %   18-10-2026  
+            
+            if nargin < 2
+                acceptance_angle = [];
+            end
+            if nargin < 3
+                mainscan_x_pixel_density = [];
+            end
+            if nargin < 4
+                stage_pos_z = [];
+            end
+            transform = AolTransform(obj, acceptance_angle, mainscan_x_pixel_density, stage_pos_z);
+        end
+        
        
         function fov_um = get.fov_um(obj)
             %% Return the FOV in raster mode
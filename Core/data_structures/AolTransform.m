@@ -0,0 +1,217 @@
+%% Batch conversion of points between normalised, um and pixel units
+%   An AolTransform freezes the AolParams calibration and the ScanParams
+%   values required by the AolParams conversion functions, so that large
+%   arrays of points can be converted in a single vectorised operation,
+%   without querying the controller for each call.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = AolTransform(aol_params, acceptance_angle,
+%                       mainscan_x_pixel_density, stage_pos_z)
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   aol_params (AolParams object)
+%       Provides x_norm_to_um_scaling, z_norm_to_um_scaling and
+%       xy_z_norm_ratio
+%
+%   acceptance_angle (FLOAT) - Optional - default is current value
+%       current acceptance_angle value as in ScanParams.acceptance_angle
+%
+%   mainscan_x_pixel_density (INT) - Optional - default is current value
+%       current mainscan_x_pixel_density value as in
+%       ScanParams.mainscan_x_pixel_density
+%
+%   stage_pos_z (FLOAT) - Optional - default is 0
+%       Absolute Z position of the natural plane, as given by the stage. If
+%       0, Z values in um are distances from the natural plane.
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (AolTransform object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Convert normalised points to um, and back
+%   xyz_um = AolTransform.norm_to_um(xyz_norm)
+%   xyz_norm = AolTransform.um_to_norm(xyz_um)
+%
+% * Convert cubic voxels to normalised points, and back
+%   xyz_norm = AolTransform.pixels_to_norm(xyz_pixels)
+%   xyz_pixels = AolTransform.norm_to_pixels(xyz_norm)
+%
+% * Convert cubic voxels to um, and back
+%   xyz_um = AolTransform.pixels_to_um(xyz_pixels)
+%   xyz_pixels = AolTransform.um_to_pixels(xyz_um)
+%
+% * Convert Z only, between normalised units and um
+%   z_um = AolTransform.z_norm_to_um(z_norm)
+%   z_norm = AolTransform.z_um_to_norm(z_um)
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Points are [3 x N] arrays of X, Y and Z coordinates. [2 x N] arrays are
+%   converted as XY only, and [1 x N] arrays as X only. Use the Z row of a
+%   [3 x N] array for Z only conversions.
+%
+% * Conversions give the same results as the corresponding AolParams
+%   functions: XY um are distances from the FOV centre, and XY pixels
+%   start at the corner of the FOV (see
+%   AolParams.convert_xyz_pixels_to_norm).
+%
+% * Z um are absolute positions, in the stage reference. um_to_norm is
+%   AolParams.convert_z_um_to_norm(z_um, acceptance_angle, stage_pos_z),
+%   and norm_to_um is its inverse, i.e. stage_pos_z +
+%   AolParams.convert_z_norm_to_um(z_norm). convert_z_norm_to_um has no
+%   stage input and returns a distance from the natural plane, so both
+%   only match when stage_pos_z is 0 (the default).
+%
+% * The transform is a snapshot. Build a new one with
+%   AolParams.get_transform if the objective, wavelength, zoom, resolution
+%   or stage position change.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Convert 10000 pointing targets from um to normalised units
+%   t = c.aol_params.get_transform([], [], c.xyz_stage.get_position(3));
+%   xyz_norm = t.um_to_norm(xyz_um);
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: AolParams, AolParams.get_transform, ScanParams
+
+classdef AolTransform
+    properties (SetAccess = private)
+        acceptance_angle            ; % Acceptance angle used for the conversions
+        mainscan_x_pixel_density    ; % Number of XY pixels between norm -1 and +1
+        stage_pos_z         = 0     ; % Absolute Z position of the natural plane, in um
+        um_scale                    ; % [3 x 1] um per norm unit, for X, Y and Z
+        um_offset                   ; % [3 x 1] um position of norm 0, for X, Y and Z
+        pixel_scale                 ; % [3 x 1] norm units per pixel, for X, Y and Z
+        pixel_offset                ; % [3 x 1] norm position of pixel 0, for X, Y and Z
+    end
+
+    methods
+        function this = AolTransform(aol_params, acceptance_angle, mainscan_x_pixel_density, stage_pos_z)
+            %% AolTransform Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = AolTransform(aol_params, acceptance_angle,
+            %                       mainscan_x_pixel_density, stage_pos_z)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   See class description
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (AolTransform object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 3 || isempty(acceptance_angle) || isempty(mainscan_x_pixel_density)
+                [current_aa, current_density] = aol_params.get_scan_params();
+                if nargin < 2 || isempty(acceptance_angle)
+                    acceptance_angle = current_aa;
+                end
+                if nargin < 3 || isempty(mainscan_x_pixel_density)
+                    mainscan_x_pixel_density = current_density;
+                end
+            end
+            if nargin < 4 || isempty(stage_pos_z)
+                stage_pos_z = 0;
+            end
+
+            this.acceptance_angle           = acceptance_angle;
+            this.mainscan_x_pixel_density   = mainscan_x_pixel_density;
+            this.stage_pos_z                = stage_pos_z;
+
+            %% Same relations as AolParams.convert_*, as one affine map per axis
+            xy_um                           = aol_params.x_norm_to_um_scaling * acceptance_angle;
+            this.um_scale                   = [xy_um; xy_um; aol_params.z_norm_to_um_scaling * acceptance_angle];
+            this.um_offset                  = [0; 0; stage_pos_z];
+            xy_norm                         = 2 / mainscan_x_pixel_density;
+            this.pixel_scale                = [xy_norm; xy_norm; aol_params.xy_z_norm_ratio * xy_norm];
+            this.pixel_offset               = [-1; -1; 0];
+        end
+
+        function xyz_um = norm_to_um(this, xyz_norm)
+            %% Convert normalised points to um
+            xyz_um = AolTransform.apply(xyz_norm, this.um_scale, this.um_offset);
+        end
+
+        function xyz_norm = um_to_norm(this, xyz_um)
+            %% Convert um points to normalised units
+            xyz_norm = AolTransform.apply(xyz_um, 1 ./ this.um_scale, -this.um_offset ./ this.um_scale);
+        end
+
+        function xyz_norm = pixels_to_norm(this, xyz_pixels)
+            %% Convert cubic voxels to normalised units
+            xyz_norm = AolTransform.apply(xyz_pixels, this.pixel_scale, this.pixel_offset);
+        end
+
+        function xyz_pixels = norm_to_pixels(this, xyz_norm)
+            %% Convert normalised points to cubic voxels
+            xyz_pixels = AolTransform.apply(xyz_norm, 1 ./ this.pixel_scale, -this.pixel_offset ./ this.pixel_scale);
+        end
+
+        function xyz_um = pixels_to_um(this, xyz_pixels)
+            %% Convert cubic voxels to um
+            xyz_um = AolTransform.apply(xyz_pixels, this.pixel_scale .* this.um_scale, this.pixel_offset .* this.um_scale + this.um_offset);
+        end
+
+        function xyz_pixels = um_to_pixels(this, xyz_um)
+            %% Convert um points to cubic voxels
+            scale       = this.pixel_scale .* this.um_scale;
+            offset      = this.pixel_offset .* this.um_scale + this.um_offset;
+            xyz_pixels  = AolTransform.apply(xyz_um, 1 ./ scale, -offset ./ scale);
+        end
+
+        function z_um = z_norm_to_um(this, z_norm)
+            %% Convert normalised Z values, of any size, to um
+            z_um = z_norm * this.um_scale(3) + this.um_offset(3);
+        end
+
+        function z_norm = z_um_to_norm(this, z_um)
+            %% Convert Z values in um, of any size, to normalised units
+            z_norm = (z_um - this.um_offset(3)) / this.um_scale(3);
+        end
+    end
+
+    methods (Static, Access = private)
+        function out = apply(points, scale, offset)
+            %% Apply one affine map per row to a [1-3 x N] array of points
+            n_rows = size(points, 1);
+            if n_rows > 3
+                error('Points must be passed as a [3 x N], [2 x N] or [1 x N] array')
+            end
+            out = points .* scale(1:n_rows) + offset(1:n_rows);
+        end
+    end
+end
@@ -0,0 +1,316 @@
+%% Look-up table of Pockels cell values vs depth
+%   A PockelsLut samples the Pockels cell value vs Z relation once, on a
+%   regular grid, so that the value of any number of drives can then be
+%   obtained with a few vectorised operations. It uses the same linear and
+%   exponential relations as StackAndTiles.get_pockels_vs_Z_values, or any
+%   measured calibration, and returns values on the grid of the
+%   pockels_level field sent to the AOL Control FPGA.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = PockelsLut(z_start, z_stop, pockels_start, pockels_stop,
+%                     interpolation_mode, n_samples)
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   z_start (FLOAT)
+%       Depth in um of the first plane, typically StackAndTiles.z_start
+%
+%   z_stop (FLOAT)
+%       Depth in um of the last plane, typically StackAndTiles.z_stop
+%
+%   pockels_start (FLOAT) value between 0 and 2
+%       Voltage of Pockels for z_start
+%
+%   pockels_stop (FLOAT) value between 0 and 2
+%       Voltage of Pockels for z_stop
+%
+%   interpolation_mode (STR) - Optional - any in {'linear',
+%           'exponential'} - default is 'linear'
+%       Interpolation method, as in StackAndTiles.get_pockels_vs_Z_values
+%
+%   n_samples (INT) - Optional - default is 1024
+%       Number of samples of the table between z_start and z_stop
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (PockelsLut object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Build a table from measured (depth, value) pairs (static)
+%   this = PockelsLut.from_samples(z_um, pockels, n_samples)
+%
+% * Pockels value at any depths
+%   pockels = PockelsLut.evaluate(z_um)
+%
+% * Pockels value of each drive of a scan, for each AOD
+%   pockels = PockelsLut.drive_levels(scan_params, aol_params, stage_z)
+%
+% * Encoded pockels_level field, as sent by make_xy_records (static)
+%   words = PockelsLut.quantise(pockels)
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Values are linearly interpolated between samples, and held constant
+%   outside of [z_start, z_stop]. Samples are regularly spaced, so the
+%   sample index of each depth is computed directly, without search.
+%
+% * The topmost plane needs the lowest Pockels value (see
+%   StackAndTiles.get_pockels_vs_Z_values). For the exponential mode, tau
+%   is the same hardcoded value.
+%
+% * Returned values are rounded to the 1/2^13 V steps of the pockels_level
+%   field, and can be passed to Controller.send_drives or
+%   ScanParams.pockels_raw as a [4 x N] array without further checks.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Compensate the power of each point of a 3D functional scan
+%   lut = PockelsLut(c.xyz_stage.z_start, c.xyz_stage.z_stop, 0.4, 1.2, 'exponential');
+%   pockels = lut.drive_levels(c.scan_params, c.aol_params, c.xyz_stage.get_position(3));
+%   c.send_drives(true, pockels);
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: StackAndTiles.get_pockels_vs_Z_values, StackAndTiles,
+%   make_xy_records, ScanParams
+
+classdef PockelsLut < handle
+    properties
+        z_first     = 0     ; % Depth of the first sample, in um
+        z_step      = 0     ; % Spacing between samples, in um. 0 for a constant table
+        values      = 0     ; % [1 x N] Pockels value of each sample
+    end
+
+    properties (Constant)
+        tau         = 5     ; % Exponential mode decay, as in StackAndTiles.get_pockels_vs_Z_values
+        level_steps = 2^13  ; % pockels_level steps per V (see make_xy_records)
+    end
+
+    methods
+        function this = PockelsLut(z_start, z_stop, pockels_start, pockels_stop, interpolation_mode, n_samples)
+            %% PockelsLut Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = PockelsLut(z_start, z_stop, pockels_start,
+            %                     pockels_stop, interpolation_mode,
+            %                     n_samples)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   See class description
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (PockelsLut object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 4 % used by PockelsLut.from_samples
+                return
+            end
+            if nargin < 5 || isempty(interpolation_mode)
+                interpolation_mode = 'linear';
+            end
+            if nargin < 6 || isempty(n_samples)
+                n_samples = 1024;
+            end
+
+            %% Same checks as StackAndTiles.get_pockels_vs_Z_values
+            if z_start > z_stop && pockels_start > pockels_stop
+                error('Z start is above Z stop (normal stack) but pockel start is higher. The topmost Z needs the lowest pockel value. Check your limits')
+            elseif z_start < z_stop && pockels_start < pockels_stop
+                error('Z start is below Z stop (reversed stack) but pockel stop is higher. The topmost Z needs the lowest pockel value. Check your limits')
+            end
+
+            %% Sample the relation between the topmost and the deepest plane
+            [stack_range, order]  = sort([z_start, z_stop], 'descend');
+            pockel_range    = [pockels_start, pockels_stop];
+            pockel_range    = pockel_range(order);
+            if stack_range(1) == stack_range(2)
+                this.values = mean(pockel_range);
+                this.z_first = stack_range(1);
+                return
+            end
+            planes          = linspace(stack_range(1), stack_range(2), n_samples);
+            if pockel_range(1) == pockel_range(2) || strcmp(interpolation_mode, 'linear')
+                samples     = linspace(pockel_range(1), pockel_range(2), n_samples);
+            elseif strcmp(interpolation_mode, 'exponential')
+                amp         = pockel_range(2) - pockel_range(1);
+                samples     = pockel_range(2) - amp * exp(this.tau / (stack_range(1) - stack_range(2)) * (planes - stack_range(1)));
+            else
+                error('PockelsLut interpolation_mode must be ''linear'' or ''exponential''')
+            end
+            this.set_samples(planes, samples);
+        end
+
+        function pockels = evaluate(this, z_um)
+            %% Pockels value at any depths
+            % -------------------------------------------------------------
+            % Syntax:
+            %   pockels = PockelsLut.evaluate(z_um)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   z_um (NUMERIC ARRAY)
+            %       Depths, in um
+            % -------------------------------------------------------------
+            % Outputs:
+            %   pockels (NUMERIC ARRAY)
+            %       Pockels values, same size as z_um, rounded to the
+            %       pockels_level steps
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            n = numel(this.values);
+            if n == 1 || ~this.z_step
+                pockels = repmat(this.values(1), size(z_um));
+            else
+                pos     = min(max((z_um - this.z_first) / this.z_step, 0), n - 1); % 0-based, clamped
+                low     = min(floor(pos), n - 2);
+                frac    = pos - low;
+                pockels = this.values(low + 1) .* (1 - frac) + this.values(low + 2) .* frac;
+                pockels = reshape(pockels, size(z_um));
+            end
+            pockels = round(pockels * this.level_steps) / this.level_steps;
+        end
+
+        function pockels = drive_levels(this, scan_params, aol_params, stage_z)
+            %% Pockels value of each drive of a scan, for each AOD
+            % -------------------------------------------------------------
+            % Syntax:
+            %   pockels = PockelsLut.drive_levels(scan_params, aol_params,
+            %                                     stage_z)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   scan_params (ScanParams object)
+            %       The scan. The depth of a drive is the Z of its centre.
+            %       In Pointing mode, all the points of the grid get the
+            %       value of the grid depth
+            %
+            %   aol_params (AolParams object)
+            %       Used to convert normalised Z into um
+            %
+            %   stage_z (FLOAT) - Optional - default is 0
+            %       Stage Z position, in um, in the same reference as the
+            %       table
+            % -------------------------------------------------------------
+            % Outputs:
+            %   pockels ([4 x num_drives] FLOAT)
+            %       Pockels value of each drive, for each AOD, to pass to
+            %       Controller.send_drives or ScanParams.pockels_raw
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 4 || isempty(stage_z)
+                stage_z = 0;
+            end
+            centre  = scan_params.centre_norm;
+            transform = aol_params.get_transform(scan_params.acceptance_angle, scan_params.mainscan_x_pixel_density, stage_z);
+            z_um    = transform.z_norm_to_um(centre(3, :));
+            if scan_params.imaging_mode == ImagingMode.Pointing
+                %% Each of the num_drives points of the grid is a drive.
+                % Pointing grids cannot be rotated, so they share one depth
+                z_um = repmat(z_um(1), 1, scan_params.num_drives);
+            end
+            pockels = repmat(this.evaluate(z_um), 4, 1);
+        end
+    end
+
+    methods (Static)
+        function this = from_samples(z_um, pockels, n_samples)
+            %% Build a table from measured (depth, value) pairs
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = PockelsLut.from_samples(z_um, pockels, n_samples)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   z_um ([1 x N] FLOAT)
+            %       Depths of the measurements, in um
+            %
+            %   pockels ([1 x N] FLOAT)
+            %       Pockels value required at each depth
+            %
+            %   n_samples (INT) - Optional - default is 1024
+            %       Number of samples of the table
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (PockelsLut object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 3 || isempty(n_samples)
+                n_samples = 1024;
+            end
+            [z_um, idx] = unique(z_um(:));
+            pockels     = pockels(idx);
+            this        = PockelsLut();
+            if numel(z_um) == 1
+                this.z_first = z_um;
+                this.values  = pockels;
+                return
+            end
+            planes      = linspace(z_um(1), z_um(end), n_samples);
+            this.set_samples(planes, interp1(z_um, pockels(:), planes, 'linear'));
+        end
+
+        function words = quantise(pockels)
+            %% Encoded pockels_level field, as sent by make_xy_records
+            words = uint16(pockels * PockelsLut.level_steps - 1);
+        end
+    end
+
+    methods (Access = private)
+        function set_samples(this, planes, samples)
+            %% Store regularly spaced samples, in increasing depth order
+            if planes(end) < planes(1)
+                planes  = fliplr(planes);
+                samples = fliplr(samples);
+            end
+            if any(samples < 0 | samples > 2)
+                error('Pockel values must be between 0 and 2')
+            end
+            this.z_first    = planes(1);
+            this.z_step     = planes(2) - planes(1);
+            this.values     = samples(:)';
+        end
+    end
+end
@@ -0,0 +1,338 @@
+%% Gather/scatter map between raw voxel streams and per-patch tiles
+%   A ScanLayout describes how the voxels of one cycle are organised in
+%   the FIFO stream, for any scan mode. Consecutive ramps with the same
+%   resolution, the same direction and a regular spacing are grouped as
+%   one rectangular patch (a miniscan, a functional patch, a line...).
+%   Index maps are computed once, so that streams of any number of cycles
+%   can then be split into tiles, or packed into a display mosaic, with a
+%   single vectorised gather per patch.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = ScanLayout(scan_params, lines_per_patch)
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   scan_params (ScanParams object) - Optional - default is
+%                                     current Controller.scan_params
+%       The ScanParams object describing the scan. A ScanParams reloaded
+%       from a header works as well, for offline analysis.
+%
+%   lines_per_patch (1 x N_patches INT) - Optional - default is []
+%       The number of ramps in each patch, in acquisition order. If empty,
+%       patches are detected from the ramps geometry. When the patches
+%       were generated with ScanParams.generate_miniscan_boxes, use
+%       ScanLayout.lines_from_boxes(boxes) to remove any ambiguity.
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Split a voxel stream into one tile per patch
+%   tiles = ScanLayout.to_tiles(data)
+%
+% * Concatenate tiles back into a voxel stream
+%   data = ScanLayout.to_stream(tiles)
+%
+% * Pack a voxel stream into a 2D mosaic of patches (for display)
+%   mosaic = ScanLayout.to_mosaic(data)
+%
+% * Get the number of lines of each patch generated by
+%   ScanParams.generate_miniscan_boxes / Controller.set_miniscans
+%   lines_per_patch = ScanLayout.lines_from_boxes(boxes)
+% -------------------------------------------------------------------------
+% Extra Notes:
+%   Data streams are in the format returned by timed_image, i.e.
+%   [(n_points * n_cycles) x n_channels], or [n_points x n_cycles x
+%   n_channels]. Tiles are [voxels x lines x n_cycles x n_channels].
+%
+%   In Pointing mode, the whole grid is a single square patch.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Get one tile per miniscan for a 100 cycles recording
+%   layout = ScanLayout(c.scan_params);
+%   [all_data, n_cycles] = c.timed_image('number_of_cycles', 100);
+%   tiles = layout.to_tiles(all_data{1});
+%   imagesc(mean(tiles{1}(:,:,:,1), 3));
+%
+% * Display all patches of an averaged frame in one image
+%   layout = ScanLayout(c.scan_params);
+%   imagesc(layout.to_mosaic(c.single_record(10)));
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: ScanParams, ScanParams.generate_miniscan_boxes,
+%   drives.set_miniscans, get_averaged_data, LiveViewer
+
+classdef ScanLayout < handle
+    properties
+        n_points        = 0 ; % Number of voxels in one cycle
+        n_patches       = 0 ; % Number of rectangular patches
+        patch_size      = []; % [N_patches x 2] INT. Voxels per line and number of lines in each patch
+        first_line      = []; % [1 x N_patches] INT. First ramp of each patch
+        gather_idx      = {}; % {1 x N_patches} cell of voxel indexes, in the stream, for each patch
+        mosaic_size     = []; % [1 x 2] INT. Size of the display mosaic
+        scatter_map     = []; % [n_points x 1] INT. Linear index of each stream voxel in the mosaic
+        tolerance       = 1e-6; % Tolerance, in normalised units, when grouping ramps
+    end
+
+    methods
+        function this = ScanLayout(scan_params, lines_per_patch)
+            %% ScanLayout Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = ScanLayout(scan_params, lines_per_patch)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   scan_params (ScanParams object) - Optional - default is
+            %                                     current scan_params
+            %       The ScanParams object describing the scan.
+            %
+            %   lines_per_patch (1 x N_patches INT) - Optional - default
+            %           is [] (auto detection)
+            %       The number of ramps in each patch, in acquisition
+            %       order.
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (ScanLayout object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 1 || isempty(scan_params)
+                controller = get_existing_controller_name(true);
+                scan_params = controller.scan_params;
+            end
+            if nargin < 2
+                lines_per_patch = [];
+            end
+
+            %% Get ramps geometry once (these are all dependent properties)
+            voxels = scan_params.voxels_for_ramp;
+            if scan_params.imaging_mode == ImagingMode.Functional
+                voxels(:) = 1; % one voxel per drive, see ScanParams.num_voxels
+            end
+            if scan_params.imaging_mode == ImagingMode.Pointing
+                side                = sqrt(scan_params.num_drives);
+                this.patch_size     = [side, side];
+                this.first_line     = 1;
+            elseif isempty(lines_per_patch) && scan_params.imaging_mode == ImagingMode.Raster
+                this.patch_size     = [voxels(1), numel(voxels)];
+                this.first_line     = 1;
+            else
+                if isempty(lines_per_patch)
+                    lines_per_patch = this.detect_patches(scan_params.start_norm, scan_params.stop_norm, voxels);
+                elseif sum(lines_per_patch) ~= numel(voxels)
+                    error('lines_per_patch must sum to the number of drives (%d)', numel(voxels))
+                end
+                this.first_line     = cumsum([1, lines_per_patch(1:end-1)]);
+                if any(arrayfun(@(p) numel(unique(voxels(this.first_line(p) + (0:lines_per_patch(p)-1)))), 1:numel(lines_per_patch)) > 1)
+                    error('All lines of a patch must have the same resolution')
+                end
+                this.patch_size     = [voxels(this.first_line)', lines_per_patch(:)];
+            end
+            this.n_patches  = size(this.patch_size, 1);
+            this.n_points   = sum(prod(this.patch_size, 2));
+            this.build_index_maps();
+        end
+
+        function tiles = to_tiles(this, data)
+            %% Split a voxel stream into one tile per patch
+            % -------------------------------------------------------------
+            % Syntax:
+            %   tiles = ScanLayout.to_tiles(data)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   data ([(n_points * K) x C] or [n_points x K x C] NUMERIC)
+            %       K cycles of C channels.
+            % -------------------------------------------------------------
+            % Outputs:
+            %   tiles ({1 x N_patches} CELL of [vox x lines x K x C])
+            %       One tile per patch, same type as data.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            [data, n_cycles, n_channels] = this.as_cycles(data);
+            tiles = cell(1, this.n_patches);
+            for p = 1:this.n_patches
+                tiles{p} = reshape(data(this.gather_idx{p}, :), this.patch_size(p,1), this.patch_size(p,2), n_cycles, n_channels);
+            end
+        end
+
+        function data = to_stream(this, tiles)
+            %% Concatenate tiles back into a voxel stream
+            % -------------------------------------------------------------
+            % Syntax:
+            %   data = ScanLayout.to_stream(tiles)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   tiles ({1 x N_patches} CELL of [vox x lines x K x C])
+            %       Tiles, as returned by ScanLayout.to_tiles
+            % -------------------------------------------------------------
+            % Outputs:
+            %   data ([(n_points * K) x C] NUMERIC)
+            %       The stream, in the timed_image format.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            n_cycles    = size(tiles{1}, 3);
+            n_channels  = size(tiles{1}, 4);
+            data        = zeros(this.n_points, n_cycles * n_channels, 'like', tiles{1});
+            for p = 1:this.n_patches
+                data(this.gather_idx{p}, :) = reshape(tiles{p}, [], n_cycles * n_channels);
+            end
+            data = reshape(data, this.n_points * n_cycles, n_channels);
+        end
+
+        function mosaic = to_mosaic(this, data, fill_value)
+            %% Pack a voxel stream into a 2D mosaic of patches
+            % -------------------------------------------------------------
+            % Syntax:
+            %   mosaic = ScanLayout.to_mosaic(data, fill_value)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   data ([(n_points * K) x C] or [n_points x K x C] NUMERIC)
+            %       K cycles of C channels.
+            %
+            %   fill_value (NUMERIC) - Optional - default is 0
+            %       Value of the mosaic pixels that are not scanned
+            % -------------------------------------------------------------
+            % Outputs:
+            %   mosaic ([mosaic_size(1) x mosaic_size(2) x K x C])
+            %       Patches laid out on a regular grid. Each grid cell is
+            %       as large as the largest patch.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 3 || isempty(fill_value)
+                fill_value = 0;
+            end
+            [data, n_cycles, n_channels] = this.as_cycles(data);
+            mosaic = repmat(cast(fill_value, 'like', data), prod(this.mosaic_size), n_cycles * n_channels);
+            mosaic(this.scatter_map, :) = data;
+            mosaic = reshape(mosaic, this.mosaic_size(1), this.mosaic_size(2), n_cycles, n_channels);
+        end
+    end
+
+    methods (Static)
+        function lines_per_patch = lines_from_boxes(boxes)
+            %% Number of lines generated by set_miniscans for each box
+            % -------------------------------------------------------------
+            % Syntax:
+            %   lines_per_patch = ScanLayout.lines_from_boxes(boxes)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   boxes ({corner,v1,v2,v3} STRUCT CELL ARRAY)
+            %       As returned by ScanParams.generate_miniscan_boxes
+            % -------------------------------------------------------------
+            % Outputs:
+            %   lines_per_patch (1 x N_patches INT)
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   Matches the default behaviour of drives.set_miniscans (no
+            %   forced_res), where the number of lines is the length of v2
+            %   in pixels.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            lines_per_patch = cellfun(@(box) max(1, floor(norm(box.v2))), boxes);
+        end
+    end
+
+    methods (Access = private)
+        function lines_per_patch = detect_patches(this, start, stop, voxels)
+            %% Group consecutive ramps with same resolution, direction and spacing
+            n_lines     = size(start, 2);
+            direction   = stop - start;
+            same_ramp   = [false, voxels(2:end) == voxels(1:end-1) & all(abs(diff(direction, 1, 2)) < this.tolerance, 1)];
+            steps       = [zeros(3,1), diff(start, 1, 2)];
+            new_patch   = true(1, n_lines);
+            patch_step  = [];
+            for line = 2:n_lines
+                if same_ramp(line) && (isempty(patch_step) || all(abs(steps(:,line) - patch_step) < this.tolerance))
+                    new_patch(line) = false;
+                    if isempty(patch_step)
+                        patch_step = steps(:,line);
+                    end
+                else
+                    patch_step = [];
+                end
+            end
+            lines_per_patch = diff([find(new_patch), n_lines + 1]);
+        end
+
+        function build_index_maps(this)
+            %% Precompute stream -> tile and stream -> mosaic indexes
+            offsets         = cumsum([0; prod(this.patch_size(1:end-1,:), 2)]);
+            this.gather_idx = arrayfun(@(p) offsets(p) + (1:prod(this.patch_size(p,:)))', 1:this.n_patches, 'UniformOutput', false);
+
+            %% Mosaic is a near-square grid of cells of the size of the largest patch
+            cell_size       = max(this.patch_size, [], 1);
+            n_cols          = ceil(sqrt(this.n_patches));
+            n_rows          = ceil(this.n_patches / n_cols);
+            this.mosaic_size = cell_size .* [n_cols, n_rows];
+            this.scatter_map = zeros(this.n_points, 1);
+            for p = 1:this.n_patches
+                [x, y]      = ndgrid(1:this.patch_size(p,1), 1:this.patch_size(p,2));
+                col         = mod(p - 1, n_cols);
+                row         = floor((p - 1) / n_cols);
+                this.scatter_map(this.gather_idx{p}) = (col * cell_size(1) + x(:)) + (row * cell_size(2) + y(:) - 1) * this.mosaic_size(1);
+            end
+        end
+
+        function [data, n_cycles, n_channels] = as_cycles(this, data)
+            %% Reshape any stream to [n_points x (n_cycles * n_channels)]
+            if ndims(data) == 3
+                n_channels = size(data, 3);
+            else
+                n_channels = size(data, 2);
+            end
+            n_cycles = numel(data) / (this.n_points * n_channels);
+            if mod(n_cycles, 1)
+                error('Data size is not a multiple of the number of voxels per cycle (%d)', this.n_points)
+            end
+            data = reshape(data, this.n_points, n_cycles * n_channels);
+        end
+    end
+end
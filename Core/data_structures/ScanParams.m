@@ -37,6 +37,16 @@
 % * Set all z at the same value
 %   [fps, cycle_duration, line_duration] = obj.get_fps(averages)
 %
+% * Line start times with MC interrupts, without a ScanParams object
+%   [t_line, total_duration] = ScanParams.line_schedule(line_duration,
+%                                       n_cycles, MC_duration, MC_rate)
+%
+% * Line, voxel and MC cycle timings of the current drives
+%   timing_table = obj.get_timing_table(MC_scan_params, MC_rate)
+%
+% * Time of each voxel, from a timing table
+%   t_voxel = ScanParams.voxel_timestamps(timing_table, cycles)
+%
 % * ...
 %   [amp0, amp1, amp2] = obj.amp(a, b, c))
 %
@@ -49,12 +59,22 @@
 % * Display drives/voxels location in normalized space
 %   obj.plot_drives(mode, fig_nb)
 %
+% * Clear cached start_norm/stop_norm and derived values
+%   obj.invalidate_cache(changed)
+%
 % -------------------------------------------------------------------------
 % Extra Notes:
 %
 %   If there was a massive change the acquisition system, check if
 %   low_aod_delay_cycles_limit is still right
 %
+%   start_norm/stop_norm (handle_image_start_stops), cubic_norm_distance
+%   and num_drives are cached. Setters of the properties they depend on
+%   clear them (see CACHE_DEPENDENCIES), so the ramps are regenerated once
+%   per change instead of at every access. If you edit an AolParams value
+%   used by the ramps (other than the xy/z norm ratio), call
+%   invalidate_cache().
+%
 % -------------------------------------------------------------------------
 % Examples: 
 %
@@ -165,6 +185,23 @@ classdef ScanParams < handle
     properties (Hidden = true)
         mainscan_voxel_density_1D ; % backcompatibility fix. replaced by mainscan_x_pixel_density
     end
+    
+    properties (Hidden = true, Transient = true)
+        derived_cache = struct(); % Cached derived values. See ScanParams.cached()
+        cache_version = 0       ; % Incremented every time a cached value is invalidated
+    end
+    
+    properties (Constant = true)
+        MAX_SCAN_TIME = 248e-6  ; % Longest scan time of a ramp, in s (excluding fill time)
+    end
+    
+    properties (Constant = true, Hidden = true)
+        %% Cached value -> properties (or cached values) it depends on
+        CACHE_DEPENDENCIES = struct(...
+            'start_stop'            , {{'imaging_mode', 'start_norm_raw', 'stop_norm_raw', 'angles', 'quaternions', 'mainscan_x_pixel_density', 'aol_params_handle'}},...
+            'cubic_norm_distance'   , {{'start_stop'}},...
+            'num_drives'            , {{'start_stop'}});
+    end
 
     methods
         function obj = ScanParams(aol_params)
@@ -210,6 +247,132 @@ classdef ScanParams < handle
             end
         end
         
+        function set.aol_params_handle(obj, aol_params_handle)
+            obj.aol_params_handle = aol_params_handle;
+            obj.invalidate_cache('aol_params_handle');
+        end
+        
+        function set.imaging_mode(obj, imaging_mode)
+            if ~isequal(obj.imaging_mode, imaging_mode)
+                obj.imaging_mode = imaging_mode;
+                obj.invalidate_cache('imaging_mode');
+            end
+        end
+        
+        function set.angles(obj, angles)
+            if ~isequal(obj.angles, angles)
+                obj.angles = angles;
+                obj.invalidate_cache('angles');
+            end
+        end
+        
+        function set.quaternions(obj, quaternions)
+            if ~isequal(obj.quaternions, quaternions)
+                obj.quaternions = quaternions;
+                obj.invalidate_cache('quaternions');
+            end
+        end
+        
+        function set.mainscan_voxel_density_1D(obj, mainscan_voxel_density_1D)
+            %% Old headers only. Used when mainscan_x_pixel_density is empty
+            obj.mainscan_voxel_density_1D = mainscan_voxel_density_1D;
+            obj.invalidate_cache('mainscan_x_pixel_density');
+        end
+        
+        function invalidate_cache(obj, changed)
+            %% Clear the cached values depending on the changed properties
+            % -------------------------------------------------------------
+            % Syntax:
+            %   ScanParams.invalidate_cache(changed)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   changed (STR or CELL ARRAY of STR) - Optional - default is
+            %           all
+            %       The name of the properties that changed. Cached values
+            %       depending on them, directly or through another cached
+            %       value, are cleared (see CACHE_DEPENDENCIES)
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   Setters call this function. Call it without input if you
+            %   changed an AolParams value affecting the scan geometry
+            %   other than xy_z_norm_ratio (which is checked on access).
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera.
+            %--------------------------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            
+            if nargin < 2
+                obj.derived_cache = struct();
+                obj.cache_version = obj.cache_version + 1;
+                return
+            end
+            
+            %% Propagate through the dependency graph
+            stale       = cellstr(changed);
+            names       = fieldnames(obj.CACHE_DEPENDENCIES);
+            grown       = true;
+            while grown
+                grown   = false;
+                for idx = 1:numel(names)
+                    if ~ismember(names{idx}, stale) && any(ismember(obj.CACHE_DEPENDENCIES.(names{idx}), stale))
+                        stale{end + 1}  = names{idx}; %#ok<AGROW>
+                        grown           = true;
+                    end
+                end
+            end
+            
+            cleared     = intersect(fieldnames(obj.derived_cache), stale);
+            if ~isempty(cleared)
+                obj.derived_cache = rmfield(obj.derived_cache, cleared);
+                obj.cache_version = obj.cache_version + 1;
+            end
+        end
+        
+        function value = cached(obj, name, compute)
+            %% Return a cached value, or compute and cache it
+            % -------------------------------------------------------------
+            % Syntax:
+            %   value = ScanParams.cached(name, compute)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   name (STR)
+            %       A field of CACHE_DEPENDENCIES
+            %   compute (FUNCTION HANDLE)
+            %       Function computing the value, without input
+            % -------------------------------------------------------------
+            % Outputs:
+            %   value (ANY)
+            %       The cached or computed value
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   Values are also recomputed if the AolParams
+            %   xy_z_norm_ratio changed, as it is not a ScanParams
+            %   property.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera.
+            %--------------------------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            
+            aol = obj.aol_params_handle;
+            if isempty(aol)
+                key = [];
+            else
+                key = aol.xy_z_norm_ratio;
+            end
+            if isfield(obj.derived_cache, name) && isequal(obj.derived_cache.(name).key, key)
+                value = obj.derived_cache.(name).value;
+            else
+                value = compute();
+                obj.derived_cache.(name) = struct('value', {value}, 'key', key);
+            end
+        end
+        
         function [start, stop] = handle_image_start_stops(obj)
             %% Generate the normalized ramps depending on imaging mode
             % -------------------------------------------------------------
@@ -277,9 +440,6 @@ classdef ScanParams < handle
                 end
                 start = obj.start_norm_raw;
                 stop = obj.stop_norm_raw;
-                if size(obj.pockels_raw, 2) ~= size(obj.start_norm_raw, 2)
-                    obj.pockels_raw = []; % you have to set that again
-                end
             else
                 error('Scan mode not recognized')
             end
@@ -321,12 +481,14 @@ classdef ScanParams < handle
             %   These vectors describe patches in XY pixels. They are
             %   only valid for a specific acceptance angle and resolution.
             %   See demo_patch_generation() for some examples
+            %   For thousands of patches, compile_miniscan_patches() takes
+            %   the same arrays directly, without building boxes.
             % -------------------------------------------------------------
             % Author(s):
             %   Antoine Valera.
             %--------------------------------------------------------------
             % Revision Date:
-            %   06-10-2018
+            %   18-10-2026
 
             if any([size(corner,1),size(v1,1),size(v2,1),size(v3,1)] ~= 3)
                error('Input must be a 3xN matrix')
@@ -336,10 +498,7 @@ classdef ScanParams < handle
             end
 
             %% Now generate boxes
-            boxes = cell(1,size(corner,2));
-            for el = 1:size(corner,2)
-                boxes{el} = struct('corner', corner(:,el), 'v1', v1(:,el), 'v2', v2(:,el), 'v3', v3(:,el));
-            end
+            boxes = num2cell(struct('corner', num2cell(corner, 1), 'v1', num2cell(v1, 1), 'v2', num2cell(v2, 1), 'v3', num2cell(v3, 1)));
         end
         
         function mainscan_x_pixel_density = get.mainscan_x_pixel_density(obj)
@@ -405,6 +564,7 @@ classdef ScanParams < handle
                 end
             end
             obj.mainscan_x_pixel_density = mainscan_x_pixel_density;
+            obj.invalidate_cache('mainscan_x_pixel_density');
         end
 
         %% ================================================================
@@ -432,15 +592,7 @@ classdef ScanParams < handle
             % Revision Date:
             %   21-09-2018
 
-            if isempty(obj.start_norm)
-                error('You need at least 1 line in your drives')
-            end
-
-            if obj.imaging_mode == ImagingMode.Pointing
-                num_drives = size(obj.start_norm, 2)^2;
-            else
-                num_drives = size(obj.start_norm, 2);
-            end
+            num_drives = obj.cached('num_drives', @() obj.count_drives());
         end
 
         function num_voxels_per_ramp = get.voxels_for_ramp(obj)
@@ -579,17 +731,25 @@ classdef ScanParams < handle
             % Fixed length constraint is only checked once stop_norm_raw,
             % so you should set start_norm_raw first and stop_norm_raw
             % second
+            %   In functional and miniscan mode, pockels_raw is cleared if
+            % it no longer has one column per drive. You have to set it
+            % again.
             % -------------------------------------------------------------
             % Author(s):
             %   Geoffrey Evans, Boris Marin, Antoine Valera.
             %--------------------------------------------------------------
             % Revision Date:
-            %   23-09-2018
+            %   18-10-2026
 
             if ~isempty(obj.imaging_mode) && obj.imaging_mode ~= ImagingMode.Miniscan &&  ~all(size(start_norm_raw) == [3, 1])
                 error(['In Raster & Pointing imaging modes, start_norm_raw only controls offsets and must be of size (3 x 1)'])
             end
             obj.start_norm_raw = start_norm_raw;
+            obj.invalidate_cache('start_norm_raw');
+            if ~isempty(obj.imaging_mode) && (obj.imaging_mode == ImagingMode.Functional || obj.imaging_mode == ImagingMode.Miniscan) ...
+                    && ~isempty(obj.pockels_raw) && size(obj.pockels_raw, 2) ~= size(start_norm_raw, 2)
+                obj.pockels_raw = []; % you have to set that again
+            end
         end
 
         function set.stop_norm_raw(obj, stop_norm_raw)
@@ -625,6 +785,7 @@ classdef ScanParams < handle
                 obj.check_fixed_length_contraint(obj.start_norm_raw, stop_norm_raw);
             end
             obj.stop_norm_raw = stop_norm_raw;
+            obj.invalidate_cache('stop_norm_raw');
         end
 
         function centre = get.centre_norm(obj)
@@ -703,7 +864,8 @@ classdef ScanParams < handle
             % Revision Date:
             %   21-09-2018
 
-            [start, ~] = obj.handle_image_start_stops();
+            start_stop = obj.cached('start_stop', @() obj.start_stop_pair());
+            start = start_stop{1};
         end
 
         function stop = get.stop_norm(obj)
@@ -728,7 +890,8 @@ classdef ScanParams < handle
             % Revision Date:
             %   21-09-2018
 
-            [~, stop] = obj.handle_image_start_stops();
+            start_stop = obj.cached('start_stop', @() obj.start_stop_pair());
+            stop = start_stop{2};
         end
         
         function pixel_size_norm = get.pixel_size_norm(obj)
@@ -793,8 +956,8 @@ classdef ScanParams < handle
             %   29-09-2018
 
             if nargin == 1
-                start_norm = obj.start_norm;
-                stop_norm  = obj.stop_norm ;
+                cubic_norm_distance = obj.cached('cubic_norm_distance', @() obj.get_cubic_norm_distance(obj.start_norm, obj.stop_norm));
+                return
             end
             if size(start_norm,2) ~= size(stop_norm,2)
                 cubic_norm_distance = NaN;
@@ -925,6 +1088,8 @@ classdef ScanParams < handle
             %   ramp
             %   - A 4 x N value gives a specific pockel cell value to each
             %   ramp, for each AOD
+            %   - A PockelsLut gives each ramp the value of the depth of
+            %   its centre
             % -------------------------------------------------------------
             % Outputs:
             % -------------------------------------------------------------
@@ -933,13 +1098,22 @@ classdef ScanParams < handle
             %   If you are in miniscan mode, you must set start_norm_raw
             % and stop_norm_raw correctly first, since you want to match
             % pocel values to each ramp.
+            %   With a PockelsLut, depths are relative to the natural
+            % plane. Use PockelsLut.drive_levels with the stage position
+            % if the table uses stage coordinates.
             % -------------------------------------------------------------
             % Author(s):
             %   Geoffrey Evans, Boris Marin, Antoine Valera.
             %--------------------------------------------------------------
             % Revision Date:
-            %   21-09-2018
+            %   18-10-2026
 
+            if isa(pockel_values, 'PockelsLut')
+                if isempty(obj.aol_params_handle)
+                    error('A PockelsLut requires the AolParams of the scan, to convert Z into um')
+                end
+                pockel_values = pockel_values.drive_levels(obj, obj.aol_params_handle); % [4 x num_drives]
+            end
             if any(pockel_values(:) > 2) || any(pockel_values(:) < 0)
                 error('Pockel values must be between 0 and 2')
             end
@@ -1115,10 +1289,10 @@ classdef ScanParams < handle
             %   Geoffrey Evans, Boris Marin, Antoine Valera.
             %--------------------------------------------------------------
             % Revision Date:
-            %   30-09-2018
+            %   18-10-2026
 
             scan_time = obj.aol_params_handle.discretize(obj.voxel_time) .* obj.voxels_for_ramp;
-            if any(scan_time > 248e-6)
+            if any(scan_time > obj.MAX_SCAN_TIME)
                 error('scan time is too long for at least a one line. Max scan duration is 248us ')
             end
         end
@@ -1176,11 +1350,11 @@ classdef ScanParams < handle
             fps = obj.get_fps();
         end
 
-        function [fps, line_duration, overhead] = get_fps(obj, n_cycles, MC_scan_params, MC_rate)
+        function [fps, line_duration, overhead, t_line] = get_fps(obj, n_cycles, MC_scan_params, MC_rate)
             %% Get the expected frame per second (incl averages and MC)
             % -------------------------------------------------------------
             % Syntax:
-            %   [fps, line_duration, overhead] =
+            %   [fps, line_duration, overhead, t_line] =
             %         ScanParams.get_fps(averages, MC_scan_params, MC_rate)
             % -------------------------------------------------------------
             % Inputs:
@@ -1209,6 +1383,10 @@ classdef ScanParams < handle
             %       the overhead of movement correction on the total scan
             %       time expressed as a percentage. The final exact 
             %       overhead can vary by a tiny amount
+            %   t_line (1 x (num drives * averages) DOUBLE)
+            %       The time of the first pixel of each line, in s since
+            %       the start of the first cycle, including MC interrupts.
+            %       See register_from_mc_log
             % -------------------------------------------------------------
             % Extra Notes:
             %   With MC on, the exact overhead and cycle duration can be
@@ -1217,15 +1395,19 @@ classdef ScanParams < handle
             %   estimate uncertainty or MC scan duration, type
             %   [~,cycle_duration,~,~] = ,...
             %           Controller.mc_scan_params.get_fps(1)
+            %
+            %   The line schedule is computed by
+            %   ScanParams.line_schedule(), in a time independent of the
+            %   number of cycles.
             % -------------------------------------------------------------
             % Author(s):
             %   Antoine Valera.
             %--------------------------------------------------------------
             % Revision Date:
-            %   24-02-2019
+            %   18-10-2026
             %
             % See also: estimate_scan_frequency, get_frame_duration,
-            % ScanParams.fps
+            % ScanParams.fps, ScanParams.line_schedule
             if nargin < 2 || isempty(n_cycles)
                 n_cycles = 1;
             end
@@ -1238,7 +1420,6 @@ classdef ScanParams < handle
 
             % Main scan variables
             line_duration        = obj.full_time;
-            n_lines              = size(line_duration, 2);
             cycle_duration_noMC  = sum(line_duration, 2);
             line_duration        = line_duration(1,:);
             cycle_duration_noMC  = cycle_duration_noMC(1,:);
@@ -1254,62 +1435,9 @@ classdef ScanParams < handle
                 MC_rate = 0;
             end
 
-            %% Now calculate t of each linescan
-            t_line                      = NaN(1,n_lines*n_cycles);   % absolute t start for each line scan
-            abs_t_current_line          = 0;                    % current timepoint (within the loop)
-            elapsed_since_reset         = 0;                    % internal timing since last MC cycle (only valid if refcountresetenabled is true)
-            abs_t_reset                 = 0;                    % absolute time of last MC reset
-            interrupts_count            = 0;                    % count total number of MC (for overhead calculaion)
-            delta_SWAT = (obj.aol_params_handle.sampleswaitaftertrigger - obj.aol_params_handle.aod_fill)*5e-9;
-            n_lines_for_reset = 3;
-
-            for line_n = 0:((n_lines*n_cycles)-1)
-                %% Get duration for the current line (in case you have variable length)
-                in_cycle_line_nb        = mod(line_n, n_lines)+1;  % internal counter for variable length/duration
-                current_line_duration   = line_duration(in_cycle_line_nb);
-
-                %% Each imaging cycle starts with a MC cycle. We squeeze one here before the first line
-                if in_cycle_line_nb == 1
-                    [abs_t_current_line, interrupts_count, abs_t_reset, elapsed_since_reset] = insert_ref_scan_delay(delta_SWAT, abs_t_current_line, interrupts_count, MC_duration, 0);  
-
-                    %% For each start of cycle except the first one, t is reset when the first pixel is acquired
-                    extra_remaining_lines = n_lines_for_reset;
-                    current_intercycle_delta = 0;
-                end
-
-                %% Set current line time in the output (which is time of first pixel, so we add AOD fill)
-                t_line(line_n+1) = abs_t_current_line + obj.aol_params_handle.aod_fill * 5e-9;
-
-                %% Now if we are less than 2 linescan from the end we block any reset. it can wait
-                if in_cycle_line_nb > (n_lines-n_lines_for_reset-1) 
-                    no_reset = true;
-                else
-                    no_reset = false;
-                end
-
-                %% Now, if NEXT LINE pass the 2ms bar, we finish the current line, and the next one and one more.
-                previous_intercycle_delta = current_intercycle_delta;
-                current_intercycle_delta = mod((abs_t_current_line - abs_t_reset) + current_line_duration, MC_rate);
-                abs_t_current_line = abs_t_current_line + current_line_duration;
-
-                if extra_remaining_lines < n_lines_for_reset
-                    extra_remaining_lines = extra_remaining_lines - 1;
-                end
-
-                if current_intercycle_delta < previous_intercycle_delta && extra_remaining_lines == n_lines_for_reset
-                    extra_remaining_lines = n_lines_for_reset - 1;
-                end
-
-                if extra_remaining_lines == 0 %&& in_cycle_line_nb < n_lines
-                    [abs_t_current_line, interrupts_count, abs_t_reset, elapsed_since_reset] = insert_ref_scan_delay(delta_SWAT, abs_t_current_line, interrupts_count, MC_duration, current_line_duration);            
-                    current_intercycle_delta = 0;
-                    extra_remaining_lines = n_lines_for_reset;
-                end
-
-            end
-
-            %% End time of last line
-            total_duration = t_line(end) + line_duration(end) - obj.aol_params_handle.aod_fill * 5e-9; % (We remove a final aod_fill as t_line is 1st pixel time)
+            %% Now calculate t of each linescan (1st pixel time, so we add AOD fill)
+            [t_line, total_duration] = ScanParams.line_schedule(line_duration, n_cycles, MC_duration, MC_rate);
+            t_line = t_line + obj.aol_params_handle.aod_fill * 5e-9;
 
             %% Calculate corrected average cycle duration and overhead
             cycle_duration = total_duration / n_cycles;
@@ -1321,32 +1449,75 @@ classdef ScanParams < handle
             
             %% Get real mean fps
             fps = 1/cycle_duration;
+        end
 
-            function [abs_t_current_line, interrupts_count, abs_t_reset, elapsed_since_reset] = insert_ref_scan_delay(delta_SWAT, abs_t_current_line, interrupts_count, MC_duration, delay)
-                %% In this case, next line will be after MC interrupt
-                abs_t_MC_Start             = abs_t_current_line + delay; % MC starts after current line completion, unless it's a new cycle
-
-                %% If refcountresetenabled is true, we ignore the overshoot. First pixel acquired is our new 0
-
-
-                %% Now we define the time for the new MC cycle reset
-                if interrupts_count == 0
-                    %% The very first cycle t start begins with the MC cycle onset
-                    elapsed_since_reset = MC_duration + delta_SWAT*5e-9;   % For first cycle, we start at t = 0, so the first line happens after MC duration time + SWAT - aod fill
-                    abs_t_reset         = 0 ;%- delta_SWAT;%*5e-9;%; 
-                    MC_duration         = 0 ;%- delta_SWAT;%*5e-9;%%MC_duration + delta_SWAT*5e-9;  
-                else
-                    %% All the other cycles start when the first pixel is acquired, which is MC duration + 1 fill time
-                    elapsed_since_reset = 0;
-                    abs_t_reset         = abs_t_MC_Start;% %+ MC_duration; 
-                end
-
-                %% Set first imaging ramp t start after ref scan
-                abs_t_current_line = abs_t_MC_Start + MC_duration;  % next line starts after current line completion + MC duration
+        function timing_table = get_timing_table(obj, MC_scan_params, MC_rate)
+            %% Get a compact table of line, voxel and MC cycle timings
+            % -------------------------------------------------------------
+            % Syntax:
+            %   timing_table = ScanParams.get_timing_table(MC_scan_params,
+            %                                              MC_rate)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   MC_scan_params (ScanParams object) - Optional
+            %       If any, MC interruptions are included. See get_fps()
+            %   MC_rate (DOUBLE) - Optional - default is 2
+            %       in ms, the rate between 2 MC cycles. Set to 0 to
+            %       ignore MC
+            % -------------------------------------------------------------
+            % Outputs:
+            %   timing_table (STRUCT)
+            %       Timings of the first 2 cycles, in s since the first
+            %       cycle start. All the cycles after the first one are
+            %       identical, and cycle k > 1 is cycle 2 + (k - 2) * period
+            %       - line_start (2 x num_drives DOUBLE) : time of the
+            %         first pixel of each line, for cycles 1 and 2
+            %       - dwell (1 x num_drives DOUBLE) : voxel dwell time
+            %       - n_voxels (1 x num_drives INT) : voxels per line
+            %       - mc_start (1 x 2 CELL ARRAY of (1 x N) DOUBLE) : start
+            %         of the MC cycles interrupting cycles 1 and 2
+            %       - mc_duration (DOUBLE) : duration of each MC cycle
+            %       - period (DOUBLE) : duration of cycles 2 and more
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   The table is computed by Controller.timed_image() when the
+            %   recording starts and returned in timings_summary{3}, so that
+            %   recordings can be resampled without the ScanParams object.
+            %   Use ScanParams.voxel_timestamps() to expand it.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera.
+            %--------------------------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            %
+            % See also: ScanParams.get_fps, ScanParams.line_schedule,
+            %   ScanParams.voxel_timestamps
 
-                %% Increment interrupt count for overhead calulation
-                interrupts_count = interrupts_count + 1;
+            if nargin < 3 || isempty(MC_rate)
+                MC_rate = 2; % from controller.daq_fpga.MC_rate
             end
+            if nargin < 2 || isempty(MC_scan_params) || ~MC_rate
+                MC_duration = 0;
+                MC_rate     = 0;
+            else
+                MC_duration = 1/MC_scan_params.fps;
+                MC_rate     = MC_rate/1000;
+            end
+
+            %% Schedule of 3 cycles, to get the period of the repeated ones
+            line_duration   = obj.full_time(1,:);
+            n_lines         = numel(line_duration);
+            [t_line, ~, mc_start, mc_cycle] = ScanParams.line_schedule(line_duration, 3, MC_duration, MC_rate);
+            period          = t_line(2*n_lines + 1) - t_line(n_lines + 1);
+
+            timing_table    = struct(...
+                'line_start'    , reshape(t_line(1:2*n_lines), n_lines, 2)' + obj.aol_params_handle.aod_fill * 5e-9,...
+                'dwell'         , obj.aol_params_handle.discretize(obj.voxel_time) .* ones(1, n_lines),...
+                'n_voxels'      , obj.voxels_for_ramp .* ones(1, n_lines),...
+                'mc_start'      , {{mc_start(mc_cycle == 1), mc_start(mc_cycle == 2)}},...
+                'mc_duration'   , MC_duration,...
+                'period'        , period);
         end
 
         %% ================================================================
@@ -1449,6 +1620,25 @@ classdef ScanParams < handle
     end
     
     methods (Hidden)
+        function start_stop = start_stop_pair(obj)
+            %% handle_image_start_stops() outputs in a cell array, for caching
+            start_stop = cell(1, 2);
+            [start_stop{:}] = obj.handle_image_start_stops();
+        end
+        
+        function num_drives = count_drives(obj)
+            %% Uncached num_drives
+            if isempty(obj.start_norm)
+                error('You need at least 1 line in your drives')
+            end
+
+            if obj.imaging_mode == ImagingMode.Pointing
+                num_drives = size(obj.start_norm, 2)^2;
+            else
+                num_drives = size(obj.start_norm, 2);
+            end
+        end
+        
         function [start, stop] = generate_grid_diagonal(obj)
             %% Generate a single obj.mainscan_x_pixel_density ramp
             % from -1 to +1
@@ -1478,4 +1668,163 @@ classdef ScanParams < handle
             stop    = [stop_x(:)  start_y(:) start_z(:)]';
         end
     end
+
+    methods (Static)
+        function t_voxel = voxel_timestamps(timing_table, cycles)
+            %% Get the acquisition time of each voxel from a timing table
+            % -------------------------------------------------------------
+            % Syntax:
+            %   t_voxel = ScanParams.voxel_timestamps(timing_table, cycles)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   timing_table (STRUCT)
+            %       A table from ScanParams.get_timing_table()
+            %   cycles (1 x C INT) - Optional - default is 1
+            %       The cycles to expand (1 is the first cycle)
+            % -------------------------------------------------------------
+            % Outputs:
+            %   t_voxel (V x C DOUBLE)
+            %       The start of each voxel, in s since the first cycle
+            %       start, in the order of the recorded data (voxels of
+            %       line 1, then line 2...)
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   Voxel v of line l starts at line_start(l) + (v - 1) *
+            %   dwell(l).
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera.
+            %--------------------------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            %
+            % See also: ScanParams.get_timing_table
+
+            if nargin < 2 || isempty(cycles)
+                cycles = 1;
+            end
+
+            %% Voxel offsets within each line
+            n_voxels    = double(timing_table.n_voxels);
+            line_idx    = repelem(1:numel(n_voxels), n_voxels)';
+            first_voxel = cumsum([1, n_voxels(1:end-1)]);
+            offset      = ((1:sum(n_voxels))' - first_voxel(line_idx)') .* timing_table.dwell(line_idx)';
+
+            %% Line starts of each cycle
+            cycles      = cycles(:)';
+            line_start  = timing_table.line_start(2, :)' + (cycles - 2) * timing_table.period;
+            line_start(:, cycles == 1) = repmat(timing_table.line_start(1, :)', 1, sum(cycles == 1));
+            t_voxel     = line_start(line_idx, :) + offset;
+        end
+
+        function [t_line, total_duration, mc_start, mc_cycle] = line_schedule(line_duration, n_cycles, MC_duration, MC_rate)
+            %% Get the start time of each line, including MC interrupts
+            % -------------------------------------------------------------
+            % Syntax:
+            %   [t_line, total_duration, mc_start, mc_cycle] =
+            %       ScanParams.line_schedule(line_duration, n_cycles,
+            %                                MC_duration, MC_rate)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   line_duration (1 x num_drives DOUBLE)
+            %       The full time of each line (fill + scan), in s
+            %   n_cycles (INT) - Optional - default is 1
+            %       The number of imaging cycles
+            %   MC_duration (DOUBLE) - Optional - default is 0
+            %       The duration of a MC cycle, in s
+            %   MC_rate (DOUBLE) - Optional - default is 0
+            %       The interval between 2 MC cycles, in s. 0 for no MC
+            % -------------------------------------------------------------
+            % Outputs:
+            %   t_line (1 x (num_drives * n_cycles) DOUBLE)
+            %       The start time of each line, in s
+            %   total_duration (DOUBLE)
+            %       The end time of the last line, in s
+            %   mc_start (1 x N DOUBLE)
+            %       The start time of each MC cycle, in s. Each one lasts
+            %       MC_duration. The MC cycle preceding the first cycle is
+            %       not included, as t = 0 is the end of it.
+            %   mc_cycle (1 x N INT)
+            %       The imaging cycle of each MC cycle. The MC cycle
+            %       starting a cycle belongs to that cycle
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   Each cycle starts with a MC cycle. Within a cycle, when the
+            %   next line passes the MC_rate bar, 2 more lines are scanned
+            %   and a MC cycle is inserted after the following one. The
+            %   MC timer is reset at each cycle start, so all the cycles
+            %   after the first one have the same schedule. Only the first
+            %   2 cycles are simulated, and the others are translated
+            %   copies of the second one.
+            %
+            %   This is a static method, so it can be used on saved
+            %   timings, without a ScanParams or AolParams object.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera.
+            %--------------------------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            %
+            % See also: ScanParams.get_fps
+
+            if nargin < 2 || isempty(n_cycles)
+                n_cycles = 1;
+            end
+            if nargin < 3 || isempty(MC_duration)
+                MC_duration = 0;
+            end
+            if nargin < 4 || isempty(MC_rate)
+                MC_rate = 0;
+            end
+
+            %% First cycle starts at t = 0, without MC cycle duration
+            [t_line, t_end, mc_start] = schedule_cycle(0, 0);
+            mc_cycle            = ones(size(mc_start));
+
+            %% Following cycles are all identical
+            if n_cycles > 1
+                [t_next, t_end_next, mc_next] = schedule_cycle(t_end, MC_duration);
+                period          = t_end_next - t_end;
+                t_line          = [t_line, reshape(t_next' + (0:n_cycles - 2) * period, 1, [])];
+                mc_start        = [mc_start, reshape(mc_next' + (0:n_cycles - 2) * period, 1, [])];
+                mc_cycle        = [mc_cycle, repelem(2:n_cycles, numel(mc_next))];
+            end
+            total_duration      = t_line(end) + line_duration(end);
+
+            function [t_start, t, mc_start] = schedule_cycle(t, first_MC_duration)
+                %% Start of each line of a cycle beginning at t, end of the cycle, and MC cycles start
+                n_lines_for_reset       = 3;
+                t_start                 = NaN(1, numel(line_duration));
+                mc_start                = t(first_MC_duration > 0);
+                t_reset                 = t;
+                t                       = t + first_MC_duration;
+                extra_remaining_lines   = n_lines_for_reset;
+                current_intercycle_delta = 0;
+                for line = 1:numel(line_duration)
+                    t_start(line)       = t;
+
+                    %% Now, if NEXT LINE pass the MC_rate bar, we finish the current line, and the next one and one more.
+                    previous_intercycle_delta = current_intercycle_delta;
+                    current_intercycle_delta = mod((t - t_reset) + line_duration(line), MC_rate);
+                    t                   = t + line_duration(line);
+                    if extra_remaining_lines < n_lines_for_reset
+                        extra_remaining_lines = extra_remaining_lines - 1;
+                    end
+                    if current_intercycle_delta < previous_intercycle_delta && extra_remaining_lines == n_lines_for_reset
+                        extra_remaining_lines = n_lines_for_reset - 1;
+                    end
+
+                    %% MC cycle, after the current line completion
+                    if extra_remaining_lines == 0
+                        t_reset         = t + line_duration(line);
+                        t               = t_reset + MC_duration;
+                        mc_start(end + 1) = t_reset;
+                        current_intercycle_delta = 0;
+                        extra_remaining_lines = n_lines_for_reset;
+                    end
+                end
+            end
+        end
+    end
 end
@@ -64,6 +64,10 @@
 %                                           Z_values,
 %                                           rendering)
 %
+% * Look-up table of Pockel values for the current stack limits
+%   lut = StackAndTile.get_pockels_lut(interpolation_mode,
+%                                      pockels_start, pockels_stop)
+%
 % * Move to stack centre or return stack centre value        
 %   stack_center = XyzStage.move_to_stack_center(move_to_stack_center)
 % -------------------------------------------------------------------------
@@ -115,7 +119,8 @@
 % Revision Date:
 %   07-05-2020
 %
-% See also: XyzStage, stack_params, testing_StackAndTiles
+% See also: XyzStage, stack_params, testing_StackAndTiles, MosaicStitcher,
+%   PockelsLut
 
 
 classdef StackAndTiles < handle   
@@ -807,6 +812,49 @@ classdef StackAndTiles < handle
             end
         end
         
+        function lut = get_pockels_lut(this, interpolation_mode, pockels_start, pockels_stop)
+            %% Look-up table of Pockel values for the current stack limits
+            % -------------------------------------------------------------
+            % Syntax: 
+            %   lut = StackAndTiles.get_pockels_lut(interpolation_mode,
+            %                                       pockels_start,
+            %                                       pockels_stop)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   interpolation_mode (STR) any in {'linear', 'exponential'}
+            %       Interpolation method for pockel cells
+            %
+            %   pockels_start (FLOAT) value between 0 and 2
+            %       Voltage of Pockels for Z_start
+            %
+            %   pockels_stop (FLOAT) value between 0 and 2
+            %       voltage of Pockels for Z_stop
+            % -------------------------------------------------------------
+            % Outputs: 
+            %   lut (PockelsLut object)
+            %       Use lut.evaluate(Z_values) for any number of depths,
+            %       or lut.drive_levels() for each drive of a scan
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   Same relation as get_pockels_vs_Z_values, but values are
+            %   linearly interpolated instead of using the nearest sample
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            %---------------------------------------------
+            % Revision Date:
+            %   18-10-2026 
+            
+            if nargin < 2 || isempty(interpolation_mode)
+                interpolation_mode = 'linear'; 
+            end
+            if nargin < 4 || isempty(pockels_start) || isempty(pockels_stop)
+                pockels_start = 0;
+                pockels_stop = 0;
+            end
+            lut = PockelsLut(this.z_start, this.z_stop, pockels_start, pockels_stop, interpolation_mode);
+        end
+        
         function stack_center = move_to_stack_center(this, move_to_stack_center)
             %% Move to, or return the value of the z stack center
             % The center is defined as the mean between 
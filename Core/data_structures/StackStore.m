@@ -0,0 +1,434 @@
+%% Chunked, compressed on-disk storage of stacks and tiles
+%   A StackStore keeps a [X x Y x planes x channels x repeats] stack in a
+%   folder, with one file per (plane, channel, repeat) chunk. Planes are
+%   written as soon as they are acquired, so a stack never needs to fit in
+%   memory, and everything recorded before a crash is kept on disk. A
+%   running mean across repeats is updated on disk at each write, and
+%   planes can be read one at a time (see show_stack).
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = StackStore(folder, frame_size, num_planes, num_channels,
+%                     num_repeats, compression, filter)
+%   this = StackStore(folder)
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   folder (STR)
+%       The folder of the store. It is created if needed. If it is the
+%       only input, an existing store is opened.
+%
+%   frame_size ([1 x 2] INT)
+%       The size of each plane, [X, Y].
+%
+%   num_planes (INT)
+%       The number of planes.
+%
+%   num_channels (INT) - Optional - default is 2
+%       The number of channels.
+%
+%   num_repeats (INT) - Optional - default is 1
+%       The number of repeats. Set it to 0 to store the running mean only.
+%
+%   compression (STR) - Optional - any in {'deflate', 'none'} - default is
+%           'deflate'
+%       Lossless compression of each chunk.
+%
+%   filter (STR) - Optional - any in {'shuffle', 'delta', 'none'} -
+%           default is 'shuffle'
+%       Filter applied before compression. See Extra Notes.
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (StackStore object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Write all channels of one plane for one repeat, and update the mean
+%   StackStore.write(plane, repeat, data)
+%
+% * Read the mean across repeats of some planes and channels
+%   data = StackStore.read_mean(planes, channels)
+%
+% * Read individual repeats of some planes and channels
+%   data = StackStore.read_repeats(planes, channels, repeats)
+%
+% * Compress / decompress a chunk (static)
+%   bytes = StackStore.encode(data, compression, filter)
+%   data = StackStore.decode(bytes, compression, filter, n_values)
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Chunks are SINGLE [X x Y] frames. Before compression, 'shuffle' groups
+%   the n-th byte of all values together (like blosc/HDF5 shuffle), which
+%   puts the slowly varying exponent bytes side by side. 'delta'
+%   additionally stores the difference between consecutive values of each
+%   byte plane, which helps for smooth or integer valued images. Both are
+%   exactly reversible.
+%
+% * Compression uses the Java Deflater shipped with Matlab, at its fastest
+%   level. LZ4 or zstd are not available without extra libraries. Use
+%   'none' if the disk is faster than the compression.
+%
+% * The mean chunk of each (plane, channel) holds the running mean and the
+%   number of valid (non NaN) values of each pixel, so that read_mean is
+%   equivalent to nanmean across the written repeats. Writing the same
+%   repeat again (e.g. a plane redone in a dynamic stack) replaces it, and
+%   the previous frame is removed from the mean first. If num_repeats is
+%   0, repeats are not stored, so each write is added to the mean.
+%
+% * Chunks are written to a temporary file and then renamed, and the store
+%   description (store.mat) is updated after each plane. An interrupted
+%   stack can be reopened with StackStore(folder). Missing chunks are read
+%   as NaN.
+%
+% * For tiles, use one store (folder) per tile.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Store a 3 planes, 2 channels, 4 repeats stack
+%   store = StackStore('D:/stack_01', [512, 512], 3, 2, 4);
+%   for r = 1:4, for p = 1:3, store.write(p, r, c.single_record()); end, end
+%   stack = store.read_mean(); % [512 x 512 x 3 x 2]
+%
+% * Display a stack saved on disk, loading planes only when displayed
+%   show_stack(StackStore('D:/stack_01'));
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: stack_generic, stack_params, show_stack, StackAndTiles
+
+classdef StackStore < handle
+    properties
+        folder          = ''        ; % Folder containing store.mat and the chunks
+        frame_size      = [0, 0]    ; % [X, Y] size of each plane
+        num_planes      = 0         ; % Number of planes
+        num_channels    = 2         ; % Number of channels
+        num_repeats     = 1         ; % Number of stored repeats. 0 if only the mean is stored
+        compression     = 'deflate' ; % 'deflate' or 'none'
+        filter          = 'shuffle' ; % 'shuffle', 'delta' or 'none'
+        repeats_done    = []        ; % [num_planes x num_channels] INT. Number of repeats in each mean chunk
+    end
+
+    methods
+        function this = StackStore(folder, frame_size, num_planes, num_channels, num_repeats, compression, filter)
+            %% StackStore Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = StackStore(folder, frame_size, num_planes,
+            %                     num_channels, num_repeats, compression,
+            %                     filter)
+            %   this = StackStore(folder)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   See class description
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (StackStore object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            this.folder = char(folder);
+
+            %% Open an existing store
+            if nargin == 1
+                if ~isfile(fullfile(this.folder, 'store.mat'))
+                    error(['No stack store found in ', this.folder])
+                end
+                description = load(fullfile(this.folder, 'store.mat'));
+                for field = fieldnames(description)'
+                    this.(field{1}) = description.(field{1});
+                end
+                return
+            end
+
+            %% Create a new store
+            if nargin >= 4 && ~isempty(num_channels)
+                this.num_channels = num_channels;
+            end
+            if nargin >= 5 && ~isempty(num_repeats)
+                this.num_repeats = num_repeats;
+            end
+            if nargin >= 6 && ~isempty(compression)
+                this.compression = compression;
+            end
+            if nargin >= 7 && ~isempty(filter)
+                this.filter = filter;
+            end
+            if ~any(strcmp(this.compression, {'deflate', 'none'}))
+                error('StackStore compression must be ''deflate'' or ''none''')
+            elseif ~any(strcmp(this.filter, {'shuffle', 'delta', 'none'}))
+                error('StackStore filter must be ''shuffle'', ''delta'' or ''none''')
+            end
+            if isfile(fullfile(this.folder, 'store.mat'))
+                error([this.folder, ' already contains a stack store. Use StackStore(folder) to open it, or choose another folder'])
+            elseif ~isfolder(this.folder)
+                mkdir(this.folder);
+            end
+            this.frame_size     = frame_size(1:2);
+            this.num_planes     = num_planes;
+            this.repeats_done   = zeros(num_planes, this.num_channels);
+            this.save_description();
+        end
+
+        function write(this, plane, repeat, data)
+            %% Write all channels of one plane, and update the running mean
+            % -------------------------------------------------------------
+            % Syntax:
+            %   StackStore.write(plane, repeat, data)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   plane (INT)
+            %       The plane index
+            %
+            %   repeat (INT)
+            %       The repeat index. If this repeat was already
+            %       written, it is replaced. Ignored if num_repeats is 0
+            %
+            %   data ([X x Y x num_channels] or [X x Y x 1 x
+            %           num_channels] NUMERIC)
+            %       The plane, for all channels, as returned by
+            %       Controller.single_record
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            data = reshape(single(data), this.frame_size(1), this.frame_size(2), this.num_channels);
+            for channel = 1:this.num_channels
+                frame       = data(:, :, channel);
+                previous    = [];
+                if this.num_repeats
+                    name = this.chunk_name(plane, channel, repeat);
+                    if isfile(name)
+                        previous = this.read_chunk(name, 1); % repeat written again
+                    end
+                    this.write_chunk(name, frame);
+                end
+
+                %% Running nanmean, with the number of valid values per pixel
+                mean_and_count  = this.read_chunk(this.chunk_name(plane, channel), 2);
+                [avg, count]    = deal(mean_and_count(:, :, 1), mean_and_count(:, :, 2));
+                avg(isnan(avg)) = 0;
+                count(isnan(count)) = 0;
+                if ~isempty(previous) % remove the replaced frame from the mean
+                    old         = ~isnan(previous) & count > 0;
+                    count(old)  = count(old) - 1;
+                    avg(old)    = avg(old) + (avg(old) - previous(old)) ./ count(old);
+                    avg(~count) = 0;
+                end
+                valid           = ~isnan(frame);
+                count(valid)    = count(valid) + 1;
+                avg(valid)      = avg(valid) + (frame(valid) - avg(valid)) ./ count(valid);
+                avg(~count)     = NaN;
+                this.write_chunk(this.chunk_name(plane, channel), cat(3, avg, count));
+                if isempty(previous)
+                    this.repeats_done(plane, channel) = this.repeats_done(plane, channel) + 1;
+                end
+            end
+            this.save_description();
+        end
+
+        function data = read_mean(this, planes, channels)
+            %% Read the mean across repeats
+            % -------------------------------------------------------------
+            % Syntax:
+            %   data = StackStore.read_mean(planes, channels)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   planes ([1 x P] INT) - Optional - default is all planes
+            %
+            %   channels ([1 x C] INT) - Optional - default is all
+            %           channels
+            % -------------------------------------------------------------
+            % Outputs:
+            %   data ([X x Y x P x C] SINGLE)
+            %       Mean of the written repeats. NaN for planes that were
+            %       never written.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 2 || isempty(planes)
+                planes = 1:this.num_planes;
+            end
+            if nargin < 3 || isempty(channels)
+                channels = 1:this.num_channels;
+            end
+            data = NaN(this.frame_size(1), this.frame_size(2), numel(planes), numel(channels), 'single');
+            for p = 1:numel(planes)
+                for c = 1:numel(channels)
+                    mean_and_count = this.read_chunk(this.chunk_name(planes(p), channels(c)), 2);
+                    data(:, :, p, c) = mean_and_count(:, :, 1);
+                end
+            end
+        end
+
+        function data = read_repeats(this, planes, channels, repeats)
+            %% Read individual repeats
+            % -------------------------------------------------------------
+            % Syntax:
+            %   data = StackStore.read_repeats(planes, channels, repeats)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   planes ([1 x P] INT) - Optional - default is all planes
+            %
+            %   channels ([1 x C] INT) - Optional - default is all
+            %           channels
+            %
+            %   repeats ([1 x R] INT) - Optional - default is all repeats
+            % -------------------------------------------------------------
+            % Outputs:
+            %   data ([X x Y x P x C x R] SINGLE)
+            %       NaN for chunks that were never written.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if ~this.num_repeats
+                error('This stack store only contains the mean across repeats')
+            end
+            if nargin < 2 || isempty(planes)
+                planes = 1:this.num_planes;
+            end
+            if nargin < 3 || isempty(channels)
+                channels = 1:this.num_channels;
+            end
+            if nargin < 4 || isempty(repeats)
+                repeats = 1:this.num_repeats;
+            end
+            data = NaN(this.frame_size(1), this.frame_size(2), numel(planes), numel(channels), numel(repeats), 'single');
+            for p = 1:numel(planes)
+                for c = 1:numel(channels)
+                    for r = 1:numel(repeats)
+                        data(:, :, p, c, r) = this.read_chunk(this.chunk_name(planes(p), channels(c), repeats(r)), 1);
+                    end
+                end
+            end
+        end
+    end
+
+    methods (Access = private)
+        function name = chunk_name(this, plane, channel, repeat)
+            %% Chunk file path. Without repeat, the mean chunk
+            if nargin < 4
+                name = fullfile(this.folder, sprintf('p%05d_c%d_mean.chunk', plane, channel));
+            else
+                name = fullfile(this.folder, sprintf('p%05d_c%d_r%04d.chunk', plane, channel, repeat));
+            end
+        end
+
+        function write_chunk(this, name, data)
+            %% Write a chunk through a temporary file, so it is never partially written
+            fid = fopen([name, '.tmp'], 'w');
+            if fid < 0
+                error(['Unable to write ', name])
+            end
+            fwrite(fid, StackStore.encode(data, this.compression, this.filter), 'uint8');
+            fclose(fid);
+            movefile([name, '.tmp'], name, 'f');
+        end
+
+        function data = read_chunk(this, name, n_frames)
+            %% Read a chunk of n_frames [X x Y] frames. NaN if missing
+            n_values = prod(this.frame_size) * n_frames;
+            if isfile(name)
+                fid     = fopen(name, 'r');
+                bytes   = fread(fid, Inf, 'uint8=>uint8');
+                fclose(fid);
+                data    = StackStore.decode(bytes, this.compression, this.filter, n_values);
+            else
+                data    = NaN(n_values, 1, 'single');
+            end
+            data = reshape(data, this.frame_size(1), this.frame_size(2), n_frames);
+        end
+
+        function save_description(this)
+            %% Update store.mat
+            description = struct('frame_size'  , this.frame_size  , 'num_planes'   , this.num_planes,...
+                                 'num_channels', this.num_channels, 'num_repeats'  , this.num_repeats,...
+                                 'compression' , this.compression , 'filter'       , this.filter,...
+                                 'repeats_done', this.repeats_done);
+            save(fullfile(this.folder, 'store.mat'), '-struct', 'description');
+        end
+    end
+
+    methods (Static)
+        function bytes = encode(data, compression, filter)
+            %% Filter and compress SINGLE values into a [N x 1] UINT8 array
+            bytes = typecast(reshape(single(data), [], 1), 'uint8');
+            if ~strcmp(filter, 'none')
+                bytes = reshape(bytes, 4, [])'; % one column per byte plane
+                if strcmp(filter, 'delta')
+                    bytes(2:end, :) = uint8(mod(diff(int16(bytes), 1, 1), 256));
+                end
+                bytes = bytes(:);
+            end
+            if strcmp(compression, 'deflate')
+                stream  = java.io.ByteArrayOutputStream();
+                deflater = java.util.zip.DeflaterOutputStream(stream, java.util.zip.Deflater(1)); % 1 is the fastest level
+                deflater.write(typecast(bytes, 'int8'), 0, numel(bytes));
+                deflater.close();
+                bytes   = typecast(stream.toByteArray(), 'uint8');
+            end
+        end
+
+        function data = decode(bytes, compression, filter, n_values)
+            %% Decompress and unfilter a [N x 1] UINT8 array into SINGLE values
+            if strcmp(compression, 'deflate')
+                stream  = java.util.zip.InflaterInputStream(java.io.ByteArrayInputStream(typecast(bytes(:), 'int8')));
+                bytes   = typecast(org.apache.commons.io.IOUtils.toByteArray(stream), 'uint8');
+                stream.close();
+            end
+            if numel(bytes) ~= 4 * n_values
+                error('Corrupted stack store chunk (%d bytes instead of %d)', numel(bytes), 4 * n_values)
+            end
+            if ~strcmp(filter, 'none')
+                bytes = reshape(bytes, [], 4);
+                if strcmp(filter, 'delta')
+                    bytes = uint8(mod(cumsum(double(bytes), 1), 256));
+                end
+                bytes = reshape(bytes', [], 1);
+            end
+            data = typecast(bytes(:), 'single');
+        end
+    end
+end
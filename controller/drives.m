@@ -26,6 +26,10 @@
 % * Send new main drives to the controller. Stop any running scan
 %   Controller.send_drives(setup_viewer, nostop, pockel_voltages) 
 %
+% * Calculate drives and timings without sending them
+%   [xy_records, drive_coeffs, timing_table] = 
+%                   Controller.precalculate_drives(pockel_voltages) 
+%
 % * Set/Reset a specific scan mode/resolution/FOV size
 %   Controller.reset_frame_and_send(imaging_mode, non_default_resolution, 
 %                               ... non_default_aa, non_default_dwell_time)
@@ -34,6 +38,11 @@
 %   Controller.restore_ref_drives()
 % -------------------------------------------------------------------------
 % Extra Notes:
+% * Controller.timing_table is updated every time drives are sent, and
+%   again by timed_image when the recording starts, as the MC state may
+%   have changed in between. It holds the line, voxel and MC cycle timings
+%   of the current drives (see ScanParams.get_timing_table) and is
+%   returned with each timed_image recording.
 % -------------------------------------------------------------------------
 % Examples:
 % -------------------------------------------------------------------------
@@ -69,6 +78,7 @@
 
 classdef drives < handle % superclass of Controller
     properties
+        timing_table = []   ; % Timings of the current drives. See ScanParams.get_timing_table
     end
 
     methods        
@@ -235,12 +245,16 @@ classdef drives < handle % superclass of Controller
             %   If you plan to have variable length, you must set
             %   ScanParams.fixed_len to false BEFORE calling the function.
             %   See demo_patch_generation() for some examples
+            %
+            %   Patches are converted into lines by
+            %   compile_miniscan_patches(), which you can also call
+            %   directly with arrays of corners and vectors.
             % -------------------------------------------------------------
             % Author(s):
             %   Antoine Valera. 
             %---------------------------------------------
             % Revision Date:
-            %   29-09-2018
+            %   18-10-2026
             
             if nargin < 3 || isempty(non_default_pockel_voltages)
                 non_default_pockel_voltages = this.pockels.on_value;
@@ -257,34 +271,27 @@ classdef drives < handle % superclass of Controller
                 forced_res = repmat(forced_res, 1, numel(patches));                
             end
             
+            if isempty(patches)
+                error('set_miniscans requires at least one patch')
+            end
+            
             this.scan_params.imaging_mode = ImagingMode.Miniscan;
-            start_norm_raw = []; stop_norm_raw  = [];            
-            for el = 1:numel(patches)
-                corner = patches{el}.corner; v1 = patches{el}.v1; v2 = patches{el}.v2;% v3 = planes{el}.v3;
-                corner(3) = corner(3) + (z_offset_um / this.aol_params.get_pixel_size) / this.aol_params.xy_z_norm_ratio; % convert Z um offset to XY pixels
-                if ~isempty(forced_res) && size(forced_res, 1) == 2 && forced_res(2,el)
-                    nlines = forced_res(2,el); % manually set nlines for this patch
-                elseif any(v2) || (size(forced_res, 1) == 2 && ~forced_res(2,el))
-                    nlines = norm(v2); % auto set nlines for this patch
-                else
-                    nlines = 1; % adjust for linescan
-                end
-                starts = [ linspace(corner(1),      corner(1)+v2(1)      ,nlines) ;... %X-Y-Z Start of each line
-                           linspace(corner(2),      corner(2)+v2(2)      ,nlines) ;...
-                           linspace(corner(3),      corner(3)+v2(3)      ,nlines) ];
-                stops =  [ linspace(corner(1)+v1(1),corner(1)+v1(1)+v2(1),nlines) ;... %X-Y-Z Stop  of each line
-                           linspace(corner(2)+v1(2),corner(2)+v1(2)+v2(2),nlines) ;...
-                           linspace(corner(3)+v1(3),corner(3)+v1(3)+v2(3),nlines) ];
-                start_norm_raw = [start_norm_raw, this.aol_params.convert_xyz_pixels_to_norm(starts)];
-                stop_norm_raw  = [stop_norm_raw , this.aol_params.convert_xyz_pixels_to_norm(stops )];
+            patches = [patches{:}];
+            corner  = [patches.corner];
+            corner(3,:) = corner(3,:) + (z_offset_um / this.aol_params.get_pixel_size) / this.aol_params.xy_z_norm_ratio; % convert Z um offset to XY pixels
+            if ~isempty(forced_res) && size(forced_res, 1) == 2
+                nlines = forced_res(2,:); % manually set nlines for each patch. 0 is auto
+            else
+                nlines = []; % auto set nlines, or 1 for linescans
             end
+            [start_norm_raw, stop_norm_raw] = compile_miniscan_patches(this.aol_params.get_transform(this.scan_params.acceptance_angle, this.scan_params.mainscan_x_pixel_density), corner, [patches.v1], [patches.v2], nlines);
             
             %% Don't forget to adjust fixed_len/fixed_res in advance
             this.scan_params.start_norm_raw = start_norm_raw;
             this.scan_params.stop_norm_raw  = stop_norm_raw ;
             
-            if ~isempty(forced_res) && forced_res(1,el)
-                this.scan_params.voxels_for_ramp = forced_res(1,el)     ; %% QQ Think of a way to get that behaviour automatically
+            if ~isempty(forced_res) && forced_res(1,end)
+                this.scan_params.voxels_for_ramp = forced_res(1,end)    ; %% QQ Think of a way to get that behaviour automatically
                 this.scan_params.pockels_raw     = this.pockels.on_value;
             end
             this.send_drives(true, non_default_pockel_voltages);
@@ -369,6 +376,7 @@ classdef drives < handle % superclass of Controller
             end
             
             this.synth_fpga.load(this.aol_params, this.scan_params, false, this.scan_params.mainscan_x_pixel_density, this.scan_params.acceptance_angle, this.daq_fpga.z_pixel_size_um, pockel_voltages, precalc_drives, precalc_drive_coeffs); % send NON MC drives. for mc drives, see Controller.mouvement_correction
+            this.timing_table = this.get_drives_timing_table();
             %this.pockels.prepare_ramp(this.scan_params, this.pockels.on_value, this.aol_params.fill_time * 1e9, this.frame_cycles);
             
             %% Create a new viewer (do that when you change viewer type or resolution)
@@ -377,11 +385,12 @@ classdef drives < handle % superclass of Controller
             end
         end
         
-        function [xy_records, drive_coeffs] = precalculate_drives(this, pockel_voltages)
+        function [xy_records, drive_coeffs, timing_table] = precalculate_drives(this, pockel_voltages)
             %% Send new main drives to the controller. Stop any running scan
             % -------------------------------------------------------------
             % Syntax: 
-            %   Controller.precalculate_drives(pockel_voltages) 
+            %   [xy_records, drive_coeffs, timing_table] = 
+            %               Controller.precalculate_drives(pockel_voltages) 
             % -------------------------------------------------------------
             % Inputs:
             %  pockel_voltages(SCALAR OR (1 x N) or (4 x N DOUBLE MATRIX)) 
@@ -396,6 +405,9 @@ classdef drives < handle % superclass of Controller
             %       loading.
             %  drive_coeffs(drive_coeffs object) 
             %       The drivers coefficient.
+            %  timing_table(STRUCT) 
+            %       The line, voxel and MC cycle timings of these drives.
+            %       See ScanParams.get_timing_table
             % -------------------------------------------------------------
             % Extra Notes:
             %   This will calculate but not send the drives. You can
@@ -414,6 +426,32 @@ classdef drives < handle % superclass of Controller
 
             %% PreCalculate but don't send new drives
             [xy_records, drive_coeffs] = this.synth_fpga.load(this.aol_params, this.scan_params, false, this.scan_params.num_drives, this.scan_params.acceptance_angle, this.daq_fpga.z_pixel_size_um, pockel_voltages);
+            if nargout > 2
+                timing_table = this.get_drives_timing_table();
+            end
+        end
+        
+        function timing_table = get_drives_timing_table(this)
+            %% Line, voxel and MC timings of the current scan_params
+            % -------------------------------------------------------------
+            % Syntax: 
+            %   timing_table = Controller.get_drives_timing_table() 
+            % -------------------------------------------------------------
+            % Outputs: 
+            %  timing_table(STRUCT) 
+            %       See ScanParams.get_timing_table. MC interruptions are
+            %       included if movement correction is enabled and the MC
+            %       drives were sent, as in set_variable_params
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            %---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            
+            mc_is_ready_and_wanted = this.daq_fpga.use_movement_correction && this.daq_fpga.is_ready_to_correct;
+            MC_rate = double(this.daq_fpga.MC_rate) * double(mc_is_ready_and_wanted);
+            timing_table = this.scan_params.get_timing_table(this.mc_scan_params, MC_rate);
         end
         
         function reset_frame_and_send(this, imaging_mode, non_default_resolution, non_default_aa, non_default_dwell_time)
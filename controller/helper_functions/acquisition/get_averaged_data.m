@@ -111,6 +111,14 @@ function averaged_data = get_averaged_data(controller, averages, plot, init, reu
             colormap('gray'); axis image; hold on;
             subplot(1,2,2); imagesc(averaged_data(:,:,2)); hold on; 
             colormap('gray'); axis image;
+        else
+            %% Variable size miniscans, display patches as a mosaic
+            mosaic = ScanLayout(controller.scan_params).to_mosaic(reshape(averaged_data, [], 2));
+            figure(); hold on;
+            subplot(1,2,1); imagesc(mosaic(:,:,1,1)); hold on;
+            colormap('gray'); axis image; hold on;
+            subplot(1,2,2); imagesc(mosaic(:,:,1,2)); hold on; 
+            colormap('gray'); axis image;
         end
     end
 
@@ -51,6 +51,8 @@
 %                                   This is the real acquisition duration
 % -------------------------------------------------------------------------
 % Extra Notes:
+%   If parameters.reduction is not 'none', each cell of all_data only
+%   contains one (reduced) cycle, in SINGLE precision.
 % -------------------------------------------------------------------------
 % Examples:
 % -------------------------------------------------------------------------
@@ -109,17 +111,28 @@ function [all_data, parameters, stop_image_timer, number_of_cycles, duration] =
     %% Estimate number of cycles
     [number_of_cycles, ~, number_of_lines, number_of_points, line_length, duration] = estimate_points(controller, parameters, ~parameters.number_of_cycles);
     all_data = cell(parameters.repeats, 1); % each repeat is stored in a seperate cell.
+    online_reduction = ~strcmp(parameters.reduction, 'none');
+    if online_reduction
+        number_of_points = sum(line_length); % Cycles are reduced as they come, so each repeat returns a single cycle
+    end
     for r = 1:parameters.repeats
-        if controller.online       
+        if controller.online && online_reduction
+            all_data{r} = zeros(number_of_points, 2, 'single');
+        elseif controller.online       
             all_data{r} = zeros(number_of_points, 2, 'uint16');
         else
             all_data{r} = uint16(randi([0,2^16-1], number_of_points, 2)); % random integer noise
         end
     end
 
-    %% Generate viewer at first use
-    if ~parameters.reuse_viewer
-        controller.viewer = DataHolder([ones(1,number_of_lines)', line_length'], number_of_cycles); % Else the viewer is just reset when you start imaging
+    %% Generate viewer at first use, or if the previous one does not match
+    holder_size = [ones(1,number_of_lines)', line_length'];
+    reusable = parameters.reuse_viewer && isa(controller.viewer, 'DataHolder')...
+               && strcmp(controller.viewer.reduction_method, parameters.reduction)...
+               && isequal(controller.viewer.data_size, holder_size)...
+               && controller.viewer.repeats == number_of_cycles;
+    if ~reusable
+        controller.viewer = DataHolder(holder_size, number_of_cycles, parameters.reduction); % Else the viewer is just reset when you start imaging
         
         %% Just in case there was some remaining encoder stuff, delete them
         if controller.daq_fpga.capi.Session && ~isempty(controller.encoder) && isfield(controller.encoder, 'active') && controller.encoder.active && controller.encoder.trigger.use_trigger%% True, except in simulation mode
@@ -141,11 +154,15 @@ function [all_data, parameters, stop_image_timer, number_of_cycles, duration] =
    
     %% If you do MC logging, prepare MC viewer
     if parameters.monitor_MC
-        controller.rig_params.bg_mc_monitoring = MCViewer(false,['timed_image_repeat_',num2str(1, '%03d')]);
+        controller.set_mc_monitoring(MCViewer(false,['timed_image_repeat_',num2str(1, '%03d')]));
     end
 
     %% If pause between records is short, or records are long, data is dumped on HD and processed at the end of the recording
-    if ~parameters.no_interrupt && (parameters.duration > 10 || parameters.pause < 1 || parameters.repeats > 10) || parameters.dump_data
+    % With online reduction, data is never dumped since only one cycle is
+    % held in memory
+    if online_reduction
+        parameters.dump_data = false;
+    elseif ~parameters.no_interrupt && (parameters.duration > 10 || parameters.pause < 1 || parameters.repeats > 10) || parameters.dump_data
         parameters.dump_data = true;
         controller.daq_fpga.dump_data = true;
     end 
@@ -81,7 +81,10 @@ function all_data = push_data_to_trial_holder(controller, all_data, trial)
         controller.viewer.data1 = controller.viewer.data1(1:size(all_data{1}, 1));
     end
 
-    if ~controller.daq_fpga.dump_data && isnumeric(controller.frame_cycles)
+    if isprop(controller.viewer, 'reduction_method') && ~strcmp(controller.viewer.reduction_method, 'none')
+        %% For when cycles were reduced online
+        all_data{trial} = controller.viewer.get_reduced_data();
+    elseif ~controller.daq_fpga.dump_data && isnumeric(controller.frame_cycles)
         %% For when you don't use a timer
         all_data{trial}(:,1) = controller.viewer.data0;
         all_data{trial}(:,2) = controller.viewer.data1;
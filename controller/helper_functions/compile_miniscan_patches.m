@@ -0,0 +1,197 @@
+%% Convert arrays of patches into miniscan ramps, in one vectorised pass
+% Patches (points, lines or planes) described by a corner and two vectors
+% in cubic voxels, as in ScanParams.generate_miniscan_boxes, are
+% subdivided into lines and converted to the start_norm_raw, stop_norm_raw,
+% voxels_for_ramp and pockels_raw values of a miniscan. All patches are
+% processed at once, so that thousands of patches take a few milliseconds.
+%
+% -------------------------------------------------------------------------
+% Syntax:
+% [start_norm_raw, stop_norm_raw, voxels_for_ramp, pockels, patch_idx] =
+%       compile_miniscan_patches(transform, corner, v1, v2, n_lines,
+%                                rotation, pockels)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   transform(AolTransform object):
+%                                   Conversion from cubic voxels to
+%                                   normalised units, as given by
+%                                   AolParams.get_transform
+%
+%   corner([3 X N] FLOAT):
+%                                   X-Y-Z location, in XY cubic voxels, of
+%                                   the corner of each patch
+%
+%   v1([3 X N] FLOAT):
+%                                   Scanning direction of each line, in XY
+%                                   cubic voxels. [0;0;0] for points
+%
+%   v2([3 X N] FLOAT):
+%                                   Second vector of each patch plane, in
+%                                   XY cubic voxels. [0;0;0] for lines
+%
+%   n_lines([1 X N] INT or INT) - Optional - Default is []:
+%                                   Number of lines of each patch. 0 or []
+%                                   uses one line per voxel along v2, or a
+%                                   single line if v2 is [0;0;0]
+%
+%   rotation([3 X 3] or [3 X 3 X N] FLOAT) - Optional - Default is []:
+%                                   Rotation matrix applied to v1 and v2
+%                                   of all patches, or of each patch. Each
+%                                   patch rotates around its corner
+%
+%   pockels(FLOAT, [1 X N] or [4 X N] FLOAT, or PockelsLut object)
+%           - Optional - Default is []:
+%                                   Pockel value of all patches, of each
+%                                   patch, or of each patch for each AOD.
+%                                   With a PockelsLut, the value of each
+%                                   line is set from the depth of its
+%                                   centre
+%
+% -------------------------------------------------------------------------
+% Outputs:
+%   start_norm_raw([3 X L] FLOAT) :
+%                                   Normalised start point of each line
+%
+%   stop_norm_raw([3 X L] FLOAT) :
+%                                   Normalised stop point of each line
+%
+%   voxels_for_ramp([1 X L] INT) :
+%                                   Number of voxels of each line, as
+%                                   ScanParams.voxels_for_ramp would
+%                                   estimate it
+%
+%   pockels([4 X L] FLOAT) :
+%                                   Pockel value of each line for each
+%                                   AOD, or [] if no pockels input was
+%                                   passed
+%
+%   patch_idx([1 X L] INT) :
+%                                   Patch of each line
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Lines are generated as in Controller.set_miniscans: line starts are
+%   evenly spaced from corner to corner + v2, and a single line patch is
+%   set at corner + v2.
+%
+% * Patch rotation is independent from ScanParams.angles, which still
+%   rotates the whole scan around the FOV centre when drives are computed.
+%
+% * v3 (volumes) is not supported, as in Controller.set_miniscans. Split
+%   volumes into planes first.
+%
+% * Outputs can be passed directly to ScanParams in miniscan mode. Set
+%   ScanParams.fixed_len and ScanParams.fixed_res to false first if the
+%   patches have different sizes.
+% -------------------------------------------------------------------------
+% Examples:
+% * Compile 10000 horizontal 10 x 10 patches at random locations
+%   t = c.aol_params.get_transform();
+%   n = 10000;
+%   corner = [randi(500, 2, n); zeros(1, n)];
+%   [start, stop, res] = compile_miniscan_patches(t, corner, repmat([10;0;0], 1, n), repmat([0;10;0], 1, n));
+%
+% * Same patches, each rotated by 45 degrees around Z
+%   [start, stop, res] = compile_miniscan_patches(t, corner, repmat([10;0;0], 1, n), repmat([0;10;0], 1, n), [], rotz(45));
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: Controller.set_miniscans, ScanParams.generate_miniscan_boxes,
+%   AolTransform, PockelsLut, benchmark_patch_compiler
+
+function [start_norm_raw, stop_norm_raw, voxels_for_ramp, pockels, patch_idx] = compile_miniscan_patches(transform, corner, v1, v2, n_lines, rotation, pockels)
+    if any([size(corner,1),size(v1,1),size(v2,1)] ~= 3)
+       error('Input must be a 3xN matrix')
+    end
+    n_patches = size(corner, 2);
+    if any([size(v1,2),size(v2,2)] ~= n_patches)
+       error('all inputs must have the same size')
+    end
+    if nargin < 5 || isempty(n_lines)
+        n_lines = 0;
+    end
+    if nargin < 6
+        rotation = [];
+    end
+    if nargin < 7
+        pockels = [];
+    end
+
+    %% Rotate each patch around its corner
+    if ~isempty(rotation)
+        [v1, v2] = deal(rotate_vectors(rotation, v1), rotate_vectors(rotation, v2));
+    end
+
+    %% Number of lines of each patch
+    n_lines = round(n_lines(:)' .* ones(1, n_patches));
+    auto    = n_lines <= 0;
+    n_lines(auto) = max(floor(vecnorm(v2(:, auto))), 1); % one line per voxel, as in linspace(a, b, norm(v2))
+
+    %% Expand patches into lines
+    patch_idx   = repelem(1:n_patches, n_lines);
+    first_line  = cumsum([1, n_lines(1:end-1)]);
+    line_in_patch = (1:numel(patch_idx)) - first_line(patch_idx); % 0-based
+    steps       = n_lines(patch_idx) - 1;
+    frac        = line_in_patch ./ max(steps, 1);
+    frac(steps == 0) = 1; % linspace(a, b, 1) returns b
+    starts      = corner(:, patch_idx) + v2(:, patch_idx) .* frac;
+    stops       = starts + v1(:, patch_idx);
+
+    %% Convert to norm
+    start_norm_raw  = transform.pixels_to_norm(starts);
+    stop_norm_raw   = transform.pixels_to_norm(stops);
+
+    %% One voxel per cubic voxel along v1, as in ScanParams.voxels_for_ramp
+    voxels_for_ramp = max(round(vecnorm(v1)), 1);
+    voxels_for_ramp = voxels_for_ramp(patch_idx);
+
+    %% Pockels value of each line
+    if isempty(pockels)
+        pockels = [];
+    elseif isa(pockels, 'PockelsLut')
+        centre_um   = transform.norm_to_um((start_norm_raw + stop_norm_raw) / 2);
+        pockels     = repmat(pockels.evaluate(centre_um(3, :)), 4, 1);
+    elseif numel(pockels) == 1
+        pockels     = repmat(pockels, 4, numel(patch_idx));
+    elseif size(pockels, 2) == n_patches && any(size(pockels, 1) == [1, 4])
+        pockels     = repmat(pockels(:, patch_idx), 5 - size(pockels, 1), 1);
+    else
+        error('Pockel values must be either a unique value or an array of size (1 x num_patches) or (4 x num_patches)')
+    end
+end
+
+function v = rotate_vectors(rotation, v)
+    %% Apply one rotation matrix to all vectors, or one per vector
+    if ismatrix(rotation)
+        v = rotation * v;
+    elseif size(rotation, 3) == size(v, 2)
+        v = reshape(sum(rotation .* permute(v, [3, 1, 2]), 2), 3, []);
+    else
+        error('rotation must be a 3x3 matrix or a 3x3xN array')
+    end
+end
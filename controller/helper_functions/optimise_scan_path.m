@@ -0,0 +1,277 @@
+%% Group sparse 3D points into ramps to reduce the AOL fill overhead
+% In functional mode, each point is a drive, and each drive pays the AOD
+% fill time. Points that are nearly collinear can be scanned with a single
+% ramp instead, paying the fill time once plus one dwell time per voxel.
+% This function searches for the grouping minimising the cycle duration,
+% using several randomised greedy searches run in parallel, and returns
+% the corresponding miniscan drives.
+%
+% -------------------------------------------------------------------------
+% Syntax:
+% [start_norm_raw, stop_norm_raw, voxels_for_ramp, point_map, report] =
+%       optimise_scan_path(points_norm, scan_params, tolerance_px,
+%                          n_restarts, max_workers, silent)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   points_norm([3 X N] FLOAT):
+%                                   Normalised X-Y-Z location of each
+%                                   target point, as in a functional
+%                                   scan_params.start_norm_raw
+%
+%   scan_params(ScanParams object) - Optional - Default is current
+%           Controller.scan_params:
+%                                   Provides the acceptance angle, the
+%                                   resolution, the dwell time and the
+%                                   AolParams used for the timing model
+%
+%   tolerance_px(FLOAT) - Optional - Default is 0.5:
+%                                   Maximal distance, in XY cubic voxels,
+%                                   between a point and the ramp scanning
+%                                   it, and between the point and its
+%                                   voxel along the ramp
+%
+%   n_restarts(INT) - Optional - Default is 16:
+%                                   Number of greedy searches. The first
+%                                   one uses the input order, the next ones
+%                                   a random order. The best one is kept
+%
+%   max_workers(INT) - Optional - Default is the size of the open pool:
+%                                   Maximal number of parallel workers.
+%                                   0 runs the searches on the client. No
+%                                   pool is started by default
+%
+%   silent(BOOL) - Optional - Default is false:
+%                                   If true, the gain is not printed
+%
+% -------------------------------------------------------------------------
+% Outputs:
+%   start_norm_raw([3 X R] FLOAT) :
+%                                   Normalised start point of each ramp
+%
+%   stop_norm_raw([3 X R] FLOAT) :
+%                                   Normalised stop point of each ramp
+%
+%   voxels_for_ramp([1 X R] INT) :
+%                                   Number of voxels of each ramp. Single
+%                                   points have 1 voxel
+%
+%   point_map([2 X N] INT) :
+%                                   Ramp and voxel scanning each input
+%                                   point, to extract point values from
+%                                   the acquired data
+%
+%   report(STRUCT) :
+%                                   naive_cycle_s and optimised_cycle_s
+%                                   (cycle duration in s, one drive per
+%                                   point vs optimised ramps), speed_up,
+%                                   n_ramps and n_grouped_points
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * The timing model is the one of ScanParams.full_time: each drive takes
+%   AolParams.fill_time plus one discretised voxel_time per voxel. In this
+%   model the drive order does not change the cycle duration, so only the
+%   grouping is optimised. Ramps are returned in the order of their first
+%   input point.
+%
+% * Voxels are evenly spaced between start and stop, one per XY cubic
+%   voxel of ramp length, as in ScanParams.voxels_for_ramp. Each grouped
+%   point is scanned by its own voxel, never shared with another point.
+%   Ramps never exceed ScanParams.MAX_SCAN_TIME.
+%
+% * Ramps have variable length and resolution. Set the outputs in
+%   miniscan mode, with ScanParams.fixed_len and ScanParams.fixed_res set
+%   to false first.
+%
+% * Each greedy search picks, for each ungrouped seed point, the ramp
+%   starting at the seed through one of its nearest ungrouped neighbours
+%   that saves the most time, if any.
+% -------------------------------------------------------------------------
+% Examples:
+% * Group the points of the current functional scan into ramps
+%   points = c.scan_params.start_norm_raw;
+%   [start, stop, res, point_map, report] = optimise_scan_path(points, c.scan_params);
+%   c.scan_params.imaging_mode = 'miniscan';
+%   c.scan_params.fixed_len = false; c.scan_params.fixed_res = false;
+%   c.scan_params.start_norm_raw = start;
+%   c.scan_params.stop_norm_raw = stop;
+%   c.scan_params.voxels_for_ramp = res;
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: compile_miniscan_patches, ScanParams.get_fps,
+%   ScanParams.full_time, AolParams.fill_time
+
+function [start_norm_raw, stop_norm_raw, voxels_for_ramp, point_map, report] = optimise_scan_path(points_norm, scan_params, tolerance_px, n_restarts, max_workers, silent)
+    if nargin < 2 || isempty(scan_params)
+        controller  = get_existing_controller_name(true);
+        scan_params = controller.scan_params;
+    end
+    if nargin < 3 || isempty(tolerance_px)
+        tolerance_px = 0.5;
+    end
+    if nargin < 4 || isempty(n_restarts)
+        n_restarts = 16;
+    end
+    if nargin < 5 || isempty(max_workers)
+        max_workers = open_pool_size();
+    end
+    if nargin < 6 || isempty(silent)
+        silent = false;
+    end
+    if size(points_norm, 1) ~= 3
+        error('Input must be a 3xN matrix')
+    end
+
+    %% Timing model, as in ScanParams.full_time
+    aol_params  = scan_params.aol_params_handle;
+    fill        = aol_params.fill_time;
+    dwell       = aol_params.discretize(scan_params.voxel_time);
+    max_voxels  = floor(ScanParams.MAX_SCAN_TIME / dwell);
+
+    %% Work in cubic voxels, where distances are isotropic
+    transform   = aol_params.get_transform(scan_params.acceptance_angle, scan_params.mainscan_x_pixel_density);
+    points      = transform.norm_to_pixels(points_norm);
+    n_points    = size(points, 2);
+
+    %% Independent greedy searches, the first one in input order
+    ramps       = cell(1, n_restarts);
+    cost        = zeros(1, n_restarts);
+    seeds       = randi(2^31, 1, n_restarts);
+    parfor (restart = 1:n_restarts, max_workers)
+        if restart == 1
+            order = 1:n_points;
+        else
+            order = randperm(RandStream('twister', 'Seed', seeds(restart)), n_points);
+        end
+        [ramps{restart}, cost(restart)] = greedy_grouping(points, order, tolerance_px, max_voxels, fill, dwell);
+    end
+    [~, best]   = min(cost);
+    ramps       = ramps{best};
+
+    %% Ramps in the order of their first input point
+    [~, ramp_order] = sort(cellfun(@(r) min(r.points), ramps));
+    ramps       = ramps(ramp_order);
+
+    %% Build drives and point map
+    n_ramps         = numel(ramps);
+    start_px        = zeros(3, n_ramps);
+    stop_px         = zeros(3, n_ramps);
+    voxels_for_ramp = ones(1, n_ramps);
+    point_map       = zeros(2, n_points);
+    for ramp = 1:n_ramps
+        start_px(:, ramp)       = ramps{ramp}.start;
+        stop_px(:, ramp)        = ramps{ramp}.stop;
+        voxels_for_ramp(ramp)   = ramps{ramp}.voxels;
+        point_map(:, ramps{ramp}.points) = [repmat(ramp, 1, numel(ramps{ramp}.points)); ramps{ramp}.voxel];
+    end
+    start_norm_raw  = transform.pixels_to_norm(start_px);
+    stop_norm_raw   = transform.pixels_to_norm(stop_px);
+
+    %% Report the gain vs one drive per point
+    report = struct('naive_cycle_s'     , n_points * (fill + dwell),...
+                    'optimised_cycle_s' , n_ramps * fill + sum(voxels_for_ramp) * dwell,...
+                    'n_ramps'           , n_ramps,...
+                    'n_grouped_points'  , sum(cellfun(@(r) numel(r.points), ramps(voxels_for_ramp > 1))));
+    report.speed_up = report.naive_cycle_s / report.optimised_cycle_s;
+    if ~silent
+        fprintf('%d points scanned with %d drives. Cycle duration %.1f us -> %.1f us (x%.2f)\n',...
+                n_points, n_ramps, report.naive_cycle_s * 1e6, report.optimised_cycle_s * 1e6, report.speed_up);
+    end
+end
+
+function n_workers = open_pool_size()
+    %% Number of workers of the current pool, without starting one
+    n_workers = 0;
+    if license('test', 'Distrib_Computing_Toolbox')
+        pool = gcp('nocreate');
+        if ~isempty(pool)
+            n_workers = pool.NumWorkers;
+        end
+    end
+end
+
+function [ramps, cost] = greedy_grouping(points, order, tolerance_px, max_voxels, fill, dwell)
+    %% Group points with one greedy pass, seeds taken in the given order
+    n_neighbours    = 8; % candidate ramp directions per seed
+    max_len         = max_voxels - 1;
+    single_cost     = fill + dwell;
+    free            = true(1, size(points, 2));
+    ramps           = {};
+    cost            = 0;
+    for seed = order
+        if ~free(seed)
+            continue
+        end
+        free(seed)  = false;
+        best        = struct('saving', 0, 'points', seed, 'start', points(:, seed), 'stop', points(:, seed), 'voxels', 1, 'voxel', 1);
+
+        %% Candidate points within reach of a ramp starting at the seed
+        cand        = find(free);
+        offsets     = points(:, cand) - points(:, seed);
+        dist        = vecnorm(offsets);
+        reach       = dist <= max_len & dist > 0;
+        cand        = cand(reach);
+        offsets     = offsets(:, reach);
+        [~, near]   = sort(dist(reach));
+
+        %% Try the direction of each of the nearest candidates
+        for direction = near(1:min(n_neighbours, end))
+            d       = offsets(:, direction) / norm(offsets(:, direction));
+            t       = d' * offsets;                     % position along the ramp
+            perp    = vecnorm(offsets - d * t);         % distance to the ramp
+            inline  = find(t > 0 & t <= max_len & perp <= tolerance_px);
+            [t_in, sorted] = sort(t(inline));
+            inline  = inline(sorted);
+
+            %% Best valid prefix: k + 1 points on a ramp of round(t_k) + 1 voxels
+            n_vox   = round(t_in) + 1;
+            saving  = (1:numel(t_in)) * single_cost - (n_vox - 1) * dwell;
+            [sorted_saving, by_saving] = sort(saving, 'descend');
+            for k = by_saving(sorted_saving > best.saving)
+                voxels  = n_vox(k);
+                if voxels < k + 1 % not enough voxels for one point per voxel
+                    continue
+                end
+                along   = [0, t_in(1:k)] / t_in(k) * (voxels - 1); % position in voxels
+                voxel   = round(along);
+                spacing = t_in(k) / (voxels - 1); % voxel size, in XY cubic voxels
+                if any(abs(along - voxel) * spacing > tolerance_px) || any(diff(voxel) == 0)
+                    continue % a point is too far from, or shares, its voxel
+                end
+                best    = struct('saving', saving(k), 'points', [seed, cand(inline(1:k))], 'start', points(:, seed),...
+                                 'stop', points(:, seed) + d * t_in(k), 'voxels', voxels, 'voxel', voxel + 1);
+                break
+            end
+        end
+
+        free(best.points) = false;
+        ramps{end + 1}  = best; %#ok<AGROW>
+        cost            = cost + fill + best.voxels * dwell;
+    end
+end
@@ -272,8 +272,9 @@ classdef imaging < handle % superclass of Controller
             %       If true, the system with reuse any preexisting one. 
             %       This will only work if the preexisting one has the
             %       exact same size.
-            %   averaging_method (BOOL) - Optional - Default is 'mean', 
-            %     ... any in {'mean','max','median','min','var'}
+            %   averaging_method (STR) - Optional - Default is 'mean', 
+            %     ... any in {'mean','max','median','min','var'}, or any
+            %     function taking (data, dim), as a str2func string
             %       Define the function to use if you acquire more than one
             %       frame.
             % -------------------------------------------------------------
@@ -284,12 +285,19 @@ classdef imaging < handle % superclass of Controller
             % -------------------------------------------------------------
             % Extra Notes: Use this function for screen capture, z stacks 
             %   etc...)
+            %   When averaging with 'mean', 'max', 'min' or 'var', frames
+            %   are reduced online as each cycle completes (see
+            %   FrameReducer), so only one frame is held in memory
+            %   whatever the number of averages. Other methods (including
+            %   'median' and any function name or handle accepted by
+            %   str2func) are applied to all frames after the recording,
+            %   as before.
             % -------------------------------------------------------------
             % Author(s):
             %   Geoffrey Evans, Boris Marin, Antoine Valera.
             %---------------------------------------------
             % Revision Date:
-            %   23-03-2018
+            %   18-10-2026
             
             %TODO : enable non-square averages. Replace get_averaged_data
             %       by this method whenever possible
@@ -304,31 +312,38 @@ classdef imaging < handle % superclass of Controller
                 averaging_method = 'mean';
             end
 
-            %% Only fixed resolution length will work for now
+            %% Variable resolution scans are returned as a single column
+            %% (see ScanLayout to split them into patches)
             if this.scan_params.imaging_mode == ImagingMode.Pointing 
                 res_x = sqrt(this.scan_params.num_drives);
                 res_y = sqrt(this.scan_params.num_drives);
-            else 
+            elseif numel(unique(this.scan_params.voxels_for_ramp)) == 1
                 res_x = unique(this.scan_params.voxels_for_ramp);
                 res_y = this.scan_params.num_drives;
+            else
+                res_x = this.scan_params.num_voxels;
+                res_y = 1;
             end
 
-            %% We create a data holder
-            [big_data,~,~,~] = this.timed_image('recording_time_sec',0,'repeats',1,'number_of_cycles',averages+1,'pause',0,'reuse_viewer',reuse_viewer,'no_interrupt',true,'monitor_MC',false);
+            %% We create a data holder. Exact reductions are done online
+            if averages && any(strcmp(averaging_method, FrameReducer.EXACT_METHODS))
+                reduction = averaging_method;
+            else
+                reduction = 'none';
+            end
+            [big_data,~,~,~] = this.timed_image('recording_time_sec',0,'repeats',1,'number_of_cycles',averages+1,'pause',0,'reuse_viewer',reuse_viewer,'no_interrupt',true,'monitor_MC',false,'reduction',reduction);
             
-            %% We reshape and average the output using the specified method
-            if ~averages
+            %% We reshape the output, and average it if it was not reduced
+            if ~strcmp(reduction, 'none') || ~averages
                 data = cat( 3,...
-                            reshape(big_data{1}(:,1),res_x, res_y, averages+1),...
-                            reshape(big_data{1}(:,2),res_x, res_y, averages+1));
+                            reshape(big_data{1}(:,1),res_x, res_y),...
+                            reshape(big_data{1}(:,2),res_x, res_y));
             else
                 func = str2func(averaging_method);
                 data = cat( 3,...
                             func(reshape(big_data{1}(:,1),res_x, res_y, averages+1),3),...
                             func(reshape(big_data{1}(:,2),res_x, res_y, averages+1),3));
             end
-            
-            
         end
         
         function point_image(this, duration)
@@ -415,6 +430,13 @@ classdef imaging < handle % superclass of Controller
             %       This is the real acquisition duration  
             %       summary{2} is the real inter-trial pause, for each
             %       repeat. This must be added to real duration.
+            %       summary{3} is the timing table of the drives (line,
+            %       voxel and MC cycle timings, see
+            %       ScanParams.get_timing_table), computed when the
+            %       recording starts. Use ScanParams.voxel_timestamps to
+            %       get the time of each recorded voxel. If monitor_MC or
+            %       dump_data is set, it is also saved in
+            %       timing_table.mat, next to the MC logs.
             %
             %   mc_log(STRUCT) :
             %       If movement correction was running, this contains the
@@ -446,7 +468,7 @@ classdef imaging < handle % superclass of Controller
             %   Antoine Valera.
             %---------------------------------------------
             % Partial Revision Date:
-            %   22-04-2019
+            %   18-10-2026
             %
             % See also: initialise_timed_image, finalise_timed_image,
             %   push_data_to_trial_holder, timing_params, scan
@@ -459,6 +481,13 @@ classdef imaging < handle % superclass of Controller
             [all_data, parameters, this.viewer.timer, this.frame_cycles, parameters.duration] = initialise_timed_image(this, varargin);
 
 
+            %% Timings of the drives, with the MC state of this recording
+            this.timing_table = this.get_drives_timing_table();
+            if parameters.monitor_MC || parameters.dump_data
+                timing_table = this.timing_table;
+                save('timing_table.mat', 'timing_table'); % next to the MC logs and dumped trials
+            end
+
             %% Collect Data
             inter_trial_delays = zeros(1, parameters.repeats);
             for trial = 1:parameters.repeats
@@ -482,7 +511,7 @@ classdef imaging < handle % superclass of Controller
                 if trial < parameters.repeats
                     %% If you do MC logging, reprepare MC viewer
                     if parameters.monitor_MC
-                        this.rig_params.bg_mc_monitoring = MCViewer(false,['timed_image_repeat_',num2str(trial+1,'%03d')]);
+                        this.set_mc_monitoring(MCViewer(false,['timed_image_repeat_',num2str(trial+1,'%03d')]));
                     end
                 	pause(parameters.pause - toc(intersweep_pause))
                 end                
@@ -511,7 +540,7 @@ classdef imaging < handle % superclass of Controller
 
             %% Finalise recording. Delete temporary files
             all_data = finalise_timed_image(this, parameters, all_data);
-            timings_summary = {parameters.duration, inter_trial_delays};
+            timings_summary = {parameters.duration, inter_trial_delays, this.timing_table};
             n_cycles = this.frame_cycles * parameters.repeats;
         end
 
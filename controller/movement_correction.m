@@ -39,6 +39,9 @@
 %   [previous_timers, previous_plot_status] =
 %   Controller.stop_mc_logging_or_plotting()
 %
+% * Replace or clear the MC logging / plotting object
+%   Controller.set_mc_monitoring(mc_viewer)
+%
 % -------------------------------------------------------------------------
 % Extra Notes:
 %
@@ -89,6 +92,7 @@ classdef movement_correction < handle % superclass of Controller
         suggested_MC_ROI      = [0;0;0];
         suggested_z_ref       = NaN;  % default should be controller.xyz_stage.get_position(3); 
         suggested_thr         = 1;
+        mc_reference          = [];   % MC reference frame, in the FIFOREFHOSTFRAME layout. Set by prepare_MC_Ref, used by MCEstimator
     end
 
     methods
@@ -274,7 +278,7 @@ classdef movement_correction < handle % superclass of Controller
             %   Antoine Valera, Victoria Griffiths
             %---------------------------------------------
             % Revision Date:
-            %   18-03-2019
+            %   18-10-2026
             %
             % See also: start_mc, send_mc_drives, prepare_daq_for_mc,
             %   MCViewer
@@ -290,7 +294,7 @@ classdef movement_correction < handle % superclass of Controller
 
             %% Start logging or background MC live plot
             if (this.viewer.plot_background_mc || this.rig_params.log_bkg_mc)
-                this.rig_params.bg_mc_monitoring = MCViewer(this.viewer.plot_background_mc,'bkg_MC');
+                this.set_mc_monitoring(MCViewer(this.viewer.plot_background_mc,'bkg_MC'));
                 this.viewer.bg_mc_measure = timer('TimerFcn', @(src,eventdata)this.rig_params.bg_mc_monitoring.update(),'ExecutionMode','fixedRate','Period',this.mc_timer_refresh_rate,'BusyMode','queue','Name','background_mc_plot');
                 start(this.viewer.bg_mc_measure);
                 fprintf('\t...MC BACKGROUND : Background MC tracker generated\n')
@@ -392,9 +396,9 @@ classdef movement_correction < handle % superclass of Controller
             %   Antoine Valera
             %---------------------------------------------
             % Revision Date:
-            %   18-03-2019
+            %   18-10-2026
             %
-            % See also: MCViewer, data_acquisition
+            % See also: MCViewer, data_acquisition, set_mc_monitoring
 
             % QQ should logging be in a timer too?
 
@@ -413,7 +417,7 @@ classdef movement_correction < handle % superclass of Controller
                 close(figure(1004));
 
                 %% Create a MC plotting object
-                this.rig_params.bg_mc_monitoring = MCViewer(true,'bkg_MC');
+                this.set_mc_monitoring(MCViewer(true,'bkg_MC'));
 
                 %% If we didn't have a timer function to plot MC, make one
                 if isempty(previous_tracker)
@@ -426,10 +430,10 @@ classdef movement_correction < handle % superclass of Controller
                 start(this.viewer.bg_mc_measure);
             elseif this.rig_params.log_live_image_mc
                 %% Create a MC logging object
-                this.rig_params.bg_mc_monitoring = MCViewer(this.viewer.plot_background_mc, 'live_MC');
+                this.set_mc_monitoring(MCViewer(this.viewer.plot_background_mc, 'live_MC'));
             else
                 %% Delete any preexisting object
-                this.rig_params.bg_mc_monitoring = [];
+                this.set_mc_monitoring([]);
             end
         end
 
@@ -469,6 +473,40 @@ classdef movement_correction < handle % superclass of Controller
             end
         end
 
+        function set_mc_monitoring(this, mc_viewer)
+            %% Replace or clear the MC logging / plotting object
+            % -------------------------------------------------------------
+            % Syntax:
+            %   Controller.set_mc_monitoring(mc_viewer)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   mc_viewer (MCViewer object OR [])
+            %       The new Controller.rig_params.bg_mc_monitoring
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Extra Notes:
+            % The previous MCViewer is deleted first, which stops its
+            % refresh timer and its sampler and closes its log file. Its
+            % timer callback holds a reference to it, so simply
+            % overwriting rig_params.bg_mc_monitoring would keep it alive,
+            % logging in the background.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            %---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            %
+            % See also: MCViewer, start_mc_logging_or_plotting
+
+            previous = this.rig_params.bg_mc_monitoring;
+            if ~isempty(previous) && isvalid(previous) && (isempty(mc_viewer) || previous ~= mc_viewer)
+                previous.delete();
+            end
+            this.rig_params.bg_mc_monitoring = mc_viewer;
+        end
+
         function set.host_channel(this, host_channel)
             %% Define the channel to use for MC
             % -------------------------------------------------------------
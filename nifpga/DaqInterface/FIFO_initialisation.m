@@ -211,6 +211,9 @@ classdef FIFO_initialisation < handle
                 viewer.trial_start_triggers()           ;                   % This is as close from acquisition start as it can get. Probably less than a ms
 
                 obj.acq_clock = tic();                
+                if ~isempty(bg_mc_monitoring)
+                    bg_mc_monitoring.mark_acquisition_start();      % MC samples and events get timestamps relative to this point
+                end
             else
                 bg_mc_monitoring                = []    ;                   % Clear MC monitoring object 
                 obj.capi.EnableTrigger1         = 0     ;                   % Disable "Encoder trigger/line trigger" (PXI_Trig2)
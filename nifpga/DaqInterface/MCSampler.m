@@ -0,0 +1,343 @@
+%% Fixed rate sampling of the MC registers in a background C thread
+% Read the MC correction and error indicators at a fixed rate, independently
+% of the acquisition loop, and retrieve the timestamped samples in batches.
+% Changes of the lost tracking flags are also queued as events.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = MCSampler(capi, rate_hz);
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   capi (CFPGADAQ_variable_length_matlab_v13 object)
+%       The DaqFpga CAPI, typically Controller.daq_fpga.capi. If there is
+%       no open session (simulation mode), the sampler does nothing and
+%       read() returns empty arrays.
+%
+%   rate_hz (FLOAT) - Optional - default is 2000
+%       The sampling rate. Up to a few kHz. Usually set from
+%       rig_params.mc_sampling_rate (see MCViewer).
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (MCSampler object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Get all samples acquired since the last call
+%   [t, values, t_acq] = MCSampler.read()
+%
+% * Get all lost / recovered tracking events since the last call
+%   events = MCSampler.read_events()
+%
+% * Set the acquisition start, as a reference for t_acq timestamps
+%   MCSampler.mark_acquisition_start()
+%
+% * Get the current time on the sampler clock (static)
+%   t = MCSampler.qpc_time()
+%
+% * Stop sampling
+%   MCSampler.stop()
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Sampling is done by the NiFpga mex file (functions 5070 to 5075), in
+%   a dedicated thread writing into a lock-free single producer / single
+%   consumer ring of 262144 samples. If read() is not called for longer
+%   than the ring duration, new samples are dropped and counted in
+%   n_overflow.
+%
+% * The same thread compares each sample with the previous one, and pushes
+%   an event in a second queue (16384 events) when any of
+%   MCSampler.EVENT_REGISTERS changes. Events are not lost when the sample
+%   ring is full, so lost/recovered transitions can be retrieved at any
+%   rate, e.g. from a timer (see MCViewer), without being tied to the FIFO
+%   read loop.
+%
+% * mark_acquisition_start() is called by flush_FIFO_and_setup_triggers
+%   when the acquisition starts. Samples and events then also have a t_acq
+%   timestamp, in s since that point, on the same clock as t.
+%
+% * Timestamps come from the high resolution performance counter
+%   (QueryPerformanceCounter), which is monotonic, and are in seconds
+%   since the sampler start. start_qpc is that start on the counter clock,
+%   so times from MCSampler.qpc_time() can be compared with samples.
+%   start_posix is the system time read at the same instant, only used to
+%   convert samples to absolute times in the logs.
+%
+% * The thread blocks on a high resolution waitable timer between
+%   samples (or on a standard timer with a 1 ms system timer resolution
+%   before Windows 10 1803), so it does not keep a core busy. Sampling is
+%   off by default (rig_params.mc_sampling_rate = 0).
+%
+% * Only one sampler runs at a time. Creating a new one stops the
+%   previous one. Each call passes the sampler id, so a stale sampler
+%   reads no samples or events from the new one.
+%
+% * The registers are listed by name in MCSampler.REGISTERS. Addresses and
+%   types come from RegisterTransaction.register_map(), so they follow the
+%   bitfile when it is recompiled.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Sample MC registers at 5 kHz for 1 second
+%   sampler = MCSampler(controller.daq_fpga.capi, 5000);
+%   pause(1);
+%   [t, values] = sampler.read();
+%   plot(t, values(:, 1)); % x_correction, in pixels
+%
+% * List the times at which XY tracking was lost during the acquisition
+%   events = sampler.read_events();
+%   lost = events.t_acq(strcmp(events.register, 'lostx') & events.value == 1);
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: MCViewer, CFPGADAQ_variable_length_matlab_v13, NiFpga_mex.cpp
+
+classdef MCSampler < handle
+    properties
+        session         = [];   % NiFpga session. Empty in simulation mode
+        rate_hz         = 2000; % Sampling rate
+        id              = 0;    % Sampler id, returned by the mex file
+        start_qpc       = NaN;  % Sampler start, in s on the QueryPerformanceCounter clock (see qpc_time)
+        start_posix     = NaN;  % Sampler start, in s since 1970-01-01, read with start_qpc
+        start_time      = [];   % datenum of the sampler start, from start_posix
+        n_overflow      = 0;    % Number of samples dropped because the ring was full
+        n_late          = 0;    % Number of samples taken more than one period late
+        n_event_overflow= 0;    % Number of events dropped because the event queue was full
+        acq_start       = NaN;  % Acquisition start, in s since start_time. NaN if not marked
+        max_batch       = 262144; % Max number of samples returned by one read()
+    end
+
+    properties (Constant)
+        %% {name, scaling} ; same order as MCViewer.update() var1 to var6, then lost flags
+        REGISTERS = {   'x_correction_X10' , 10   ;...
+                        'y_correction_X10' , 10   ;...
+                        'z_correction_X100', 100  ;...
+                        'x_diff_X100'      , 100  ;...
+                        'y_diff_X100'      , 100  ;...
+                        'z_diff_X100'      , 100  ;...
+                        'lostx'            , 1    ;...
+                        'lostz'            , 1    ;...
+                        'losty'            , 1    ;...
+                        'notlost_xory'     , 1    };
+
+        %% Registers generating an event when they change
+        EVENT_REGISTERS = {'lostx', 'losty', 'lostz', 'notlost_xory'};
+    end
+
+    methods
+        function this = MCSampler(capi, rate_hz)
+            %% MCSampler Object Constructor. Starts sampling
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = MCSampler(capi, rate_hz);
+            % -------------------------------------------------------------
+            % Inputs:
+            %   capi (CFPGADAQ_variable_length_matlab_v13 object)
+            %       The DaqFpga CAPI, typically Controller.daq_fpga.capi
+            %
+            %   rate_hz (FLOAT) - Optional - default is 2000
+            %       The sampling rate
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (MCSampler object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin >= 2 && ~isempty(rate_hz)
+                this.rate_hz = rate_hz;
+            end
+            if this.rate_hz <= 0
+                error('MC sampling rate must be > 0')
+            end
+
+            this.session    = capi.Session;
+            if ~isempty(this.session)
+                map         = RegisterTransaction.register_map(class(capi), capi.Signature);
+                codes       = cellfun(@(n) map.(n), this.REGISTERS(:, 1), 'UniformOutput', false);
+                codes       = vertcat(codes{:});
+                event_mask  = sum(2.^(find(ismember(this.REGISTERS(:, 1), this.EVENT_REGISTERS)) - 1));
+                [~, this.id, start] = NiFpga(uint32(5070), this.session, uint32(codes(:, 1)'), uint32(codes(:, 2)'), double(this.rate_hz), uint32(event_mask));
+                this.start_qpc      = start(1);
+                this.start_posix    = start(2);
+            else
+                this.start_posix    = (now - datenum(1970, 1, 1)) * 86400;
+            end
+            this.start_time = datenum(1970, 1, 1) + this.start_posix / 86400;
+        end
+
+        function [t, values, t_acq] = read(this)
+            %% Get all samples acquired since the last call
+            % -------------------------------------------------------------
+            % Syntax:
+            %   [t, values, t_acq] = MCSampler.read()
+            % -------------------------------------------------------------
+            % Inputs:
+            % -------------------------------------------------------------
+            % Outputs:
+            %   t ([N x 1] DOUBLE)
+            %       Timestamps, in s since this.start_time
+            %
+            %   values ([N x 10] SINGLE)
+            %       Scaled register values, in the order of
+            %       MCSampler.REGISTERS (x, y, z corrections, x, y, z
+            %       errors, then lostx, lostz, losty and notlost_xory flags)
+            %
+            %   t_acq ([N x 1] DOUBLE)
+            %       Timestamps, in s since the acquisition start. NaN if
+            %       mark_acquisition_start() was not called
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if isempty(this.session) || ~this.id
+                t = zeros(0, 1);
+                t_acq = zeros(0, 1);
+                values = zeros(0, size(this.REGISTERS, 1), 'single');
+                return
+            end
+
+            [~, samples, counters] = NiFpga(uint32(5071), this.session, uint32(this.id), uint32(this.max_batch));
+            this.n_overflow = double(counters(1));
+            this.n_late     = double(counters(2));
+            this.n_event_overflow = double(counters(3));
+            t               = samples(1, :)';
+            t_acq           = samples(2, :)';
+            values          = single(samples(3:end, :)') ./ single([this.REGISTERS{:,2}]);
+        end
+
+        function events = read_events(this)
+            %% Get all lost / recovered tracking events since the last call
+            % -------------------------------------------------------------
+            % Syntax:
+            %   events = MCSampler.read_events()
+            % -------------------------------------------------------------
+            % Inputs:
+            % -------------------------------------------------------------
+            % Outputs:
+            %   events (STRUCT)
+            %       Struct with [N x 1] fields, in chronological order:
+            %       - t : time of the first sample with the new value, in s
+            %         since this.start_time
+            %       - t_acq : same time, in s since the acquisition start
+            %         (NaN if not marked)
+            %       - register : register name (CELL of STR), one of
+            %         MCSampler.EVENT_REGISTERS
+            %       - value : new register value
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            raw = zeros(4, 0);
+            if ~isempty(this.session) && this.id
+                [~, raw] = NiFpga(uint32(5074), this.session, uint32(this.id));
+            end
+            events = struct('t'        , raw(1, :)'                         ,...
+                            't_acq'    , raw(2, :)'                         ,...
+                            'register' , {this.REGISTERS(raw(3, :) + 1, 1)} ,...
+                            'value'    , raw(4, :)'                         );
+        end
+
+        function mark_acquisition_start(this)
+            %% Set the acquisition start, as a reference for t_acq timestamps
+            % -------------------------------------------------------------
+            % Syntax:
+            %   MCSampler.mark_acquisition_start()
+            % -------------------------------------------------------------
+            % Extra Notes:
+            % * The time is taken on the sampler clock in the mex file, so
+            %   t and t_acq only differ by a constant.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if ~isempty(this.session) && this.id
+                [~, this.acq_start] = NiFpga(uint32(5073), this.session, uint32(this.id));
+            end
+        end
+
+        function stop(this)
+            %% Stop sampling. Samples not read yet are lost
+            % -------------------------------------------------------------
+            % Syntax:
+            %   MCSampler.stop()
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if ~isempty(this.session) && this.id
+                NiFpga(uint32(5072), this.session, uint32(this.id));
+                this.id = 0;
+            end
+        end
+
+        function delete(this)
+            %% MCSampler Object Destructor
+            this.stop();
+        end
+    end
+
+    methods (Static)
+        function t = qpc_time()
+            %% Current time on the sampler clock
+            % -------------------------------------------------------------
+            % Syntax:
+            %   t = MCSampler.qpc_time()
+            % -------------------------------------------------------------
+            % Outputs:
+            %   t (DOUBLE)
+            %       Time in s on the QueryPerformanceCounter clock.
+            %       t - sampler.start_qpc is on the same time base as the
+            %       sample timestamps
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            [~, t] = NiFpga(uint32(5075));
+        end
+    end
+end
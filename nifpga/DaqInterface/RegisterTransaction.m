@@ -0,0 +1,377 @@
+%% Group FPGA register reads and writes in a single NiFpga call
+% Collect register assignments by name (as the CAPI dependent properties)
+% and send all of them at once with commit(), or read a list of registers
+% at once with read(). Each dependent property of the CAPI is otherwise a
+% separate mex call.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = RegisterTransaction(capi, use_shadow);
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   capi (CFPGADAQ_variable_length_matlab_v13 object)
+%       The DaqFpga CAPI, typically Controller.daq_fpga.capi. If there is
+%       no open session (simulation mode), commit() does nothing and read()
+%       returns NaNs, like the CAPI properties.
+%
+%   use_shadow (BOOL) - Optional - default is true
+%       If true, commit() skips registers whose last written value (as
+%       recorded in the mex file) is unchanged. Set to false for controls
+%       that the FPGA may modify itself.
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (RegisterTransaction object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Queue a register write, by name
+%   RegisterTransaction.write(name, value)
+%
+% * Send all queued writes, in order, in one call
+%   status = RegisterTransaction.commit()
+%
+% * Read several registers, by name, in one call
+%   values = RegisterTransaction.read(names)
+%
+% * Drop queued writes
+%   RegisterTransaction.discard()
+%
+% * Get the number of writes sent and avoided by the register shadow
+%   stats = RegisterTransaction.shadow_stats(reset)
+%
+% * Force the next commits to write all registers
+%   RegisterTransaction.invalidate_shadow()
+%
+% * Get the address and NiFpga codes of all registers (static)
+%   map = RegisterTransaction.register_map(capi_class, signature)
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Register addresses and types are loaded once per session from the
+%   table compiled in the mex file (NiFpga_registers.h, generated by
+%   NiFpga2Cpp). If its signature does not match the CAPI bitfile, an error
+%   asks to regenerate the table and recompile the mex file.
+%
+% * In simulation mode (no session), no map is loaded. Writes are queued
+%   without checking the register names, commit() sends nothing and
+%   read() returns NaN.
+%
+% * Values are sent as double and cast to the register type in the mex
+%   file (NiFpga functions 110 and 210). Booleans are true if ~= 0.
+%
+% * Writing the same register twice before commit() only keeps the last
+%   value, at the position of the first write.
+%
+% * Queued writes are not visible to CAPI reads until commit(). Compute
+%   derived values locally instead of reading them back from the CAPI.
+%
+% * The mex file keeps a shadow of the last value written to each control
+%   register, per session, by any write function (CAPI properties
+%   included). The shadow of a session is cleared on Open, Close, Run,
+%   Reset and Download, so the first commit after these calls writes
+%   everything. Repeated acquisitions (e.g. Z-stack planes) then only send
+%   the registers that changed.
+%
+% * The shadow cannot see registers changed by the FPGA itself. Use
+%   RegisterTransaction(capi, false) for triggers and commands that must
+%   be sent every time.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Update MC gains in one call
+%   tr = RegisterTransaction(controller.daq_fpga.capi);
+%   tr.write('proportianal_x10', 9);
+%   tr.write('Integral_scale', 400);
+%   tr.commit();
+%
+% * Read a few flags at once
+%   values = tr.read({'live_scan', 'flag1_read'});
+%
+% * Check how many writes were avoided during a stack
+%   stats = tr.shadow_stats()
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: CFPGADAQ_variable_length_matlab_v13, update_daq_parameters,
+%   NiFpga_mex.cpp
+
+classdef RegisterTransaction < handle
+    properties
+        capi            = [];                   % The CAPI
+        map             = [];                   % Register map, see register_map()
+        names           = {};                   % Names of the queued registers
+        values          = zeros(1, 0);          % Queued values
+        statuses        = zeros(1, 0, 'int32'); % NiFpga status of each write of the last commit
+        sent            = false(1, 0);          % False for writes of the last commit skipped by the shadow
+        use_shadow      = true;                 % If true, unchanged registers are not written
+    end
+
+    methods
+        function this = RegisterTransaction(capi, use_shadow)
+            %% RegisterTransaction Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = RegisterTransaction(capi, use_shadow);
+            % -------------------------------------------------------------
+            % Inputs:
+            %   capi (CFPGADAQ_variable_length_matlab_v13 object)
+            %       The DaqFpga CAPI
+            %
+            %   use_shadow (BOOL) - Optional - default is true
+            %       If true, unchanged registers are not written
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (RegisterTransaction object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin > 1 && ~isempty(use_shadow)
+                this.use_shadow = use_shadow;
+            end
+            this.capi   = capi;
+            if ~isempty(capi.Session)
+                this.map = RegisterTransaction.register_map(class(capi), capi.Signature);
+            end
+        end
+
+        function write(this, name, value)
+            %% Queue a register write
+            % -------------------------------------------------------------
+            % Syntax:
+            %   RegisterTransaction.write(name, value)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   name (STR)
+            %       The CAPI property name, e.g. 'threshold_xy'
+            %
+            %   value (NUMERIC or BOOL scalar)
+            %       The value to write
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if ~isempty(this.map) && (~isfield(this.map, name) || ~this.map.(name)(3))
+                error(['No writable register named ', name])
+            elseif numel(value) ~= 1
+                error(['Register ', name, ' only accepts scalar values'])
+            end
+
+            idx = find(strcmp(this.names, name), 1);
+            if isempty(idx)
+                this.names{end + 1} = name;
+                this.values(end + 1) = double(value);
+            else
+                this.values(idx) = double(value);
+            end
+        end
+
+        function status = commit(this)
+            %% Send all queued writes in one call, and clear the queue
+            % -------------------------------------------------------------
+            % Syntax:
+            %   status = RegisterTransaction.commit()
+            % -------------------------------------------------------------
+            % Inputs:
+            % -------------------------------------------------------------
+            % Outputs:
+            %   status (INT32)
+            %       The first NiFpga error, or the first warning, or 0.
+            %       Individual statuses are in this.statuses, and skipped
+            %       writes are flagged in this.sent
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            status = int32(0);
+            if ~isempty(this.names) && ~isempty(this.capi.Session)
+                codes = cellfun(@(n) this.map.(n), this.names, 'UniformOutput', false);
+                codes = vertcat(codes{:});
+                [status, this.statuses, this.sent] = NiFpga(uint32(210), this.capi.Session, uint32(codes(:, 1)'), uint32(codes(:, 3)'), this.values, logical(this.use_shadow));
+                this.capi.Status = status;
+            end
+            this.discard();
+        end
+
+        function values = read(this, names)
+            %% Read several registers in one call
+            % -------------------------------------------------------------
+            % Syntax:
+            %   values = RegisterTransaction.read(names)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   names ({1 x N} CELL ARRAY of STR)
+            %       The CAPI property names
+            % -------------------------------------------------------------
+            % Outputs:
+            %   values ([1 x N] DOUBLE)
+            %       The register values. NaN in simulation mode
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if ischar(names)
+                names = {names};
+            end
+            if isempty(this.capi.Session)
+                values = NaN(1, numel(names));
+            else
+                missing = names(~isfield(this.map, names));
+                if ~isempty(missing)
+                    error(['No readable register named ', strjoin(missing, ', ')])
+                end
+                codes = cellfun(@(n) this.map.(n), names, 'UniformOutput', false);
+                codes = vertcat(codes{:});
+                [this.capi.Status, values] = NiFpga(uint32(110), this.capi.Session, uint32(codes(:, 1)'), uint32(codes(:, 2)'));
+            end
+        end
+
+        function discard(this)
+            %% Drop queued writes
+            this.names  = {};
+            this.values = zeros(1, 0);
+        end
+
+        function stats = shadow_stats(this, reset)
+            %% Get the number of writes sent and avoided by the shadow
+            % -------------------------------------------------------------
+            % Syntax:
+            %   stats = RegisterTransaction.shadow_stats(reset)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   reset (BOOL) - Optional - default is false
+            %       If true, counters are reset after being read
+            % -------------------------------------------------------------
+            % Outputs:
+            %   stats (STRUCT)
+            %       - sent : number of batch writes sent to the FPGA
+            %       - skipped : number of batch writes avoided
+            %       - invalidations : number of times the shadow was
+            %       cleared
+            %       - registers : number of registers in the shadow
+            %       Values are NaN in simulation mode
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 2 || isempty(reset)
+                reset = false;
+            end
+            if isempty(this.capi.Session)
+                values = NaN(1, 4);
+            else
+                [~, values] = NiFpga(uint32(211), this.capi.Session, logical(reset));
+            end
+            stats = cell2struct(num2cell(values'), {'sent', 'skipped', 'invalidations', 'registers'});
+        end
+
+        function invalidate_shadow(this)
+            %% Force the next commits to write all registers
+            if ~isempty(this.capi.Session)
+                NiFpga(uint32(212), this.capi.Session);
+            end
+        end
+    end
+
+    methods (Static)
+        function map = register_map(capi_class, signature)
+            %% Get the address, read and write codes of all scalar registers
+            % -------------------------------------------------------------
+            % Syntax:
+            %   map = RegisterTransaction.register_map(capi_class, signature)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   capi_class (STR) - Optional - default is
+            %           'CFPGADAQ_variable_length_matlab_v13'
+            %       The generated CAPI class
+            %
+            %   signature (STR)
+            %       The CAPI bitfile signature. It must match the one of
+            %       the mex register table.
+            % -------------------------------------------------------------
+            % Outputs:
+            %   map (STRUCT)
+            %       One field per register, [address, read_code,
+            %       write_code]. The write code is 0 for indicators.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            persistent maps
+            if nargin < 1 || isempty(capi_class)
+                capi_class = 'CFPGADAQ_variable_length_matlab_v13';
+            end
+            if isempty(maps)
+                maps = struct();
+            end
+            if isfield(maps, capi_class)
+                map = maps.(capi_class);
+                return
+            end
+
+            %% Use the register table compiled in the mex file
+            [~, names, table, mex_signature] = NiFpga(uint32(213));
+            if nargin < 2 || ~strcmp(mex_signature, signature)
+                error(['The register table of the NiFpga mex file (signature %s) does not match the %s bitfile. ',...
+                       'Regenerate NiFpga_registers.h with NiFpga2Cpp and recompile the mex file (capi/compile_nifpga.m)'],...
+                       mex_signature, capi_class)
+            end
+            map         = struct();
+            scalars     = find(~table(:, 4))';
+            for idx = scalars
+                name    = names{idx};
+                if ~isletter(name(1))
+                    name = ['l_', name]; % as in NiFpga2Matlab
+                end
+                map.(name) = table(idx, 1:3);
+            end
+            maps.(capi_class) = map;
+        end
+    end
+end
@@ -91,6 +91,8 @@ classdef data_acquisition < handle
         acq_clock                   = []            ;   % tic-toc function returning the data acqusition duration
         scan_cycles                 = 10            ;   % The number of 5 ns clock cycle per pixel * 2 (used for normalizing FIFO data)
         dump_data                   = false         ;   % If true, c pipe will write collected data on a file on HD, otherwise data is held in memory   
+        publisher                   = []            ;   % FramePublisher. If not empty, raw channel 1:2 blocks are published in shared memory after each read
+        mc_estimator                = []            ;   % MCEstimator. If not empty, FIFOREFHOSTFRAME frames are also processed on the host
     end
     
     methods
@@ -174,8 +176,8 @@ classdef data_acquisition < handle
             % There is no output since data is stored in the viewer.data0
             % and viewer.data1 fields
             %
-            % bg_mc_monitoring rate depends on the rate at which we 
-            % read the buffer
+            % bg_mc_monitoring is updated between buffer reads, unless it
+            % has its own refresh timer (sampled MC logs, see MCViewer)
             %
             % Examples:
             %
@@ -275,7 +277,7 @@ classdef data_acquisition < handle
                 fprintf('\t\t...GET DATA : live imaging started ; use a c.stop_image() callback or ctrl-c to stop\n');
                 while obj.capi.live_scan && obj.capi.flag1_read || (~obj.capi.Session && obj.is_imaging)
                     %% If tracking MC, read value from CAPI and store/display
-                    if ~isempty(bg_mc_monitoring)                                       % If there is a background MC tracker...
+                    if ~isempty(bg_mc_monitoring) && isempty(bg_mc_monitoring.refresh_timer) % If there is a background MC tracker not running on its own timer...
                         bg_mc_monitoring.update()                                   ;   % Update the background MC logger if any
                     end
 
@@ -289,7 +291,7 @@ classdef data_acquisition < handle
                 
                 while obj.points_left_ch1 > 0 || obj.points_left_ch2 > 0
                     %% If tracking MC, read value from CAPI and store/display
-                    if ~isempty(bg_mc_monitoring)                                       % If there is a background MC tracker...
+                    if ~isempty(bg_mc_monitoring) && isempty(bg_mc_monitoring.refresh_timer) % If there is a background MC tracker not running on its own timer...
                         bg_mc_monitoring.update()                                   ;   % Update the background MC logger if any
                     end
                     
@@ -389,9 +391,15 @@ classdef data_acquisition < handle
                 if ~obj.dump_data && points_read_ch1 %% QQ What about points_read_ch2 ?!!!!
                     viewer.update(obj.data0(1:points_read_ch1), obj.data1(1:points_read_ch2))           ;   % If pushing data to memory (LiveViewer of DataHolder), call the viewer update function
                 end
+                if ~isempty(obj.publisher) && points_read_ch1
+                    obj.publisher.publish_block(obj.data0(1:points_read_ch1), obj.data1(1:points_read_ch2)); % External readers, see FramePublisher
+                end
             elseif obj.live_rendering_mode == 1 && ok_to_read
                 %% Check FIFOREFHOSTFRAME only (data0 and data1 blanked), Quite slow
                 [~, obj.data2, ~]                   = obj.capi.FIFOREFHOSTFRAME.read(0, prod(obj.mc_roi_size), obj.MC_rate * obj.capi.ref_framedilute, obj); % Get FIFO channel data
+                if ~isempty(obj.mc_estimator) && any(obj.data2(:))
+                    obj.mc_estimator.push(obj.data2)                                                    ;   % Host-side displacement estimate, see MCEstimator
+                end
                 if any(obj.data2(:))
                     if ~obj.dump_data && any(obj.data2)
                         viewer.update(obj.data0, obj.data1, uint16(obj.data2  * 100), obj.mc_roi_size)  ;   % Update channel 2 (obj.data0 and obj.data1 are blanked)
@@ -405,6 +413,9 @@ classdef data_acquisition < handle
                 %% Check FIFOREFHOSTFRAME and data0 and data1. Very slow
                 [points_read_ch1, points_read_ch2]  = get_data_from_main_channels(obj, fast_read)       ;   % Get channel 1:2 data
                 [~, obj.data2, ~]                   = obj.capi.FIFOREFHOSTFRAME.read(0 , prod(obj.mc_roi_size), obj.MC_rate, obj); % Get FIFO channel data
+                if ~isempty(obj.mc_estimator) && any(obj.data2(:))
+                    obj.mc_estimator.push(obj.data2)                                                    ;   % Host-side displacement estimate, see MCEstimator
+                end
                 if ~obj.dump_data
                     viewer.update(  obj.data0(1:points_read_ch1),...
                                     obj.data1(1:points_read_ch2),...
@@ -50,6 +50,11 @@
 %   structure is to smooth communications between the command line and the
 %   GUI, and they all have direct access the the DaqFpga values. (while 
 %   in command line, accessing directly the GUI is more complex)
+%
+% * Registers are sent with a RegisterTransaction, one mex call per
+%   function. Registers that did not change since the last write are
+%   skipped, which shortens the update between Z-stack planes. Triggers
+%   and commands (e.g. stop_background) bypass the shadow.
 % -------------------------------------------------------------------------
 % Examples:
 % -------------------------------------------------------------------------
@@ -79,7 +84,7 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   16-03-2019
+%   18-10-2026
 %
 % See also: DaqFpga, data_acquisition, FIFO_initialisation, 
 %   single_record, timed_image
@@ -151,18 +156,22 @@ classdef update_daq_parameters < handle
             % Extra Notes:
             % TBH, i'm a bit unclear about the segmentation of variables
             % between the different functions
+            % Values are usually unchanged between acquisitions, in which
+            % case nothing is sent (see RegisterTransaction).
             % -------------------------------------------------------------
             % Author(s):
             %   Geoffrey Evans, Boris Marin, Antoine Valera, Vicky
             %   Griffiths, Srinivas Nadella
             %---------------------------------------------
             % Revision Date:
-            %   13-03-2019
+            %   18-10-2026
             
-            obj.capi.AODfill                    = aol_params.aod_fill                   ; % daq_clock_freq .* aol_params.fill_time; %4895
-            obj.capi.sampleswaitaftertrigger    = aol_params.sampleswaitaftertrigger    ;        
-            obj.capi.StartUpDelay               = aol_params.startup_delay              ;
-            obj.capi.Newlinetriggerenabled      = 0                                     ;
+            tr = RegisterTransaction(obj.capi);
+            tr.write('AODfill'                  , aol_params.aod_fill                   ); % daq_clock_freq .* aol_params.fill_time; %4895
+            tr.write('sampleswaitaftertrigger'  , aol_params.sampleswaitaftertrigger    );        
+            tr.write('StartUpDelay'             , aol_params.startup_delay              );
+            tr.write('Newlinetriggerenabled'    , 0                                     );
+            tr.commit();
         end  
         
         function set_variable_params(obj, scan_params, aol_params, number_of_cycles)
@@ -206,18 +215,23 @@ classdef update_daq_parameters < handle
             %   13-03-2019
             
             mc_is_ready_and_wanted          = (obj.use_movement_correction && obj.is_ready_to_correct)  ;
-            obj.capi.Mode                   = scan_params.imaging_mode.daq_val(mc_is_ready_and_wanted)  ; % Scanning = 0; Pointing = 1; Pointing and MC = 2; Scanning and MC = 3% 
-            obj.capi.NumberpixelspointingNp = scan_params.num_voxels                                    ; 
-            obj.capi.use_varailble_length   = numel(unique(scan_params.voxels_for_ramp)) > 1            ;   
-            if obj.capi.use_varailble_length 
+            use_variable_length             = numel(unique(scan_params.voxels_for_ramp)) > 1            ;
+            
+            %% Registers are sent in one call (if changed), then the FIFO if required
+            tr = RegisterTransaction(obj.capi);
+            tr.write('Mode'                  , scan_params.imaging_mode.daq_val(mc_is_ready_and_wanted)); % Scanning = 0; Pointing = 1; Pointing and MC = 2; Scanning and MC = 3% 
+            tr.write('NumberpixelspointingNp', scan_params.num_voxels                                   ); 
+            tr.write('use_varailble_length'  , use_variable_length                                      );
+            if ~use_variable_length
+                tr.write('xpixelsperlineNpx' , scan_params.voxels_for_ramp(1)                           );
+            end
+            tr.write('ypixelsperlineNpy'     , scan_params.num_drives                                   );
+            tr.write('sampsperpixP'          , aol_params.daq_clock_freq * aol_params.discretize(scan_params.voxel_time));
+            tr.write('RepeatNumberofCycles'  , number_of_cycles                                         ); % Number of cycles to repeat. 
+            tr.commit();
+            if use_variable_length 
                 obj.capi.VARIABLELENGTHFIFO.write(uint16(scan_params.voxels_for_ramp), obj.timeout)     ;              
-            else
-                obj.capi.xpixelsperlineNpx  = scan_params.voxels_for_ramp(1)                            ;
             end
-            
-            obj.capi.ypixelsperlineNpy      = scan_params.num_drives                                    ;
-            obj.capi.sampsperpixP           = aol_params.daq_clock_freq * aol_params.discretize(scan_params.voxel_time);
-            obj.capi.RepeatNumberofCycles   = number_of_cycles                                          ; % Number of cycles to repeat. 
             obj.scan_cycles                 = 2 * scan_params.voxel_time / 1e-8                         ; % For signal normalization
         end
         
@@ -248,51 +262,66 @@ classdef update_daq_parameters < handle
             % - For now, the xy ref is squared
             % - For now, N voxel for Z lines is equivalent to XY length
             % - For now, Z dwell time is the same than XY dwell time
+            % - All registers are sent in a single call (see
+            %   RegisterTransaction). Derived values are computed locally
+            %   rather than read back from the capi.
+            % - stop_background is a command rather than a setting, so it
+            %   is always sent, bypassing the register shadow.
             % -------------------------------------------------------------
             % Author(s):
             %   Vicky Griffiths, Antoine Valera, Geoffrey Evans
             %---------------------------------------------
             % Revision Date:
-            %   13-03-2019
+            %   18-10-2026
+            
+            tr = RegisterTransaction(obj.capi);
+            timing                  = tr.read({'sampleswaitaftertrigger', 'AODfill'});
+            dwell_cycles            = aol_params.daq_clock_freq * aol_params.discretize(scan_params.voxel_time); % dwell time in cycles
+            ref_pixels_per_line     = scan_params.voxels_for_ramp(1);
             
             %% That is set to a fixed value for now
-            obj.capi.mc_delayprog = ( obj.capi.sampleswaitaftertrigger -...
-                                     (obj.capi.AODfill + 200))              ; %qq 200 is the number of cycles the trigger takes to propgate through the controller before we see a signal (V.G.)
-            if obj.capi.mc_delayprog < 10
-                obj.capi.mc_delayprog       = 10                            ; 
+            mc_delayprog            = timing(1) - (timing(2) + 200) ; %qq 200 is the number of cycles the trigger takes to propgate through the controller before we see a signal (V.G.)
+            if mc_delayprog < 10
+                mc_delayprog        = 10                            ; 
             end
-            obj.capi.sampleswaitafterpulse  = obj.capi.sampleswaitaftertrigger + obj.bkg_MC_live_MC_offset; % fix an offset between MC during imaging and background MC
-            obj.capi.stop_background        = false                         ;
-            obj.capi.suppres_mc             = 1                             ; % Supress MC in the last N lines. Prevent MC to kick in a the end of the frame. best value TBD. 0 crashes in some cases
-            obj.capi.Averageoffsets         = obj.Averageoffsets            ;
+            tr.write('mc_delayprog'         , mc_delayprog                  );
+            tr.write('sampleswaitafterpulse', timing(1) + obj.bkg_MC_live_MC_offset); % fix an offset between MC during imaging and background MC
+            tr.write('suppres_mc'           , 1                             ); % Supress MC in the last N lines. Prevent MC to kick in a the end of the frame. best value TBD. 0 crashes in some cases
+            tr.write('Averageoffsets'       , obj.Averageoffsets            );
             
-            obj.capi.Average                = obj.average                   ; 
-            obj.capi.threshold_xy           = obj.threshold_xy              ;
-            obj.capi.threshold_z            = obj.threshold_z               ;
-            obj.capi.RefsampsperpixPr       = aol_params.daq_clock_freq * aol_params.discretize(scan_params.voxel_time); % dwell time in cycles
-            obj.capi.RefxpixelsperlineNpxr  = scan_params.voxels_for_ramp(1);
-            obj.capi.RefypixelsperlineNpyr  = scan_params.voxels_for_ramp(1);
-            obj.capi.RefScanCycles          = ceil(obj.board_speed * obj.MC_rate)   ; 
-            obj.capi.Refcountresetenabled   = obj.refcountresetenabled      ; 
-            obj.capi.Integral_scale         = obj.Integral_scale            ;
-            obj.capi.diff_thresh_x10        = obj.diff_thresh_x10           ;
-            obj.capi.proportianal_x10       = obj.proportianal_x10          ;
-            obj.capi.scan_int_x1000         = obj.MC_rate                   ;
-            obj.capi.useslidingaverage      = obj.sliding_average           ;
-            obj.capi.ref_diff_x_y           = obj.ref_diff_x_y              ;
+            tr.write('Average'              , obj.average                   ); 
+            tr.write('threshold_xy'         , obj.threshold_xy              );
+            tr.write('threshold_z'          , obj.threshold_z               );
+            tr.write('RefsampsperpixPr'     , dwell_cycles                  );
+            tr.write('RefxpixelsperlineNpxr', ref_pixels_per_line           );
+            tr.write('RefypixelsperlineNpyr', ref_pixels_per_line           );
+            tr.write('RefScanCycles'        , ceil(obj.board_speed * obj.MC_rate)); 
+            tr.write('Refcountresetenabled' , obj.refcountresetenabled      ); 
+            tr.write('Integral_scale'       , obj.Integral_scale            );
+            tr.write('diff_thresh_x10'      , obj.diff_thresh_x10           );
+            tr.write('proportianal_x10'     , obj.proportianal_x10          );
+            tr.write('scan_int_x1000'       , obj.MC_rate                   );
+            tr.write('useslidingaverage'    , obj.sliding_average           );
+            tr.write('ref_diff_x_y'         , obj.ref_diff_x_y              );
 
             %% Z MC var
-            obj.capi.Enable_ZMC             = obj.Z_Lines > 0               ;
-            obj.capi.Ref_z_lines            = uint16(obj.Z_Lines)           ;
-            obj.capi.ref_z_pixels_per_line  = uint16(obj.capi.RefxpixelsperlineNpxr);
-            obj.capi.Refsampsperpix_z       = obj.capi.RefsampsperpixPr     ;
-            obj.capi.AverageZ               = obj.AverageZ                  ;            
-            obj.capi.Integral_scale_z       = obj.Integral_scale_z          ;
-            obj.capi.proportianal_x10_z     = obj.proportianal_x10_z        ;
-            obj.capi.diff_thresh_x10_z      = obj.diff_thresh_x10_z         ;
-            obj.capi.swapz                  = obj.swapz                     ;
-            obj.capi.ignore_z_lines         = obj.ignore_z_lines            ;
-            obj.capi.ref_diff_z             = obj.ref_diff_z                ;
+            tr.write('Enable_ZMC'           , obj.Z_Lines > 0               );
+            tr.write('Ref_z_lines'          , obj.Z_Lines                   );
+            tr.write('ref_z_pixels_per_line', ref_pixels_per_line           );
+            tr.write('Refsampsperpix_z'     , dwell_cycles                  );
+            tr.write('AverageZ'             , obj.AverageZ                  );            
+            tr.write('Integral_scale_z'     , obj.Integral_scale_z          );
+            tr.write('proportianal_x10_z'   , obj.proportianal_x10_z        );
+            tr.write('diff_thresh_x10_z'    , obj.diff_thresh_x10_z         );
+            tr.write('swapz'                , obj.swapz                     );
+            tr.write('ignore_z_lines'       , obj.ignore_z_lines            );
+            tr.write('ref_diff_z'           , obj.ref_diff_z                );
+            tr.commit();
+            
+            %% Resume background MC, even if the shadow already says false
+            tr = RegisterTransaction(obj.capi, false);
+            tr.write('stop_background'      , false                         );
+            tr.commit();
         end  
         
         function setup_general_hardware_triggers(obj)
@@ -309,41 +338,47 @@ classdef update_daq_parameters < handle
             % Extra Notes: 
             % Adjust some extra Trigger settings We currently don't use all
             % the abilities of the system in matlab
+            % Trigger registers are always sent, bypassing the register
+            % shadow.
             % -------------------------------------------------------------
             % Author(s):
             %   Antoine Valera.
             %---------------------------------------------
             % Revision Date:
-            %   23-03-2018
+            %   18-10-2026
+            
+            tr = RegisterTransaction(obj.capi, false);
+            live_scan = obj.capi.live_scan;
             
             %% At this stage, live_scan is already true
-            if obj.capi.live_scan
-                obj.capi.ImagingProtocol            = 5                     ;     
+            if live_scan
+                tr.write('ImagingProtocol'              , 5             );     
             else
-                obj.capi.ImagingProtocol            = 2                     ; 
+                tr.write('ImagingProtocol'              , 2             ); 
             end
             
             %% Set the type of trail start Trigger (PXI_Trig1)
             % 0 for start trigger, 1 for line trigger, 2 for ref ref frame
             % acknowledgement (MC).
-            obj.capi.Trigger1function               = 0                     ; 
-            obj.capi.Trigger1selector               = 0                     ;
+            tr.write('Trigger1function'                 , 0             ); 
+            tr.write('Trigger1selector'                 , 0             );
             
             %% Enabling all triggers
-            obj.capi.EnableTrigger1                 = 1                     ; % Encoder trigger/line trigger, PXI_Trig2
-            obj.capi.PulsewidthticksLineTrig        = 800                   ;
+            tr.write('EnableTrigger1'                   , 1             ); % Encoder trigger/line trigger, PXI_Trig2
+            tr.write('PulsewidthticksLineTrig'          , 800           );
 
-            obj.capi.EnableTrigger2                 = 1                     ; % Frame trigger, PXI_Trig2
-            obj.capi.PulsewidthticksFrameCycleTrig  = 800                   ;
+            tr.write('EnableTrigger2'                   , 1             ); % Frame trigger, PXI_Trig2
+            tr.write('PulsewidthticksFrameCycleTrig'    , 800           );
 
-            obj.capi.EnableTrigger3                 = 1                     ; % trial trigger, PXI_Trig3
-            obj.capi.PulsewidthticksTrialtrig       = 800                   ;
+            tr.write('EnableTrigger3'                   , 1             ); % trial trigger, PXI_Trig3
+            tr.write('PulsewidthticksTrialtrig'         , 800           );
 
             %obj.capi.EnableTrigger4 = 1; %% Start of exp trigger, PXI_Trig4 moved in Base.m
-            obj.capi.PulsewidthticksStartofExptrig  = 800;
+            tr.write('PulsewidthticksStartofExptrig'    , 800           );
 
             %% Other trigger stuff that may not be related
-            obj.capi.live_scantriggersmodule        = obj.capi.live_scan    ; % --> Check with Vicky/Sameer ; to enable for live_scan trigger
+            tr.write('live_scantriggersmodule'          , live_scan     ); % --> Check with Vicky/Sameer ; to enable for live_scan trigger
+            tr.commit();
         end
         
         function start_mc(obj, ~, ~)
@@ -2,6 +2,7 @@
 %
 % Toolbox functions
 %   NiFpga2Matlab     - Generate Matlab class from NI FPGA applications
+%   NiFpga2Cpp        - Generate the C++ register table of the mex file
 %   NiFpga_mex        - Compile NiFpga.mex
 %   status2msg        - Convert NI FPGA status to a textual message
 % Auxilliary
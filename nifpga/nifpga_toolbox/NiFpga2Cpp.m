@@ -0,0 +1,181 @@
+%% Generate a typed C++ register table from a NI FPGA C API header
+%   Parse the NiFpga_*.h header generated by the FPGA Interface C API
+%   Generator and write a header of constexpr register and FIFO
+%   descriptions (name, address, type, control/indicator, array size).
+%   NiFpga_mex.cpp includes it, so native threads can access registers
+%   without going through the Matlab CAPI, and RegisterTransaction gets its
+%   register map from the mex file (NiFpga function 213).
+%
+% -------------------------------------------------------------------------
+% Syntax:
+%   NiFpga2Cpp(header, output)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   header(STR):
+%                                   Path to the NiFpga_<VI name>.h file, for
+%                                   any bitfile version.
+%
+%   output(STR) - Optional - Default is capi/NiFpga_registers.h:
+%                                   Path of the generated C++ header.
+% -------------------------------------------------------------------------
+% Outputs:
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * NiFpga2Matlab calls this function, so that the Matlab CAPI class and
+%   the C++ table always come from the same header. After a bitfile
+%   update, recompile the mex file (capi/compile_nifpga.m).
+%
+% * Labels are used as C++ identifiers, with the same l_ prefix as
+%   NiFpga2Matlab for labels that do not start with a letter. Labels that
+%   are C++ keywords get a trailing underscore.
+%
+% * Registers are in fpga::reg, FIFOs in fpga::fifo. fpga::registers and
+%   fpga::fifos list all of them, e.g. for lookups by name.
+% -------------------------------------------------------------------------
+% Examples:
+% * Regenerate the table for the current bitfile
+%   NiFpga2Cpp('NiFpga_FPGADAQ_variable_length_matlab_v13.h');
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: NiFpga2Matlab, RegisterTransaction, compile_nifpga
+
+function NiFpga2Cpp(header, output)
+    if nargin < 2 || isempty(output)
+        output = fullfile(fileparts(mfilename('fullpath')), 'capi', 'NiFpga_registers.h');
+    end
+
+    %% Read header
+    if ~exist(header, 'file')
+        error('NiFpga:file', 'Could not open file %s', header);
+    end
+    hfile       = fileread(header);
+    [~, prefix, ext] = fileparts(header);
+    casts       = {'Bool', 'I8', 'U8', 'I16', 'U16', 'I32', 'U32', 'I64', 'U64'};
+
+    bitfile     = regexp(hfile, ['#define\s', prefix, '_Bitfile\s"(\S+)"'], 'tokens', 'once');
+    signature   = regexp(hfile, [prefix, '_Signature\s?=\s?"(\S+)"'], 'tokens', 'once');
+    if isempty(bitfile) || isempty(signature)
+        error('NiFpga:file', 'No bitfile or signature found in %s', header);
+    end
+
+    %% Collect Indicator and Control items, and array sizes
+    registers   = regexp(hfile, [prefix, '_(?<kind>Control|Indicator)(?<dim>Array)?(?<cast>Bool|[UI]\d+)_(?<label>\w+)\s=\s(?<address>0x[0-9A-Fa-f]+),'], 'names');
+    sizes       = regexp(hfile, [prefix, '_(?<kind>Control|Indicator)Array(?<cast>Bool|[UI]\d+)Size_(?<label>\w+)\s=\s(?<size>\d+)'], 'names');
+    fifos       = regexp(hfile, [prefix, '_(?<kind>TargetToHost|HostToTarget)Fifo(?<cast>Bool|[UI]\d+)_(?<label>\w+)\s=\s(?<address>\d+)'], 'names');
+
+    %% Format entries
+    reg_lines   = cell(numel(registers), 1);
+    for idx = 1:numel(registers)
+        item    = registers(idx);
+        n_elem  = '0';
+        if ~isempty(item.dim)
+            match = sizes(strcmp({sizes.label}, item.label) & strcmp({sizes.kind}, item.kind));
+            n_elem = match(1).size;
+        end
+        registers(idx).label = cpp_label(item.label);
+        reg_lines{idx} = sprintf('        constexpr register_info %s = { "%s", %s, %s, %s, %s };',...
+                                 registers(idx).label, item.label, item.address, item.cast,...
+                                 bool_str(strcmp(item.kind, 'Control')), n_elem);
+    end
+    fifo_lines  = cell(numel(fifos), 1);
+    for idx = 1:numel(fifos)
+        item    = fifos(idx);
+        fifos(idx).label = cpp_label(item.label);
+        fifo_lines{idx} = sprintf('        constexpr fifo_info %s = { "%s", %s, %s, %s };',...
+                                  fifos(idx).label, item.label, item.address, item.cast,...
+                                  bool_str(strcmp(item.kind, 'HostToTarget')));
+    end
+
+    %% Write output
+    fid = fopen(output, 'wt');
+    if fid == -1
+        error('NiFpga:file', 'Could not open file %s', output);
+    end
+    fprintf(fid, '/*\n');
+    fprintf(fid, ' * Generated by NiFpga2Cpp.m from %s%s. DO NOT EDIT!\n', prefix, ext);
+    fprintf(fid, ' * Regenerate it when the bitfile changes, and recompile the mex file.\n');
+    fprintf(fid, ' */\n\n');
+    fprintf(fid, '#ifndef __NiFpga_registers_h__\n#define __NiFpga_registers_h__\n\n#include <stdint.h>\n\n');
+    fprintf(fid, 'namespace fpga\n{\n');
+    fprintf(fid, '    enum register_type { %s };\n\n', strjoin(strcat(casts, {' = '}, arrayfun(@num2str, 0:8, 'UniformOutput', false)), ', '));
+    fprintf(fid, '    struct register_info\n    {\n');
+    fprintf(fid, '        const char* name;\n        uint32_t address;\n        register_type type;\n');
+    fprintf(fid, '        bool control;           // false for indicators\n');
+    fprintf(fid, '        uint32_t size;          // number of elements, 0 for scalars\n    };\n\n');
+    fprintf(fid, '    struct fifo_info\n    {\n');
+    fprintf(fid, '        const char* name;\n        uint32_t address;\n        register_type type;\n');
+    fprintf(fid, '        bool host_to_target;\n    };\n\n');
+    fprintf(fid, '    // NiFpga mex function codes, as in the Matlab CAPI\n');
+    fprintf(fid, '    constexpr uint32_t read_code(const register_info& r) { return (r.size ? 300 : 100) + r.type; }\n');
+    fprintf(fid, '    constexpr uint32_t write_code(const register_info& r) { return r.control ? (r.size ? 400 : 200) + r.type : 0; }\n\n');
+    fprintf(fid, '    constexpr const char* bitfile = "%s";\n', bitfile{1});
+    fprintf(fid, '    constexpr const char* signature = "%s";\n\n', signature{1});
+    fprintf(fid, '    namespace reg\n    {\n%s\n    }\n\n', strjoin(reg_lines', '\n'));
+    fprintf(fid, '    namespace fifo\n    {\n%s\n    }\n\n', strjoin(fifo_lines', '\n'));
+    write_table(fid, 'register_info', 'registers', 'reg', {registers.label}, '{ "", 0, U32, false, 0 }');
+    write_table(fid, 'fifo_info', 'fifos', 'fifo', {fifos.label}, '{ "", 0, U32, false }');
+    fprintf(fid, '}\n\n#endif\n');
+    fclose(fid);
+    fprintf(1, '%s generated (%d registers, %d fifos)\n', output, numel(registers), numel(fifos));
+end
+
+function write_table(fid, type, name, space, labels, placeholder)
+    %% constexpr array of all items, with a placeholder if there are none
+    if isempty(labels)
+        entries = {placeholder};
+    else
+        entries = strcat(space, '::', labels);
+    end
+    fprintf(fid, '    constexpr %s %s[] = {\n        %s\n    };\n', type, name, strjoin(entries, [',\n', blanks(8)]));
+    fprintf(fid, '    constexpr uint32_t n_%s = %d;\n\n', name, numel(labels));
+end
+
+function label = cpp_label(label)
+    %% Valid C++ identifier, consistent with NiFpga2Matlab
+    keywords = {'auto', 'bool', 'break', 'case', 'char', 'class', 'const', 'continue', 'default',...
+                'delete', 'do', 'double', 'else', 'enum', 'float', 'for', 'goto', 'if', 'int',...
+                'long', 'new', 'private', 'public', 'register', 'return', 'short', 'signed',...
+                'static', 'struct', 'switch', 'this', 'union', 'unsigned', 'void', 'volatile', 'while'};
+    c = lower(label(1));
+    if c < 'a' || c > 'z'
+        label = ['l_', label];
+    end
+    if ismember(label, keywords)
+        label = [label, '_'];
+    end
+end
+
+function str = bool_str(value)
+    if value
+        str = 'true';
+    else
+        str = 'false';
+    end
+end
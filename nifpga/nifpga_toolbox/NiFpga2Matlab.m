@@ -74,6 +74,9 @@ function NiFpga2Matlab(FileNames, ClassName)
         fprintf(1, 'Class C%s generated\n', FileNames{iFile});
     end
 
+    % write the C++ register table compiled in the mex file
+    NiFpga2Cpp(sprintf('NiFpga_%s.h', FileNames{1}));
+
     %% Move the files one level up
     if isempty(ClassName)
         if ~already_in_folder
@@ -83,7 +86,7 @@ function NiFpga2Matlab(FileNames, ClassName)
         movefile([path, '\NiFpga_', FileNames{1}, '.lvbitx'],[newpath, '\NiFpga_', FileNames{1}, '.lvbitx'],'f');
         movefile([path, '\NiFpga_', FileNames{1}, '.h'],[newpath, '\NiFpga_', FileNames{1}, '.h'],'f'); 
         movefile([path, '\C', FileNames{1}, '.m'],[newpath, '\C', FileNames{1}, '.m'],'f');  
-        error_box('You need now to update the appropriate DaQFpga*.m files with the new ',FileNames{1},' . Previous bitfiles (.h and .lvbit files) can be deleted too. You MUST restart matlab',1)
+        error_box(['You need now to update the appropriate DaQFpga*.m files with the new ',FileNames{1},' and recompile the mex file (capi/compile_nifpga.m). Previous bitfiles (.h and .lvbit files) can be deleted too. You MUST restart matlab'],1)
     end
 
 end
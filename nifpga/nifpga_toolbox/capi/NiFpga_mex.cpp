@@ -1,9 +1,13 @@
 #include "NiFpga.h"
+#include "NiFpga_registers.h" // generated by NiFpga2Cpp.m
 #include <mex.h>
 #include <string.h>
+#include <stdlib.h>
+#include <math.h>
 #include "pipe.h"
 #include "pthread.h"
 #include <windows.h>
+#include <mmsystem.h> // timeBeginPeriod, link with winmm
 #ifdef __cplusplus //need to link against "$matlabPATH\extern\lib\win64\microsoft\libut.lib" or "$matlabPATH\extern\lib\win32\microsoft\libut.lib"
 extern "C" bool utIsInterruptPending();
 #else
@@ -28,6 +32,329 @@ typedef struct {
 
 static read_ctx ctx;
 
+//cf case 5070 to 5075 for MC register sampling
+#define MC_MAX_REGISTERS 16
+#define MC_RING_SIZE 262144 // power of 2. > 50 s at 5 kHz
+#define MC_EVENT_RING_SIZE 16384 // power of 2
+
+typedef struct {
+    double t; // s, since sampler start
+    int32_t values[MC_MAX_REGISTERS];
+} mc_sample;
+
+typedef struct {
+    double t; // s, since sampler start
+    uint32_t reg; // register index, as passed to 5070
+    int32_t value; // new value
+} mc_event;
+
+typedef struct {
+    NiFpga_Session session;
+    uint32_t n_registers;
+    uint32_t addresses[MC_MAX_REGISTERS];
+    uint32_t types[MC_MAX_REGISTERS]; // NiFpga Read function code, 100 to 106 (Bool to U32)
+    double period_s;
+    mc_sample* ring;                  // single producer (sampler thread), single consumer (5071)
+    volatile uint64_t write_idx;
+    volatile uint64_t read_idx;
+    volatile uint32_t n_overflow;     // samples dropped because the ring was full
+    volatile uint32_t n_late;         // samples taken more than one period late
+    uint32_t event_mask;              // bit r set if register r generates an event when it changes
+    mc_event* events;                 // single producer (sampler thread), single consumer (5074)
+    volatile uint64_t event_write_idx;
+    volatile uint64_t event_read_idx;
+    volatile uint32_t n_event_overflow;
+    LARGE_INTEGER freq;
+    LARGE_INTEGER t0;                 // sampler start, on the QueryPerformanceCounter clock
+    double acq_t0;                    // acquisition start, in s since sampler start (see 5073). NaN if not set
+    volatile bool stop;
+    uint32_t id;
+    bool running;
+    pthread_t thread;
+} mc_sampler_ctx;
+
+static mc_sampler_ctx mc_ctx = {};
+
+//cf case 110 and 210 for batch register access
+static NiFpga_Status read_register(NiFpga_Session session, uint32_t address, uint32_t type, double* value)
+{
+    NiFpga_Status status = NiFpga_Status_InvalidParameter;
+    *value = 0;
+    switch (type) // NiFpga Read function code, 100 to 108 (Bool to U64)
+    {
+    case 100: { NiFpga_Bool v = 0; status = NiFpga_ReadBool(session, address, &v); *value = v; break; }
+    case 101: { int8_t v = 0;   status = NiFpga_ReadI8(session, address, &v);  *value = v; break; }
+    case 102: { uint8_t v = 0;  status = NiFpga_ReadU8(session, address, &v);  *value = v; break; }
+    case 103: { int16_t v = 0;  status = NiFpga_ReadI16(session, address, &v); *value = v; break; }
+    case 104: { uint16_t v = 0; status = NiFpga_ReadU16(session, address, &v); *value = v; break; }
+    case 105: { int32_t v = 0;  status = NiFpga_ReadI32(session, address, &v); *value = v; break; }
+    case 106: { uint32_t v = 0; status = NiFpga_ReadU32(session, address, &v); *value = v; break; }
+    case 107: { int64_t v = 0;  status = NiFpga_ReadI64(session, address, &v); *value = (double)v; break; }
+    case 108: { uint64_t v = 0; status = NiFpga_ReadU64(session, address, &v); *value = (double)v; break; }
+    }
+    return status;
+}
+
+static double to_range(double value, double low, double high) // round and saturate, like matlab integer casts
+{
+    if (value != value) return 0;
+    value = value < 0 ? ceil(value - 0.5) : floor(value + 0.5);
+    return value < low ? low : (value > high ? high : value);
+}
+
+static double cast_register_value(uint32_t type, double value) // value as stored in the register
+{
+    switch (type) // NiFpga Write function code, 200 to 208 (Bool to U64)
+    {
+    case 200: return value != 0;
+    case 201: return to_range(value, -128, 127);
+    case 202: return to_range(value, 0, 255);
+    case 203: return to_range(value, -32768, 32767);
+    case 204: return to_range(value, 0, 65535);
+    case 205: return to_range(value, -2147483648.0, 2147483647.0);
+    case 206: return to_range(value, 0, 4294967295.0);
+    case 207: return to_range(value, -9223372036854775808.0, 9223372036854774784.0);
+    case 208: return to_range(value, 0, 18446744073709549568.0);
+    default:  return value;
+    }
+}
+
+static NiFpga_Status write_register(NiFpga_Session session, uint32_t address, uint32_t type, double value)
+{
+    value = cast_register_value(type, value);
+    switch (type)
+    {
+    case 200: return NiFpga_WriteBool(session, address, value != 0);
+    case 201: return NiFpga_WriteI8(session, address, (int8_t)value);
+    case 202: return NiFpga_WriteU8(session, address, (uint8_t)value);
+    case 203: return NiFpga_WriteI16(session, address, (int16_t)value);
+    case 204: return NiFpga_WriteU16(session, address, (uint16_t)value);
+    case 205: return NiFpga_WriteI32(session, address, (int32_t)value);
+    case 206: return NiFpga_WriteU32(session, address, (uint32_t)value);
+    case 207: return NiFpga_WriteI64(session, address, (int64_t)value);
+    case 208: return NiFpga_WriteU64(session, address, (uint64_t)value);
+    default:  return NiFpga_Status_InvalidParameter;
+    }
+}
+
+//cf case 210, 211 and 212 for the control register shadow
+#define SHADOW_SIZE 1024 // power of 2, more than the number of controls of all open sessions
+
+typedef struct {
+    NiFpga_Session session;
+    uint32_t address;
+    bool used;
+    bool valid;       // false until written, and after Open, Close, Run, Reset or Download
+    double value;     // last value written, after cast
+} shadow_entry;
+
+static shadow_entry shadow[SHADOW_SIZE];
+static uint32_t shadow_count = 0;
+static double shadow_stats[3] = {0}; // batch writes sent, batch writes skipped, invalidations
+
+static shadow_entry* shadow_slot(NiFpga_Session session, uint32_t address) // open addressing, keyed on (session, address). NULL if the table is full
+{
+    uint32_t i = ((address ^ (session * 0x9E3779B9u)) * 2654435761u) & (SHADOW_SIZE - 1);
+    for (uint32_t probe = 0; probe < SHADOW_SIZE; probe++, i = (i + 1) & (SHADOW_SIZE - 1))
+    {
+        if (!shadow[i].used || (shadow[i].session == session && shadow[i].address == address))
+            return &shadow[i];
+    }
+    return NULL;
+}
+
+static void shadow_store(NiFpga_Session session, uint32_t address, double value, NiFpga_Status status)
+{
+    shadow_entry* entry = shadow_slot(session, address);
+    if (!entry) return;
+    if (!entry->used)
+    {
+        entry->used = true;
+        entry->session = session;
+        entry->address = address;
+        shadow_count++;
+    }
+    entry->valid = NiFpga_IsNotError(status);
+    entry->value = value;
+}
+
+static void shadow_invalidate(NiFpga_Session session) // after Run, Reset or Download, only this session's values are stale
+{
+    for (uint32_t i = 0; i < SHADOW_SIZE; i++)
+    {
+        if (shadow[i].used && shadow[i].session == session)
+            shadow[i].valid = false;
+    }
+    shadow_stats[2]++;
+}
+
+static void shadow_release(NiFpga_Session session) // after Open or Close, the handle may be reused. Entries of the other sessions are rehashed
+{
+    static shadow_entry previous[SHADOW_SIZE];
+    memcpy(previous, shadow, sizeof(shadow));
+    memset(shadow, 0, sizeof(shadow));
+    shadow_count = 0;
+    for (uint32_t i = 0; i < SHADOW_SIZE; i++)
+    {
+        if (previous[i].used && previous[i].session != session)
+        {
+            shadow_entry* entry = shadow_slot(previous[i].session, previous[i].address);
+            *entry = previous[i];
+            shadow_count++;
+        }
+    }
+    shadow_stats[2]++;
+}
+
+static int fifo_pipe_index(uint32_t address) // pipe filled by move_fifo_to_pipe for a FIFO address, -1 if unknown
+{
+    if (address == fpga::fifo::Channel1.address) return 0;
+    if (address == fpga::fifo::Channel0.address) return 1;
+    return -1;
+}
+
+static int32_t read_mc_register(NiFpga_Session session, uint32_t address, uint32_t type)
+{
+    double v = 0;
+    read_register(session, address, type, &v);
+    return (int32_t)v;
+}
+
+static double qpc_time() // s, on the QueryPerformanceCounter clock (monotonic)
+{
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+}
+
+static double posix_time() // s since 1970-01-01, at the best available system clock resolution
+{
+    FILETIME ft;
+    ULARGE_INTEGER t;
+    GetSystemTimePreciseAsFileTime(&ft);
+    t.LowPart = ft.dwLowDateTime;
+    t.HighPart = ft.dwHighDateTime;
+    return (double)(t.QuadPart - 116444736000000000ULL) * 1e-7; // 100 ns since 1601 to s since 1970
+}
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002 // Windows 10 1803 and later
+#endif
+
+static double mc_sampler_time(const mc_sampler_ctx* context) // s, since sampler start
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)(now.QuadPart - context->t0.QuadPart) / (double)context->freq.QuadPart;
+}
+
+static void push_mc_event(mc_sampler_ctx* context, double t, uint32_t reg, int32_t value)
+{
+    if (context->event_write_idx - context->event_read_idx >= MC_EVENT_RING_SIZE)
+    {
+        context->n_event_overflow++;
+        return;
+    }
+    mc_event* event = &context->events[context->event_write_idx & (MC_EVENT_RING_SIZE - 1)];
+    event->t = t;
+    event->reg = reg;
+    event->value = value;
+    MemoryBarrier(); // event must be complete before the consumer sees it
+    context->event_write_idx++;
+}
+
+static void* sample_mc_registers(void* arg) // read MC registers at a fixed rate, push to ring
+{
+    mc_sampler_ctx* context = (mc_sampler_ctx*)arg;
+    int32_t previous[MC_MAX_REGISTERS];
+    bool first = true;
+    double t, next = 0;
+    LARGE_INTEGER due;
+
+    // Block on a waitable timer between samples instead of spinning. High
+    // resolution timers are not available before Windows 10 1803. Then
+    // use a standard one, with the system timer resolution set to 1 ms
+    bool coarse = false;
+    HANDLE wait_timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!wait_timer)
+    {
+        coarse = true;
+        timeBeginPeriod(1);
+        wait_timer = CreateWaitableTimer(NULL, TRUE, NULL);
+    }
+
+    while (!context->stop)
+    {
+        // Wait for the next sample
+        t = mc_sampler_time(context);
+        if (t < next)
+        {
+            due.QuadPart = -(LONGLONG)((next - t) * 1e7); // relative, in 100 ns
+            if (due.QuadPart < 0 && SetWaitableTimer(wait_timer, &due, 0, NULL, NULL, FALSE))
+            {
+                WaitForSingleObject(wait_timer, 100);
+            }
+            continue;
+        }
+        if (t - next > context->period_s)
+        {
+            context->n_late++;
+            next = t; // resync instead of bursting to catch up
+        }
+        next += context->period_s;
+
+        // Sample all registers
+        mc_sample sample;
+        sample.t = t;
+        for (uint32_t r = 0; r < context->n_registers; r++)
+        {
+            sample.values[r] = read_mc_register(context->session, context->addresses[r], context->types[r]);
+        }
+
+        // Publish changes of the event registers (lost / recovered tracking), even if the sample ring is full
+        for (uint32_t r = 0; r < context->n_registers; r++)
+        {
+            if (((context->event_mask >> r) & 1) && !first && sample.values[r] != previous[r])
+            {
+                push_mc_event(context, t, r, sample.values[r]);
+            }
+            previous[r] = sample.values[r];
+        }
+        first = false;
+
+        if (context->write_idx - context->read_idx >= MC_RING_SIZE)
+        {
+            context->n_overflow++;
+            continue;
+        }
+        context->ring[context->write_idx & (MC_RING_SIZE - 1)] = sample;
+        MemoryBarrier(); // sample must be complete before the consumer sees it
+        context->write_idx++;
+    }
+
+    CloseHandle(wait_timer);
+    if (coarse)
+    {
+        timeEndPeriod(1);
+    }
+    return 0;
+}
+
+static void stop_mc_sampler()
+{
+    if (mc_ctx.running)
+    {
+        mc_ctx.stop = true;
+        pthread_join(mc_ctx.thread, NULL);
+        free(mc_ctx.ring);
+        free(mc_ctx.events);
+        mc_ctx.ring = NULL;
+        mc_ctx.events = NULL;
+        mc_ctx.running = false;
+    }
+}
+
 //cf case 5060, 5061, 5062 for NiFPGA read
 void clean_up_fifos(pipe_producer_t* out1, pipe_producer_t* out2){ 
     //mexPrintf("        ...C PIPE : Stopping pipes thread...\n");
@@ -78,15 +405,14 @@ static void* move_fifo_to_pipe(void* ctx) // copy from fifo to pipe
 			break;
 		}
 
-        // Warning - If you change the FIFOs (number, name etc...), you  may 
-        // need to adjust the memory adresses to match the compiled lvbitx file
-        // There is also a change to do in Read pipe (fcn 5061)
-        status = NiFpga_ReadFifoU32(context->session, (uint32_t)2, data1, nElemVariable1, timeout, &elemRemaining1); 
+        // FIFO addresses come from NiFpga_registers.h. If you rename the
+        // FIFOs in the bitfile, regenerate it and adjust the names here
+        status = NiFpga_ReadFifoU32(context->session, fpga::fifo::Channel1.address, data1, nElemVariable1, timeout, &elemRemaining1); 
         if (status != 0)
         {
             mexPrintf("%i ...\n", status);
         }
-        status = NiFpga_ReadFifoU32(context->session, (uint32_t)3, data2, nElemVariable2, timeout, &elemRemaining2);
+        status = NiFpga_ReadFifoU32(context->session, fpga::fifo::Channel0.address, data2, nElemVariable2, timeout, &elemRemaining2);
         if (status != 0)
         {
             mexPrintf("%i ...\n", status);
@@ -150,6 +476,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		plhs[1] = mxCreateNumericMatrix(1,1,mxUINT32_CLASS,mxREAL);
 		NiFpga_Session * session = (NiFpga_Session *)mxGetData(plhs[1]);
 		*status = NiFpga_Open(bitfile, signature, resource, attribute, session);
+		shadow_release(*session);
 		mxFree(bitfile);
 		mxFree(signature);
 		mxFree(resource);
@@ -160,6 +487,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
         NiFpga_Session session = *(NiFpga_Session*)mxGetData(prhs[1]);
 		uint32_t attribute = *(uint32_t*)mxGetData(prhs[2]);
 		*status = NiFpga_Close(session, attribute);
+		shadow_release(session);
 		break;
 	}
 	case 4: // Run
@@ -167,6 +495,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
         NiFpga_Session session = *(NiFpga_Session*)mxGetData(prhs[1]);
 		uint32_t attribute = *(uint32_t*)mxGetData(prhs[2]);
 		*status = NiFpga_Run(session, attribute);
+		shadow_invalidate(session);
 		break;
 	}
 	case 5: // Abort
@@ -179,12 +508,14 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 	{
         NiFpga_Session session = *(NiFpga_Session*)mxGetData(prhs[1]);
 		*status = NiFpga_Reset(session);
+		shadow_invalidate(session);
 		break;
 	}
 	case 7: // Download
 	{
         NiFpga_Session session = *(NiFpga_Session*)mxGetData(prhs[1]);
 		*status = NiFpga_Download(session);
+		shadow_invalidate(session);
 		break;
 	}	
 	case 8: // Reserve Irq Context
@@ -331,6 +662,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		NiFpga_Bool value = *(NiFpga_Bool *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteBool(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 201: // WriteI8
@@ -339,6 +671,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		int8_t value = *(int8_t *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteI8(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 202: // WriteU8
@@ -347,6 +680,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		uint8_t value = *(uint8_t *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteU8(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 203: // WriteI16
@@ -355,6 +689,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		int16_t value = *(int16_t *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteI16(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 204: // WriteU16
@@ -363,6 +698,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		uint16_t value = *(uint16_t *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteU16(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 205: // WriteI32
@@ -371,6 +707,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		int32_t value = *(int32_t *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteI32(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 206: // WriteU32
@@ -379,6 +716,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		uint32_t value = *(uint32_t *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteU32(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 207: // WriteI64
@@ -387,6 +725,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		int64_t value = *(int64_t *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteI64(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 208: // WriteU64
@@ -395,6 +734,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
 		uint64_t value = *(uint64_t *)mxGetData(prhs[3]);
 		*status = NiFpga_WriteU64(session, address, value);
+		shadow_store(session, address, (double)value, *status);
 		break;
 	}
 	case 300: // ReadArrayBool
@@ -704,8 +1044,10 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
             uint32_t *data = (uint32_t*)mxGetData(plhs[1]);
             plhs[2] = mxCreateNumericMatrix(1,1,mxUINT32_CLASS,mxREAL);
             size_t *elemRead = (size_t*)mxGetData(plhs[2]);
-            uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
-            *elemRead = pipe_pop_eager(pipe_reader[address - 2], data, nElem); // -2 because HW adresses are 2 and 3 for the FIFOs but we want idx 0 and 1
+            int pipe_idx = fifo_pipe_index(*(uint32_t*)mxGetData(prhs[2]));
+            if (pipe_idx < 0)
+                mexErrMsgTxt("Read pipe : unknown FIFO address, see NiFpga_registers.h");
+            *elemRead = pipe_pop_eager(pipe_reader[pipe_idx], data, nElem);
 //         }
 //         else {
 //            stop_threads = true; 
@@ -778,9 +1120,11 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
             uint32_t *data = (uint32_t*)mxGetData(plhs[1]);
             plhs[2] = mxCreateNumericMatrix(1,1,mxUINT32_CLASS,mxREAL);
             size_t *elemRead = (size_t*)mxGetData(plhs[2]);
-            uint32_t address = *(uint32_t*)mxGetData(prhs[2]);
-            *elemRead = pipe_pop_eager(pipe_reader[address - 2], data, nElem); // -2 because HW adresses are 2 and 3 for the FIFOs but we want idx 0 and 1
-            fwrite(data, sizeof(uint32_t), *elemRead, fp[address - 2]);
+            int pipe_idx = fifo_pipe_index(*(uint32_t*)mxGetData(prhs[2]));
+            if (pipe_idx < 0)
+                mexErrMsgTxt("Read pipe : unknown FIFO address, see NiFpga_registers.h");
+            *elemRead = pipe_pop_eager(pipe_reader[pipe_idx], data, nElem);
+            fwrite(data, sizeof(uint32_t), *elemRead, fp[pipe_idx]);
 //         }
 //         else {
 //            stop_threads = true; 
@@ -808,6 +1152,252 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
 		break;
 	}
     
+    case 110: // Batch read. Values are returned as double
+    {
+        // prhs[2] : register addresses, prhs[3] : NiFpga read codes (100-108)
+        // plhs[1] : values, plhs[2] : status of each read
+        NiFpga_Session session = *(NiFpga_Session*)mxGetData(prhs[1]);
+        size_t n = mxGetNumberOfElements(prhs[2]);
+        if (mxGetNumberOfElements(prhs[3]) != n)
+            mexErrMsgTxt("Batch read : addresses and read codes must have the same size");
+        const uint32_t* addresses = (const uint32_t*)mxGetData(prhs[2]);
+        const uint32_t* types = (const uint32_t*)mxGetData(prhs[3]);
+        plhs[1] = mxCreateDoubleMatrix(1, n, mxREAL);
+        plhs[2] = mxCreateNumericMatrix(1, n, mxINT32_CLASS, mxREAL);
+        double* values = mxGetPr(plhs[1]);
+        int32_t* statuses = (int32_t*)mxGetData(plhs[2]);
+        *status = NiFpga_Status_Success;
+        for (size_t i = 0; i < n; i++)
+        {
+            statuses[i] = read_register(session, addresses[i], types[i], &values[i]);
+            NiFpga_MergeStatus(status, statuses[i]);
+        }
+        break;
+    }
+    case 210: // Batch write. Values are passed as double and cast to each register type
+    {
+        // prhs[2] : register addresses, prhs[3] : NiFpga write codes (200-208), prhs[4] : values
+        // prhs[5] : optional, if false, write even if the shadow value is unchanged. Default is true
+        // plhs[1] : status of each write. Writes are done in order, and all of them are attempted
+        // plhs[2] : true for writes sent to the FPGA, false for writes skipped (unchanged value)
+        NiFpga_Session session = *(NiFpga_Session*)mxGetData(prhs[1]);
+        size_t n = mxGetNumberOfElements(prhs[2]);
+        if (mxGetNumberOfElements(prhs[3]) != n || mxGetNumberOfElements(prhs[4]) != n || !mxIsDouble(prhs[4]))
+            mexErrMsgTxt("Batch write : addresses, write codes and (double) values must have the same size");
+        bool use_shadow = nrhs < 6 || mxIsLogicalScalarTrue(prhs[5]);
+        const uint32_t* addresses = (const uint32_t*)mxGetData(prhs[2]);
+        const uint32_t* types = (const uint32_t*)mxGetData(prhs[3]);
+        const double* values = mxGetPr(prhs[4]);
+        plhs[1] = mxCreateNumericMatrix(1, n, mxINT32_CLASS, mxREAL);
+        plhs[2] = mxCreateLogicalMatrix(1, n);
+        int32_t* statuses = (int32_t*)mxGetData(plhs[1]);
+        mxLogical* sent = mxGetLogicals(plhs[2]);
+        *status = NiFpga_Status_Success;
+        for (size_t i = 0; i < n; i++)
+        {
+            double value = cast_register_value(types[i], values[i]);
+            shadow_entry* entry = shadow_slot(session, addresses[i]);
+            if (use_shadow && entry && entry->valid && entry->value == value)
+            {
+                shadow_stats[1]++;
+                continue;
+            }
+            statuses[i] = write_register(session, addresses[i], types[i], value);
+            NiFpga_MergeStatus(status, statuses[i]);
+            shadow_store(session, addresses[i], value, statuses[i]);
+            sent[i] = true;
+            shadow_stats[0]++;
+        }
+        break;
+    }
+    case 211: // Shadow statistics
+    {
+        // prhs[2] : optional, if true, reset the counters after reading them
+        // plhs[1] : [batch writes sent, batch writes skipped, invalidations, registers in the shadow (all sessions)]
+        plhs[1] = mxCreateDoubleMatrix(1, 4, mxREAL);
+        double* stats = mxGetPr(plhs[1]);
+        memcpy(stats, shadow_stats, sizeof(shadow_stats));
+        stats[3] = shadow_count;
+        if (nrhs > 2 && mxIsLogicalScalarTrue(prhs[2]))
+            memset(shadow_stats, 0, sizeof(shadow_stats));
+        *status = NiFpga_Status_Success;
+        break;
+    }
+    case 212: // Invalidate the shadow of a session, so its next batch writes are all sent
+    {
+        NiFpga_Session session = *(NiFpga_Session*)mxGetData(prhs[1]);
+        shadow_invalidate(session);
+        *status = NiFpga_Status_Success;
+        break;
+    }
+    case 213: // Register table compiled in the mex file (see NiFpga_registers.h)
+    {
+        // plhs[1] : {1 x N} register names
+        // plhs[2] : [N x 5] address, read code, write code (0 for indicators), array size (0 for scalars), is control
+        // plhs[3] : bitfile signature
+        plhs[1] = mxCreateCellMatrix(1, fpga::n_registers);
+        plhs[2] = mxCreateDoubleMatrix(fpga::n_registers, 5, mxREAL);
+        double* table = mxGetPr(plhs[2]);
+        for (uint32_t i = 0; i < fpga::n_registers; i++)
+        {
+            const fpga::register_info& r = fpga::registers[i];
+            mxSetCell(plhs[1], i, mxCreateString(r.name));
+            table[i] = r.address;
+            table[i + fpga::n_registers] = fpga::read_code(r);
+            table[i + 2 * fpga::n_registers] = fpga::write_code(r);
+            table[i + 3 * fpga::n_registers] = r.size;
+            table[i + 4 * fpga::n_registers] = r.control;
+        }
+        plhs[3] = mxCreateString(fpga::signature);
+        *status = NiFpga_Status_Success;
+        break;
+    }
+
+    case 5070: // start MC register sampler thread
+    {
+        // prhs[2] : register addresses, prhs[3] : NiFpga read codes (100-106), prhs[4] : rate in Hz
+        // prhs[5] : optional, uint32 mask of the registers generating events when they change (bit 0 is the first register)
+        // plhs[1] : sampler id. plhs[2] : [start on the QPC clock (see 5075), start in s since 1970]
+        stop_mc_sampler();
+        uint32_t n_registers = (uint32_t)mxGetNumberOfElements(prhs[2]);
+        if (n_registers > MC_MAX_REGISTERS || mxGetNumberOfElements(prhs[3]) != n_registers)
+        {
+            mexErrMsgTxt("Up to 16 registers, with one type per register");
+        }
+        double rate_hz = *(double*)mxGetData(prhs[4]);
+        if (!(rate_hz > 0) || mxIsInf(rate_hz))
+        {
+            mexErrMsgTxt("The sampling rate must be a finite value > 0 Hz");
+        }
+        mc_ctx.session = *(NiFpga_Session*)mxGetData(prhs[1]);
+        mc_ctx.n_registers = n_registers;
+        memcpy(mc_ctx.addresses, mxGetData(prhs[2]), n_registers * sizeof(uint32_t));
+        memcpy(mc_ctx.types, mxGetData(prhs[3]), n_registers * sizeof(uint32_t));
+        mc_ctx.period_s = 1.0 / rate_hz;
+        mc_ctx.ring = (mc_sample*)malloc(MC_RING_SIZE * sizeof(mc_sample));
+        mc_ctx.write_idx = 0;
+        mc_ctx.read_idx = 0;
+        mc_ctx.n_overflow = 0;
+        mc_ctx.n_late = 0;
+        mc_ctx.event_mask = nrhs > 5 ? *(uint32_t*)mxGetData(prhs[5]) : 0;
+        mc_ctx.events = (mc_event*)malloc(MC_EVENT_RING_SIZE * sizeof(mc_event));
+        mc_ctx.event_write_idx = 0;
+        mc_ctx.event_read_idx = 0;
+        mc_ctx.n_event_overflow = 0;
+        if (mc_ctx.ring == NULL || mc_ctx.events == NULL)
+        {
+            free(mc_ctx.ring); // free(NULL) is a no-op
+            free(mc_ctx.events);
+            mc_ctx.ring = NULL;
+            mc_ctx.events = NULL;
+            mexErrMsgTxt("Unable to allocate the MC sampler buffers");
+        }
+        mc_ctx.acq_t0 = mxGetNaN();
+        QueryPerformanceFrequency(&mc_ctx.freq);
+        QueryPerformanceCounter(&mc_ctx.t0);
+        double start_posix = posix_time();
+        mc_ctx.stop = false;
+        mc_ctx.id++;
+        mc_ctx.running = true;
+        if (pthread_create(&mc_ctx.thread, NULL, &sample_mc_registers, &mc_ctx) != 0)
+        {
+            mc_ctx.running = false; // never started, so nothing to join in stop_mc_sampler
+            free(mc_ctx.ring);
+            free(mc_ctx.events);
+            mc_ctx.ring = NULL;
+            mc_ctx.events = NULL;
+            mexErrMsgTxt("Unable to start the MC sampler thread");
+        }
+        mexAtExit(stop_mc_sampler);
+
+        plhs[1] = mxCreateNumericMatrix(1, 1, mxUINT32_CLASS, mxREAL);
+        *(uint32_t*)mxGetData(plhs[1]) = mc_ctx.id; // needed to stop this sampler only
+        plhs[2] = mxCreateDoubleMatrix(1, 2, mxREAL);
+        mxGetPr(plhs[2])[0] = (double)mc_ctx.t0.QuadPart / (double)mc_ctx.freq.QuadPart;
+        mxGetPr(plhs[2])[1] = start_posix;
+        break;
+    }
+    case 5071: // read MC sampler ring
+    {
+        // prhs[2] : sampler id, as returned by 5070. A stale id reads nothing
+        // prhs[3] : max number of samples. plhs[1] : [n_registers + 2 x N] double (t, t_acq, values)
+        // t_acq is the time since the acquisition start (5073), NaN if not set
+        // plhs[2] : [n_overflow, n_late, n_event_overflow] since start
+        bool current = mc_ctx.running && *(uint32_t*)mxGetData(prhs[2]) == mc_ctx.id;
+        uint64_t max_samples = (uint64_t)*(uint32_t*)mxGetData(prhs[3]);
+        uint64_t available = current ? mc_ctx.write_idx - mc_ctx.read_idx : 0;
+        uint64_t n = available < max_samples ? available : max_samples;
+        MemoryBarrier(); // read samples after reading write_idx
+        plhs[1] = mxCreateDoubleMatrix(mc_ctx.n_registers + 2, (mwSize)n, mxREAL);
+        double* out = mxGetPr(plhs[1]);
+        for (uint64_t s = 0; s < n; s++)
+        {
+            mc_sample* sample = &mc_ctx.ring[(mc_ctx.read_idx + s) & (MC_RING_SIZE - 1)];
+            *out++ = sample->t;
+            *out++ = sample->t - mc_ctx.acq_t0;
+            for (uint32_t r = 0; r < mc_ctx.n_registers; r++)
+            {
+                *out++ = (double)sample->values[r];
+            }
+        }
+        MemoryBarrier(); // done reading before releasing the slots
+        mc_ctx.read_idx += n;
+        plhs[2] = mxCreateNumericMatrix(1, 3, mxUINT32_CLASS, mxREAL);
+        ((uint32_t*)mxGetData(plhs[2]))[0] = mc_ctx.n_overflow;
+        ((uint32_t*)mxGetData(plhs[2]))[1] = mc_ctx.n_late;
+        ((uint32_t*)mxGetData(plhs[2]))[2] = mc_ctx.n_event_overflow;
+        break;
+    }
+    case 5072: // stop MC register sampler thread
+    {
+        // prhs[2] : sampler id, as returned by 5070
+        if (*(uint32_t*)mxGetData(prhs[2]) == mc_ctx.id)
+        {
+            stop_mc_sampler();
+        }
+        break;
+    }
+    case 5073: // mark the acquisition start on the MC sampler clock
+    {
+        // prhs[2] : sampler id, as returned by 5070
+        // plhs[1] : acquisition start, in s since sampler start. NaN if this sampler is not running
+        plhs[1] = mxCreateDoubleScalar(mxGetNaN());
+        if (mc_ctx.running && *(uint32_t*)mxGetData(prhs[2]) == mc_ctx.id)
+        {
+            mc_ctx.acq_t0 = mc_sampler_time(&mc_ctx);
+            *mxGetPr(plhs[1]) = mc_ctx.acq_t0;
+        }
+        break;
+    }
+    case 5074: // read MC sampler events
+    {
+        // prhs[2] : sampler id, as returned by 5070. A stale id reads nothing
+        // plhs[1] : [4 x N] double (t, t_acq, register index (from 0), new value)
+        bool current = mc_ctx.running && *(uint32_t*)mxGetData(prhs[2]) == mc_ctx.id;
+        uint64_t n = current ? mc_ctx.event_write_idx - mc_ctx.event_read_idx : 0;
+        MemoryBarrier(); // read events after reading event_write_idx
+        plhs[1] = mxCreateDoubleMatrix(4, (mwSize)n, mxREAL);
+        double* out = mxGetPr(plhs[1]);
+        for (uint64_t e = 0; e < n; e++)
+        {
+            mc_event* event = &mc_ctx.events[(mc_ctx.event_read_idx + e) & (MC_EVENT_RING_SIZE - 1)];
+            *out++ = event->t;
+            *out++ = event->t - mc_ctx.acq_t0;
+            *out++ = event->reg;
+            *out++ = event->value;
+        }
+        MemoryBarrier(); // done reading before releasing the slots
+        mc_ctx.event_read_idx += n;
+        break;
+    }
+    case 5075: // current time on the QueryPerformanceCounter clock
+    {
+        // plhs[1] : s. Same clock as the sampler start returned by 5070, so
+        // events timed in Matlab can be compared with MC samples
+        plhs[1] = mxCreateDoubleScalar(qpc_time());
+        break;
+    }
+    
 	case 507: // ReadFifoI64
 	{
         NiFpga_Session session = *(NiFpga_Session*)mxGetData(prhs[1]);
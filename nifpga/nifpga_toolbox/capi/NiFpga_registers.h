@@ -0,0 +1,333 @@
+/*
+ * Generated by NiFpga2Cpp.m from NiFpga_FPGADAQ_variable_length_matlab_v13.h. DO NOT EDIT!
+ * Regenerate it when the bitfile changes, and recompile the mex file.
+ */
+
+#ifndef __NiFpga_registers_h__
+#define __NiFpga_registers_h__
+
+#include <stdint.h>
+
+namespace fpga
+{
+    enum register_type { Bool = 0, I8 = 1, U8 = 2, I16 = 3, U16 = 4, I32 = 5, U32 = 6, I64 = 7, U64 = 8 };
+
+    struct register_info
+    {
+        const char* name;
+        uint32_t address;
+        register_type type;
+        bool control;           // false for indicators
+        uint32_t size;          // number of elements, 0 for scalars
+    };
+
+    struct fifo_info
+    {
+        const char* name;
+        uint32_t address;
+        register_type type;
+        bool host_to_target;
+    };
+
+    // NiFpga mex function codes, as in the Matlab CAPI
+    constexpr uint32_t read_code(const register_info& r) { return (r.size ? 300 : 100) + r.type; }
+    constexpr uint32_t write_code(const register_info& r) { return r.control ? (r.size ? 400 : 200) + r.type : 0; }
+
+    constexpr const char* bitfile = "NiFpga_FPGADAQ_variable_length_matlab_v13.lvbitx";
+    constexpr const char* signature = "2F89F0E5AF6D023C3F4D65EA377BA44C";
+
+    namespace reg
+    {
+        constexpr register_info AcquireMCBG = { "AcquireMCBG", 0x8000022A, Bool, false, 0 };
+        constexpr register_info Configured = { "Configured", 0x22, Bool, false, 0 };
+        constexpr register_info PLLLocked = { "PLLLocked", 0x1A, Bool, false, 0 };
+        constexpr register_info TXready = { "TXready", 0x86, Bool, false, 0 };
+        constexpr register_info UserCommandIdle = { "UserCommandIdle", 0xA, Bool, false, 0 };
+        constexpr register_info UserError = { "UserError", 0x1E, Bool, false, 0 };
+        constexpr register_info abort_MC = { "abort_MC", 0x800001EA, Bool, false, 0 };
+        constexpr register_info background_mc = { "background_mc", 0x80000212, Bool, false, 0 };
+        constexpr register_info capturezrefcentroid = { "capturezrefcentroid", 0x11E, Bool, false, 0 };
+        constexpr register_info endoftrial = { "endoftrial", 0x8000021A, Bool, false, 0 };
+        constexpr register_info flag1_read = { "flag1_read", 0x80000202, Bool, false, 0 };
+        constexpr register_info flag2_read = { "flag2_read", 0x800001FA, Bool, false, 0 };
+        constexpr register_info last_pixel = { "last_pixel", 0x11A, Bool, false, 0 };
+        constexpr register_info lastpixel = { "lastpixel", 0x186, Bool, false, 0 };
+        constexpr register_info lostx = { "lostx", 0x6A, Bool, false, 0 };
+        constexpr register_info lostxory = { "lostxory", 0x56, Bool, false, 0 };
+        constexpr register_info losty = { "losty", 0x66, Bool, false, 0 };
+        constexpr register_info lostz = { "lostz", 0x7A, Bool, false, 0 };
+        constexpr register_info notlost_xory = { "notlost_xory", 0x5A, Bool, false, 0 };
+        constexpr register_info rec_on_bg = { "rec_on_bg", 0x8000022E, Bool, false, 0 };
+        constexpr register_info resetxyaccum = { "resetxyaccum", 0x176, Bool, false, 0 };
+        constexpr register_info resetzaccum = { "resetzaccum", 0x172, Bool, false, 0 };
+        constexpr register_info skip_z = { "skip_z", 0x182, Bool, false, 0 };
+        constexpr register_info start_backref_pulse = { "start_backref_pulse", 0x80000236, Bool, false, 0 };
+        constexpr register_info startpulseout = { "startpulseout", 0x8000020A, Bool, false, 0 };
+        constexpr register_info writerefframe = { "writerefframe", 0xFE, Bool, false, 0 };
+        constexpr register_info UserCommandStatus = { "UserCommandStatus", 0xE, U8, false, 0 };
+        constexpr register_info x_cent_new_x10 = { "x_cent_new_x10", 0x132, I16, false, 0 };
+        constexpr register_info x_cent_ref_x10 = { "x_cent_ref_x10", 0x136, I16, false, 0 };
+        constexpr register_info x_correction_X10 = { "x_correction_X10", 0x152, I16, false, 0 };
+        constexpr register_info x_diff_X100 = { "x_diff_X100", 0x13A, I16, false, 0 };
+        constexpr register_info y_cent_new_x10 = { "y_cent_new_x10", 0x12A, I16, false, 0 };
+        constexpr register_info y_cent_ref_x10 = { "y_cent_ref_x10", 0x126, I16, false, 0 };
+        constexpr register_info y_correction_X10 = { "y_correction_X10", 0x14E, I16, false, 0 };
+        constexpr register_info y_diff_X100 = { "y_diff_X100", 0x12E, I16, false, 0 };
+        constexpr register_info z_cent_new_x10 = { "z_cent_new_x10", 0x142, I16, false, 0 };
+        constexpr register_info z_cent_ref_x10 = { "z_cent_ref_x10", 0x13E, I16, false, 0 };
+        constexpr register_info z_correction_X100 = { "z_correction_X100", 0x14A, I16, false, 0 };
+        constexpr register_info z_diff_X100 = { "z_diff_X100", 0x146, I16, false, 0 };
+        constexpr register_info AODfillin = { "AODfillin", 0x8000021E, U16, false, 0 };
+        constexpr register_info Enum = { "Enum", 0x800001F6, U16, false, 0 };
+        constexpr register_info aqstate = { "aqstate", 0x80000232, U16, false, 0 };
+        constexpr register_info bgsm_state = { "bgsm_state", 0x80000216, U16, false, 0 };
+        constexpr register_info nemrefypix = { "nemrefypix", 0x80000222, U16, false, 0 };
+        constexpr register_info num_xyref_pixels = { "num_xyref_pixels", 0xBE, U16, false, 0 };
+        constexpr register_info numxyzpixels = { "numxyzpixels", 0xC2, U16, false, 0 };
+        constexpr register_info pixel_count = { "pixel_count", 0xBA, U16, false, 0 };
+        constexpr register_info xpixelscurrent = { "xpixelscurrent", 0x800001E2, U16, false, 0 };
+        constexpr register_info ycount = { "ycount", 0x800001E6, U16, false, 0 };
+        constexpr register_info DataOut = { "DataOut", 0x38, U64, false, 0 };
+        constexpr register_info X_Y_Z = { "X_Y_Z", 0xD8, U64, false, 0 };
+        constexpr register_info ABORTTrigloop = { "ABORTTrigloop", 0x1D6, Bool, true, 0 };
+        constexpr register_info CPHA = { "CPHA", 0x2E, Bool, true, 0 };
+        constexpr register_info CPOL = { "CPOL", 0x32, Bool, true, 0 };
+        constexpr register_info EnableTrigger1 = { "EnableTrigger1", 0x1CE, Bool, true, 0 };
+        constexpr register_info EnableTrigger2 = { "EnableTrigger2", 0x1CA, Bool, true, 0 };
+        constexpr register_info EnableTrigger3 = { "EnableTrigger3", 0x1C6, Bool, true, 0 };
+        constexpr register_info EnableTrigger4 = { "EnableTrigger4", 0x1C2, Bool, true, 0 };
+        constexpr register_info Enable_ZMC = { "Enable_ZMC", 0xD6, Bool, true, 0 };
+        constexpr register_info Enablestimulusfunct = { "Enablestimulusfunct", 0x1A6, Bool, true, 0 };
+        constexpr register_info Enablestimuluslive = { "Enablestimuluslive", 0x1B2, Bool, true, 0 };
+        constexpr register_info Experimentstart = { "Experimentstart", 0x1DA, Bool, true, 0 };
+        constexpr register_info MISO = { "MISO", 0x26, Bool, true, 0 };
+        constexpr register_info Newlinetriggerenabled = { "Newlinetriggerenabled", 0x8000025A, Bool, true, 0 };
+        constexpr register_info RESET = { "RESET", 0x2A, Bool, true, 0 };
+        constexpr register_info Refcountresetenabled = { "Refcountresetenabled", 0x8000025E, Bool, true, 0 };
+        constexpr register_info UserCommandCommit = { "UserCommandCommit", 0x2, Bool, true, 0 };
+        constexpr register_info enable_mc_recovery = { "enable_mc_recovery", 0x52, Bool, true, 0 };
+        constexpr register_info flag1_write = { "flag1_write", 0x80000206, Bool, true, 0 };
+        constexpr register_info flag2_write = { "flag2_write", 0x800001FE, Bool, true, 0 };
+        constexpr register_info live_scan = { "live_scan", 0x80000266, Bool, true, 0 };
+        constexpr register_info live_scantriggersmodule = { "live_scantriggersmodule", 0x1D2, Bool, true, 0 };
+        constexpr register_info select_ref_red = { "select_ref_red", 0x80000262, Bool, true, 0 };
+        constexpr register_info set_reference = { "set_reference", 0x8E, Bool, true, 0 };
+        constexpr register_info start = { "start", 0x8000026A, Bool, true, 0 };
+        constexpr register_info stop_background = { "stop_background", 0x8000020E, Bool, true, 0 };
+        constexpr register_info swapz = { "swapz", 0xD2, Bool, true, 0 };
+        constexpr register_info use_host_offset_z = { "use_host_offset_z", 0xDE, Bool, true, 0 };
+        constexpr register_info use_varailble_length = { "use_varailble_length", 0x800001F2, Bool, true, 0 };
+        constexpr register_info use_vel_estimate = { "use_vel_estimate", 0x46, Bool, true, 0 };
+        constexpr register_info usehostoffset = { "usehostoffset", 0x8A, Bool, true, 0 };
+        constexpr register_info useperiodicfunctional = { "useperiodicfunctional", 0x4E, Bool, true, 0 };
+        constexpr register_info useslidingaverage = { "useslidingaverage", 0xF6, Bool, true, 0 };
+        constexpr register_info write_first_centroid_z = { "write_first_centroid_z", 0xEA, Bool, true, 0 };
+        constexpr register_info HCP1 = { "HCP1", 0x36, U8, true, 0 };
+        constexpr register_info UserCommand = { "UserCommand", 0x6, U8, true, 0 };
+        constexpr register_info UserData1 = { "UserData1", 0x16, U8, true, 0 };
+        constexpr register_info ref_diff_x_y = { "ref_diff_x_y", 0x6E, U8, true, 0 };
+        constexpr register_info ref_diff_z = { "ref_diff_z", 0x7E, U8, true, 0 };
+        constexpr register_info AODfill = { "AODfill", 0x80000272, U16, true, 0 };
+        constexpr register_info Average = { "Average", 0x9A, U16, true, 0 };
+        constexpr register_info AverageZ = { "AverageZ", 0xEE, U16, true, 0 };
+        constexpr register_info Averageoffsets = { "Averageoffsets", 0x76, U16, true, 0 };
+        constexpr register_info ImagingProtocol = { "ImagingProtocol", 0x80000256, U16, true, 0 };
+        constexpr register_info Integral_scale = { "Integral_scale", 0x166, U16, true, 0 };
+        constexpr register_info Integral_scale_z = { "Integral_scale_z", 0x156, U16, true, 0 };
+        constexpr register_info Mode = { "Mode", 0x800001DE, U16, true, 0 };
+        constexpr register_info Ref_z_lines = { "Ref_z_lines", 0x8000023E, U16, true, 0 };
+        constexpr register_info RefsampsperpixPr = { "RefsampsperpixPr", 0x8000024A, U16, true, 0 };
+        constexpr register_info Refsampsperpix_z = { "Refsampsperpix_z", 0x80000246, U16, true, 0 };
+        constexpr register_info RefxpixelsperlineNpxr = { "RefxpixelsperlineNpxr", 0x80000286, U16, true, 0 };
+        constexpr register_info RefypixelsperlineNpyr = { "RefypixelsperlineNpyr", 0x80000282, U16, true, 0 };
+        constexpr register_info Trigger1function = { "Trigger1function", 0x19E, U16, true, 0 };
+        constexpr register_info Trigger1selector = { "Trigger1selector", 0x80000252, U16, true, 0 };
+        constexpr register_info UserData0 = { "UserData0", 0x12, U16, true, 0 };
+        constexpr register_info diff_thresh_x10 = { "diff_thresh_x10", 0x16E, U16, true, 0 };
+        constexpr register_info diff_thresh_x10_z = { "diff_thresh_x10_z", 0x16A, U16, true, 0 };
+        constexpr register_info ignore_z_lines = { "ignore_z_lines", 0x17E, U16, true, 0 };
+        constexpr register_info mc_delayprog = { "mc_delayprog", 0x8000023A, U16, true, 0 };
+        constexpr register_info proportianal_x10 = { "proportianal_x10", 0x162, U16, true, 0 };
+        constexpr register_info proportianal_x10_z = { "proportianal_x10_z", 0x15E, U16, true, 0 };
+        constexpr register_info ref_framedilute = { "ref_framedilute", 0xFA, U16, true, 0 };
+        constexpr register_info ref_z_pixels_per_line = { "ref_z_pixels_per_line", 0x80000242, U16, true, 0 };
+        constexpr register_info sampleswaitafterpulse = { "sampleswaitafterpulse", 0x80000226, U16, true, 0 };
+        constexpr register_info sampleswaitaftertrigger = { "sampleswaitaftertrigger", 0x80000292, U16, true, 0 };
+        constexpr register_info sampsperpixP = { "sampsperpixP", 0x8000024E, U16, true, 0 };
+        constexpr register_info scan_int_x1000 = { "scan_int_x1000", 0x15A, U16, true, 0 };
+        constexpr register_info suppres_mc = { "suppres_mc", 0x800001EE, U16, true, 0 };
+        constexpr register_info threshold_xy = { "threshold_xy", 0x82, U16, true, 0 };
+        constexpr register_info threshold_z = { "threshold_z", 0x17A, U16, true, 0 };
+        constexpr register_info xpixelsperlineNpx = { "xpixelsperlineNpx", 0x8000028E, U16, true, 0 };
+        constexpr register_info ypixelsperlineNpy = { "ypixelsperlineNpy", 0x8000028A, U16, true, 0 };
+        constexpr register_info StartUpDelay = { "StartUpDelay", 0x80000278, I32, true, 0 };
+        constexpr register_info NumberpixelspointingNp = { "NumberpixelspointingNp", 0x8000027C, U32, true, 0 };
+        constexpr register_info PulseWidthfunct80MhzCycles2 = { "PulseWidthfunct80MhzCycles2", 0x1A8, U32, true, 0 };
+        constexpr register_info PulseWidthlive80MhzCycles = { "PulseWidthlive80MhzCycles", 0x1B4, U32, true, 0 };
+        constexpr register_info PulsewidthticksFrameCycleTrig = { "PulsewidthticksFrameCycleTrig", 0x194, U32, true, 0 };
+        constexpr register_info PulsewidthticksLineTrig = { "PulsewidthticksLineTrig", 0x198, U32, true, 0 };
+        constexpr register_info PulsewidthticksStartofExptrig = { "PulsewidthticksStartofExptrig", 0x18C, U32, true, 0 };
+        constexpr register_info PulsewidthticksTrialtrig = { "PulsewidthticksTrialtrig", 0x190, U32, true, 0 };
+        constexpr register_info RefScanCycles = { "RefScanCycles", 0x80000274, U32, true, 0 };
+        constexpr register_info RepeatNumberofCycles = { "RepeatNumberofCycles", 0x8000026C, U32, true, 0 };
+        constexpr register_info TriggerDelay80MhzCycles = { "TriggerDelay80MhzCycles", 0x1AC, U32, true, 0 };
+        constexpr register_info TriggerPeriod80MhzCycles = { "TriggerPeriod80MhzCycles", 0x1B8, U32, true, 0 };
+    }
+
+    namespace fifo
+    {
+        constexpr fifo_info FIFOREFHOSTFRAME = { "FIFOREFHOSTFRAME", 1, U16, false };
+        constexpr fifo_info Channel0 = { "Channel0", 3, U32, false };
+        constexpr fifo_info Channel1 = { "Channel1", 2, U32, false };
+        constexpr fifo_info VARIABLELENGTHFIFO = { "VARIABLELENGTHFIFO", 0, U16, true };
+    }
+
+    constexpr register_info registers[] = {
+        reg::AcquireMCBG,
+        reg::Configured,
+        reg::PLLLocked,
+        reg::TXready,
+        reg::UserCommandIdle,
+        reg::UserError,
+        reg::abort_MC,
+        reg::background_mc,
+        reg::capturezrefcentroid,
+        reg::endoftrial,
+        reg::flag1_read,
+        reg::flag2_read,
+        reg::last_pixel,
+        reg::lastpixel,
+        reg::lostx,
+        reg::lostxory,
+        reg::losty,
+        reg::lostz,
+        reg::notlost_xory,
+        reg::rec_on_bg,
+        reg::resetxyaccum,
+        reg::resetzaccum,
+        reg::skip_z,
+        reg::start_backref_pulse,
+        reg::startpulseout,
+        reg::writerefframe,
+        reg::UserCommandStatus,
+        reg::x_cent_new_x10,
+        reg::x_cent_ref_x10,
+        reg::x_correction_X10,
+        reg::x_diff_X100,
+        reg::y_cent_new_x10,
+        reg::y_cent_ref_x10,
+        reg::y_correction_X10,
+        reg::y_diff_X100,
+        reg::z_cent_new_x10,
+        reg::z_cent_ref_x10,
+        reg::z_correction_X100,
+        reg::z_diff_X100,
+        reg::AODfillin,
+        reg::Enum,
+        reg::aqstate,
+        reg::bgsm_state,
+        reg::nemrefypix,
+        reg::num_xyref_pixels,
+        reg::numxyzpixels,
+        reg::pixel_count,
+        reg::xpixelscurrent,
+        reg::ycount,
+        reg::DataOut,
+        reg::X_Y_Z,
+        reg::ABORTTrigloop,
+        reg::CPHA,
+        reg::CPOL,
+        reg::EnableTrigger1,
+        reg::EnableTrigger2,
+        reg::EnableTrigger3,
+        reg::EnableTrigger4,
+        reg::Enable_ZMC,
+        reg::Enablestimulusfunct,
+        reg::Enablestimuluslive,
+        reg::Experimentstart,
+        reg::MISO,
+        reg::Newlinetriggerenabled,
+        reg::RESET,
+        reg::Refcountresetenabled,
+        reg::UserCommandCommit,
+        reg::enable_mc_recovery,
+        reg::flag1_write,
+        reg::flag2_write,
+        reg::live_scan,
+        reg::live_scantriggersmodule,
+        reg::select_ref_red,
+        reg::set_reference,
+        reg::start,
+        reg::stop_background,
+        reg::swapz,
+        reg::use_host_offset_z,
+        reg::use_varailble_length,
+        reg::use_vel_estimate,
+        reg::usehostoffset,
+        reg::useperiodicfunctional,
+        reg::useslidingaverage,
+        reg::write_first_centroid_z,
+        reg::HCP1,
+        reg::UserCommand,
+        reg::UserData1,
+        reg::ref_diff_x_y,
+        reg::ref_diff_z,
+        reg::AODfill,
+        reg::Average,
+        reg::AverageZ,
+        reg::Averageoffsets,
+        reg::ImagingProtocol,
+        reg::Integral_scale,
+        reg::Integral_scale_z,
+        reg::Mode,
+        reg::Ref_z_lines,
+        reg::RefsampsperpixPr,
+        reg::Refsampsperpix_z,
+        reg::RefxpixelsperlineNpxr,
+        reg::RefypixelsperlineNpyr,
+        reg::Trigger1function,
+        reg::Trigger1selector,
+        reg::UserData0,
+        reg::diff_thresh_x10,
+        reg::diff_thresh_x10_z,
+        reg::ignore_z_lines,
+        reg::mc_delayprog,
+        reg::proportianal_x10,
+        reg::proportianal_x10_z,
+        reg::ref_framedilute,
+        reg::ref_z_pixels_per_line,
+        reg::sampleswaitafterpulse,
+        reg::sampleswaitaftertrigger,
+        reg::sampsperpixP,
+        reg::scan_int_x1000,
+        reg::suppres_mc,
+        reg::threshold_xy,
+        reg::threshold_z,
+        reg::xpixelsperlineNpx,
+        reg::ypixelsperlineNpy,
+        reg::StartUpDelay,
+        reg::NumberpixelspointingNp,
+        reg::PulseWidthfunct80MhzCycles2,
+        reg::PulseWidthlive80MhzCycles,
+        reg::PulsewidthticksFrameCycleTrig,
+        reg::PulsewidthticksLineTrig,
+        reg::PulsewidthticksStartofExptrig,
+        reg::PulsewidthticksTrialtrig,
+        reg::RefScanCycles,
+        reg::RepeatNumberofCycles,
+        reg::TriggerDelay80MhzCycles,
+        reg::TriggerPeriod80MhzCycles
+    };
+    constexpr uint32_t n_registers = 134;
+
+    constexpr fifo_info fifos[] = {
+        fifo::FIFOREFHOSTFRAME,
+        fifo::Channel0,
+        fifo::Channel1,
+        fifo::VARIABLELENGTHFIFO
+    };
+    constexpr uint32_t n_fifos = 4;
+
+}
+
+#endif
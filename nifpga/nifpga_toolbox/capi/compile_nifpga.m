@@ -4,9 +4,12 @@
 % * If you recompile the NIFPGA toolbox with a new version for example,
 %   important cpipe function will be erased (as they are not standard) and
 %   will need to be regenerated 
+% * NiFpga_registers.h is generated by NiFpga2Cpp (or NiFpga2Matlab) from
+%   the bitfile header. Regenerate it and recompile after a bitfile change.
+%   It uses C++11 constexpr (Visual Studio 2015 or later)
 
 mex('-g', '-output', 'NiFpga', 'NiFpga_mex.cpp', 'NiFpga.c', '-I./', '-L./',...
-    '-LC:/Progra~1/MATLAB/R2017b/extern/lib/win64/microsoft/', '-ltestdll', '-lpthreadVC2', '-llibut') % works for 64 bit
+    '-LC:/Progra~1/MATLAB/R2017b/extern/lib/win64/microsoft/', '-ltestdll', '-lpthreadVC2', '-llibut', '-lwinmm') % works for 64 bit. winmm is for the MC sampler timer resolution
 
 %% 32 bits note
 % for 32 bit need 32 bit versions of testdll (recompile using mingw32 bit
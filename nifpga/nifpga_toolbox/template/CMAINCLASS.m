@@ -0,0 +1,27 @@
+classdef CMAINCLASS < handle
+    %CMAINCLASS Class grouping NI Fpga VI classes
+    
+    %######################!!! IMPORTANT !!!######################
+    %THIS FILE HAS BEEN GENERATED BY NIFpga2Matlab.m, DO NOT EDIT!
+    %######################!!! IMPORTANT !!!######################
+    
+    properties (SetAccess = immutable)
+        % Subclasses
+        SUBCLASS % handle to CSUBCLASS object
+        % end Subclasses
+    end
+    
+    methods
+        function obj = CMAINCLASS(Target)
+            % Subclass Constructors
+            obj.SUBCLASS = CSUBCLASS(Target);
+            % end Subclass Constructors
+        end
+        
+        function delete(obj)
+            % Subclass Destructors
+            delete(obj.SUBCLASS);
+            % end Subclass Destructors
+        end
+    end
+end
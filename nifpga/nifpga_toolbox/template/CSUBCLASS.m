@@ -0,0 +1,83 @@
+classdef CSUBCLASS < CNiFpgaBitfile
+    %CSUBCLASS Class to represent the NI Fpga VI SUBCLASS
+    
+    %######################!!! IMPORTANT !!!######################
+    %THIS FILE HAS BEEN GENERATED BY NIFpga2Matlab.m, DO NOT EDIT!
+    %######################!!! IMPORTANT !!!######################
+    
+    properties (SetAccess = immutable)
+        % Fifos
+        FIFO % handle to NI Fpga fifo object FIFO
+        % end Fifos
+    end
+    
+    properties (Dependent = true)
+        % Controls/Indicators
+        LABEL
+        % end Controls/Indicators
+    end
+    
+    methods
+        function obj = CSUBCLASS(Target)
+            bitName = fullfile(fileparts(mfilename('fullpath')), BITFILE);
+            obj = obj@CNiFpgaBitfile(bitName, SIGNATURE, Target);
+            % Fifo Constructor
+            obj.FIFO = CTYPEFifo(uint32(ADDRESS), uint32(ID));
+            % end Fifo Constructor
+        end
+        
+        function status = open(obj, attribute)
+            status = open@CNiFpgaBitfile(obj, attribute);
+            if ~status
+                % Open Fifo
+                obj.FIFO.Session = obj.Session;
+                % end Open Fifo
+            end
+        end
+        
+        function status = close(obj)
+            status = close@CNiFpgaBitfile(obj);
+            if ~status
+                % Close Fifo
+                obj.FIFO.Session = [];
+                % end Close Fifo
+            end
+        end
+        
+        % Read
+        function LABEL = get.LABEL(obj)
+            if ~isempty(obj.Session)
+                [obj.Status, LABEL] = NiFpga(uint32(ID), obj.Session, uint32(ADDRESS));
+            else
+                LABEL = NaN;
+            end
+        end
+        % end Read
+        
+        % Write
+        function set.LABEL(obj, LABEL)
+            if ~isempty(obj.Session)
+                obj.Status = NiFpga(uint32(ID), obj.Session, uint32(ADDRESS), MATCAST(LABEL));
+            end
+        end
+        % end Write
+        
+        % Read Array
+        function LABEL = get.LABEL(obj)
+            if ~isempty(obj.Session)
+                [obj.Status, LABEL] = NiFpga(uint32(ID), obj.Session, uint32(ADDRESS), uint32(SIZE));
+            else
+                LABEL = NaN(SIZE, 1);
+            end
+        end
+        % end Read Array
+        
+        % Write Array
+        function set.LABEL(obj, LABEL)
+            if ~isempty(obj.Session)
+                obj.Status = NiFpga(uint32(ID), obj.Session, uint32(ADDRESS), MATCAST(LABEL), uint32(SIZE));
+            end
+        end
+        % end Write Array
+    end
+end
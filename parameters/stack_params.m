@@ -178,6 +178,13 @@
 %       {'random_plane_order' (BOOL)} : Default is false
 %                           If true, the order of the planes is randomised
 %                           at each repeat
+%
+%       {'precalculate_drives' (BOOL)} : Default is true
+%                           If true, AOL stacks compute the drives of all
+%                           planes before the first plane (in parallel if
+%                           a pool is available), and only upload them
+%                           between planes. This reduces the dead time
+%                           between planes of deep stacks
 % 
 %       {'averages', (INT)} : Default is 0
 %                           Controls the number of extra frame per plane. 
@@ -255,6 +262,20 @@
 %       {'save_name' (BOOL)} : Default is ''
 %                           If not empty, then the stack will be save using
 %                           the provided name. 
+%
+%       {'store_folder' (STR)} : Default is ''
+%                           If not empty, planes are written in a
+%                           StackStore as soon as they are acquired,
+%                           instead of being kept in memory until the end
+%                           of the stack. Each stack is written in a new
+%                           timestamped subfolder of this folder.
+%
+%       {'mosaic' (MosaicStitcher object)} : Default is []
+%                           If not empty, the mean stack is added to this
+%                           mosaic as a tile, at the stage position of the
+%                           stack. The mosaic must have the stack
+%                           resolution and number of planes (see
+%                           MosaicStitcher.from_controller)
 % -------------------------------------------------------------------------
 % Outputs:
 %
@@ -317,7 +338,7 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   18-03-2019
+%   18-10-2026
 %
 % See also: unwrap_parameters, update_param_and_check_condition, 
 % check_names_validity, update_gui_from_stack_params,
@@ -395,11 +416,11 @@ function parameters = default_stack(controller, varargin)
                             'tracking_selection','tracking_threshold','tracking_channel','tracking_FOV','tracking_soma_XYZ_loc','tracking_rate','tracking_batch_size','tracking_standby_mode','tracking_res','tracking_rendering', 'save_ref_traces'...
                             'pockels_start','pockels_stop','interpolation_mode',... 
                             'dual_stack_aa','dual_stack_dt','dual_stack_fov',...
-                            'use_default_stack_limits','move_to_stack_center','num_planes','stack_start','stack_stop',... 
+                            'use_default_stack_limits','move_to_stack_center','num_planes','stack_start','stack_stop','random_plane_order','precalculate_drives',... 
                             'averages','averages_method','repeats','repeats_method','final_filter', 'flatten_fov',...
                             'recast','recast_value','channel',... 
                             'overlap_prct','scan_mode',... 
-                            'show_preview','plot','save_name'}; 
+                            'show_preview','plot','save_name','store_folder','mosaic'}; 
 
         if isempty(controller) || isempty(controller.pockels)
             default_pockels = 0;  
@@ -444,6 +465,7 @@ function parameters = default_stack(controller, varargin)
         parameters = update_param_and_check_condition('stack_start','stack_start',0,update,varargin,parameters,'float');
         parameters = update_param_and_check_condition('stack_stop','stack_stop',0,update,varargin,parameters,'float');
         parameters = update_param_and_check_condition('random_plane_order','random_plane_order',false,update,varargin,parameters,'bool');
+        parameters = update_param_and_check_condition('precalculate_drives','precalculate_drives',true,update,varargin,parameters,'bool');
 
         %% Stack and plane averaging options
         parameters = update_param_and_check_condition('averages','averages',0,update,varargin,parameters,'int');
@@ -466,6 +488,11 @@ function parameters = default_stack(controller, varargin)
         parameters = update_param_and_check_condition('show_preview','show_preview',0,update,varargin,parameters,'int'); %0 for no preview, 1 or 2 to see channel 1 or 2
         parameters = update_param_and_check_condition('plot','plot',true,update,varargin,parameters,'bool');
         parameters = update_param_and_check_condition('save_name','save_name','',update,varargin,parameters,'str');
+        parameters = update_param_and_check_condition('store_folder','store_folder','',update,varargin,parameters,'str');
+        parameters = update_param_and_check_condition('mosaic','mosaic',[],update,varargin,parameters);
+        if ~isempty(parameters.mosaic) && ~isa(parameters.mosaic, 'MosaicStitcher')
+            error_box(' --- parameter mosaic must be a MosaicStitcher object ---', false)
+        end
 
         if any([parameters.stack_start,parameters.stack_stop])
             parameters.use_default_stack_limits = false;
@@ -71,6 +71,13 @@
 %                            If true, a movement correction log is 
 %                            collected during data acquisition. 
 %
+%        {'reduction (STR)}: Default is 'none'.
+%                            Any in {'none','mean','max','min','median',
+%                            'var'}. If not 'none', successive cycles are
+%                            reduced online as they are acquired, and each
+%                            repeat returns a single cycle. Only one cycle
+%                            is held in memory. See FrameReducer.
+%
 % -------------------------------------------------------------------------
 % Outputs:
 %
@@ -119,7 +126,7 @@ function parameters = timing_params(varargin)
     [parameters,varargin,update] = unwrap_parameters(varargin);
 
     %check validity of the parameter name
-    Arguments_list = {'recording_time_sec','duration','repeats','pause','MC','number_of_cycles','reuse_viewer','no_interrupt','dump_data','monitor_MC'}; 
+    Arguments_list = {'recording_time_sec','duration','repeats','pause','MC','number_of_cycles','reuse_viewer','no_interrupt','dump_data','monitor_MC','reduction'}; 
 
     %% Timing for functional acquisition 
     parameters = update_param_and_check_condition({'recording_time_sec','duration'},'recording_time_sec',1,update,varargin,parameters,'float');
@@ -130,10 +137,14 @@ function parameters = timing_params(varargin)
     parameters = update_param_and_check_condition('no_interrupt','no_interrupt',0,update,varargin,parameters,'bool');
     parameters = update_param_and_check_condition('dump_data','dump_data',false,update,varargin,parameters,'bool');
     parameters = update_param_and_check_condition('monitor_MC','monitor_MC',false,update,varargin,parameters,'bool');
+    parameters = update_param_and_check_condition('reduction','reduction','none',update,varargin,parameters,{'none','mean','max','min','median','var'});
 
     if ~isfield(parameters,'dump_data')
     	parameters.dump_data = false;
     end
+    if ~isfield(parameters,'reduction')
+    	parameters.reduction = 'none';
+    end
     
     if ~isfield(parameters,'duration')
         parameters.duration = parameters.recording_time_sec; %some code still uses that
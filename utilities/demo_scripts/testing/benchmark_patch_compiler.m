@@ -0,0 +1,57 @@
+%% This script compares the per-patch miniscan generation with
+% compile_miniscan_patches, for a large number of 3D patches. Both must
+% give the same ramps, otherwise the script fails. No drives are sent.
+%
+% Requirements : you need a Controller object. If you don't have one,
+% type:
+%   c = Controller(false);
+
+c           = get_existing_controller_name(true);
+n_patches   = 10000;
+patch_size  = 10;
+res         = c.scan_params.mainscan_x_pixel_density;
+
+%% Random patches, of fixed size, at random XYZ locations
+corner      = [randi(res, 2, n_patches); randi(100, 1, n_patches) - 50];
+v1          = repmat([patch_size; 0; 0], 1, n_patches);
+v2          = repmat([0; patch_size; 0], 1, n_patches);
+v3          = zeros(3, n_patches);
+
+%% Per-patch generation, as previously done in Controller.set_miniscans
+tic
+boxes       = c.scan_params.generate_miniscan_boxes(corner, v1, v2, v3);
+fprintf('generate_miniscan_boxes : %.1f ms\n', toc * 1000)
+tic
+start_ref = []; stop_ref = [];
+for el = 1:numel(boxes)
+    nlines  = norm(boxes{el}.v2);
+    starts  = boxes{el}.corner + boxes{el}.v2 .* linspace(0, 1, nlines);
+    stops   = starts + boxes{el}.v1;
+    start_ref = [start_ref, c.aol_params.convert_xyz_pixels_to_norm(starts)]; %#ok<AGROW>
+    stop_ref  = [stop_ref , c.aol_params.convert_xyz_pixels_to_norm(stops )]; %#ok<AGROW>
+end
+fprintf('per-patch loop : %.1f ms\n', toc * 1000)
+
+%% Vectorised generation
+tic
+transform   = c.aol_params.get_transform(c.scan_params.acceptance_angle, res);
+[start_norm_raw, stop_norm_raw, voxels_for_ramp] = compile_miniscan_patches(transform, corner, v1, v2);
+fprintf('compile_miniscan_patches : %.1f ms (%d lines)\n', toc * 1000, numel(voxels_for_ramp))
+
+%% Check that both methods give the same ramps
+assert(isequal(size(start_norm_raw), size(start_ref)), 'compile_miniscan_patches returned %d lines instead of %d', size(start_norm_raw, 2), size(start_ref, 2))
+max_diff    = max(abs([start_norm_raw - start_ref, stop_norm_raw - stop_ref]), [], 'all');
+fprintf('max difference : %g norm units\n', max_diff)
+assert(max_diff < 1e-12, 'compile_miniscan_patches does not match the per-patch generation')
+
+%% Same patches with a random orientation and a power gradient along Z
+rotation    = zeros(3, 3, n_patches);
+for el = 1:n_patches
+    a = 2 * pi * rand();
+    rotation(:,:,el) = [cos(a), -sin(a), 0; sin(a), cos(a), 0; 0, 0, 1]; % Rotation around Z
+end
+lut         = PockelsLut(-50, 50, 1.2, 0.4);
+tic
+[start_norm_raw, stop_norm_raw, voxels_for_ramp, pockels] = compile_miniscan_patches(transform, corner, v1, v2, [], rotation, lut);
+fprintf('compile_miniscan_patches with rotations and pockels : %.1f ms\n', toc * 1000)
+assert(isequal(size(pockels), [4, numel(voxels_for_ramp)]) && all(pockels(:) >= 0.4 & pockels(:) <= 1.2), 'Pockels values must be within the PockelsLut range, for each line and AOD')
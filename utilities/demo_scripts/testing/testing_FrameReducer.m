@@ -0,0 +1,46 @@
+cycles = uint16(randi([0, 2^16-1], 1000, 20)); % 20 cycles of 1000 points
+
+%% Online mean (should match mean(cycles, 2), relative error < 1e-4)
+reducer = FrameReducer('mean', size(cycles, 1));
+for cycle = 1:size(cycles, 2)
+    reducer.add(cycles(:, cycle));
+end
+max(abs(double(reducer.get_result()) - mean(double(cycles), 2)) ./ max(mean(double(cycles), 2), 1))
+
+%% Online max (should match max(cycles, [], 2) exactly)
+reducer = FrameReducer('max', size(cycles, 1));
+for cycle = 1:size(cycles, 2)
+    reducer.add(cycles(:, cycle));
+end
+isequal(double(reducer.get_result()), max(double(cycles), [], 2))
+
+%% Online min (should match min(cycles, [], 2) exactly)
+reducer = FrameReducer('min', size(cycles, 1));
+for cycle = 1:size(cycles, 2)
+    reducer.add(cycles(:, cycle));
+end
+isequal(double(reducer.get_result()), min(double(cycles), [], 2))
+
+%% Online variance (should match var(cycles, 0, 2), relative error < 1e-4)
+reducer = FrameReducer('var', size(cycles, 1));
+for cycle = 1:size(cycles, 2)
+    reducer.add(cycles(:, cycle));
+end
+max(abs(double(reducer.get_result()) - var(double(cycles), 0, 2)) ./ max(var(double(cycles), 0, 2), 1))
+
+%% Online median, on the first median_buffer_depth cycles (should be exact)
+reducer = FrameReducer('median', size(cycles, 1));
+for cycle = 1:reducer.median_buffer_depth
+    reducer.add(cycles(:, cycle));
+end
+isequal(double(reducer.get_result()), median(double(cycles(:, 1:reducer.median_buffer_depth)), 2))
+
+%% DataHolder mean, with FIFO blocks of 7 points (should match mean(cycles, 2), error < 1e-2)
+holder = DataHolder([1, size(cycles, 1)], size(cycles, 2), 'mean');
+stream = cycles(:);
+for block = 1:7:numel(stream)
+    data = stream(block:min(block + 6, end));
+    holder.update(data, data);
+end
+reduced = holder.get_reduced_data();
+max(abs(double(reduced(:, 1)) - mean(double(cycles), 2)))
@@ -0,0 +1,40 @@
+tile_size = [128, 96]; % not square, so that X and Y wrap differently
+image = conv2(rand(340, 260, 'single'), ones(3, 'single') / 9, 'same');
+folder = fullfile(tempdir, ['mosaic_test_', num2str(randi(1e9))]);
+mosaic = MosaicStitcher(folder, tile_size, 0.5, [0, 0], [100, 75], 1, 1); % 0.5 um pixels
+
+%% First tile, at [200, 150] px (should be placed at its stage position, it is never refined)
+tile = image(200 + (1:tile_size(1)), 150 + (1:tile_size(2)));
+mosaic.add_tile(tile, [200, 150] * 0.5)
+
+%% Overlapping tile, at [100, 150] px with a [3, -2] px stage error (should be placed at [100, 150])
+tile = image(100 + (1:tile_size(1)), 150 + (1:tile_size(2)));
+mosaic.add_tile(tile, [103, 148] * 0.5)
+
+%% Overlapping tile, at [200, 75] px with a [-4, 4] px stage error (should be placed at [200, 75])
+tile = image(200 + (1:tile_size(1)), 75 + (1:tile_size(2)));
+mosaic.add_tile(tile, [196, 79] * 0.5)
+
+%% Remaining tiles of a 3 x 3 grid, with random stage errors (should be placed at their true position)
+tic
+for offset = [100, 75; 0, 150; 0, 75; 200, 0; 100, 0]'
+    tile = image(offset(1) + (1:tile_size(1)), offset(2) + (1:tile_size(2)));
+    placed = mosaic.add_tile(tile, (offset' + randi([-4, 4], 1, 2)) * 0.5);
+    [offset'; placed]
+end
+toc
+
+%% Tile clipped by the mosaic edge, with a negative stage error (should be placed at [0, 0])
+tile = image(1:tile_size(1), 1:tile_size(2));
+mosaic.add_tile(tile, [-4, -3] * 0.5)
+
+%% Blended mosaic (should match the original image, error < 1e-4)
+full = mosaic.read(0);
+max(abs(full - image(1:mosaic.mosaic_size(1), 1:mosaic.mosaic_size(2))), [], 'all')
+figure();imagesc(full);axis image;title('Blended mosaic of the 9 tiles')
+
+%% Downsampled level 1 (should be up to date with the tiles, error < 1e-4)
+max(abs(mosaic.read(1) - FramePyramid.downsample(full, 1)), [], 'all')
+
+clear mosaic % release the memory-mapped files
+rmdir(folder, 's');
@@ -7,6 +7,11 @@ test_full_frame_special_cases = true;
 test_miniscans_fixed_length  = true;
 test_miniscan_rotations = true;
 test_miniscans_variable_length_or_res = true;
+test_scan_layout = true;
+test_line_schedule = true;
+test_derived_cache = true;
+test_scan_path = true;
+test_pockels_lut = true;
 
 %% Initial reset
 c.reset_scan_params('raster')
@@ -284,4 +289,245 @@ if test_miniscans_variable_length_or_res
     c.scan_params.plot_drives('full');title('Miniscan mode, patch, based on full frame downsampled to 128 lines, with X resampling to variable number of voxels per line and length')
     toc
     
-end
\ No newline at end of file
+end
+
+
+if test_scan_layout
+
+    %% ===================
+    %% Testing ScanLayout tiles against a per-line loop
+    %% ===================
+
+    %% 4 patches of 16 lines, with a different resolution each (should give patch_size [8, 16; 16, 16; 4, 16; 12, 16])
+    c.reset_frame_and_send('miniscan', 64);
+    c.scan_params.fixed_res = false;
+    c.scan_params.voxels_for_ramp = repelem([8, 16, 4, 12], 16);
+    layout = ScanLayout(c.scan_params);
+    layout.patch_size
+
+    %% Random stream of 2 channels, in the timed_image format, split into tiles
+    n_cycles = 500;
+    data = randi(2^16 - 1, layout.n_points * n_cycles, 2, 'uint16');
+    tic
+    tiles = layout.to_tiles(data);
+    toc
+
+    %% Reference : copy each line of each patch (should be slower, and give the same tiles)
+    tic
+    stream = reshape(data, layout.n_points, n_cycles, 2);
+    line_end = cumsum(c.scan_params.voxels_for_ramp);
+    ref = cell(1, layout.n_patches);
+    for p = 1:layout.n_patches
+        ref{p} = zeros(layout.patch_size(p, 1), layout.patch_size(p, 2), n_cycles, 2, 'uint16');
+        for l = 1:layout.patch_size(p, 2)
+            line = layout.first_line(p) + l - 1;
+            ref{p}(:, l, :, :) = reshape(stream(line_end(line) - layout.patch_size(p, 1) + 1:line_end(line), :, :), [], 1, n_cycles, 2);
+        end
+    end
+    toc
+    isequal(tiles, ref)
+
+    %% Tiles back to the stream (should restore the original data)
+    isequal(layout.to_stream(tiles), data)
+end
+
+
+if test_line_schedule
+
+    %% ===================
+    %% Testing ScanParams.line_schedule against the per-line loop
+    %% ===================
+
+    %% Random line durations, without MC, then with 2 MC interrupt settings (should match the per-line loop, error < 1e-9 s)
+    n_lines = 100;
+    n_cycles = 200;
+    line_duration = (10 + 40 * rand(1, n_lines)) * 1e-6;
+    for MC = [0, 0; 1e-3, 2e-3; 0.3e-3, 0.5e-3]'
+        [MC_duration, MC_rate] = deal(MC(1), MC(2));
+        tic
+        [t_line, total_duration] = ScanParams.line_schedule(line_duration, n_cycles, MC_duration, MC_rate);
+        toc
+
+        %% Reference : the previous get_fps loop, over all lines of all cycles (should be much slower)
+        tic
+        t_ref = NaN(1, n_lines * n_cycles);
+        t = 0;
+        t_reset = 0;
+        first_cycle = true;
+        n_lines_for_reset = 3;
+        for line_n = 0:(n_lines * n_cycles - 1)
+            in_cycle_line_nb = mod(line_n, n_lines) + 1;
+            current_line_duration = line_duration(in_cycle_line_nb);
+
+            %% Each cycle starts with a MC cycle, except the first one which starts at t = 0
+            if in_cycle_line_nb == 1
+                if ~first_cycle
+                    t_reset = t;
+                    t = t + MC_duration;
+                end
+                first_cycle = false;
+                extra_remaining_lines = n_lines_for_reset;
+                current_intercycle_delta = 0;
+            end
+            t_ref(line_n + 1) = t;
+
+            previous_intercycle_delta = current_intercycle_delta;
+            current_intercycle_delta = mod((t - t_reset) + current_line_duration, MC_rate);
+            t = t + current_line_duration;
+            if extra_remaining_lines < n_lines_for_reset
+                extra_remaining_lines = extra_remaining_lines - 1;
+            end
+            if current_intercycle_delta < previous_intercycle_delta && extra_remaining_lines == n_lines_for_reset
+                extra_remaining_lines = n_lines_for_reset - 1;
+            end
+            if extra_remaining_lines == 0
+                t_reset = t + current_line_duration;
+                t = t_reset + MC_duration;
+                current_intercycle_delta = 0;
+                extra_remaining_lines = n_lines_for_reset;
+            end
+        end
+        total_ref = t_ref(end) + line_duration(end);
+        toc
+        schedule_error = [max(abs(t_line - t_ref)), abs(total_duration - total_ref)]
+    end
+end
+
+
+if test_derived_cache
+
+    %% ===================
+    %% Testing the ScanParams derived value cache and its invalidation
+    %% ===================
+
+    c.reset_frame_and_send('raster', 256);
+    sp = c.scan_params;
+
+    %% Cached reads (should not change cache_version, and be much faster than recomputing)
+    start = sp.start_norm;
+    version = sp.cache_version;
+    tic
+    for n = 1:100
+        start = sp.start_norm;
+    end
+    toc
+    sp.cache_version == version
+    tic
+    for n = 1:100
+        sp.invalidate_cache();
+        start = sp.start_norm;
+    end
+    toc
+
+    %% Change the resolution (should update num_drives to 128)
+    sp.mainscan_x_pixel_density = 128;
+    sp.num_drives
+
+    %% Rotate, then reset the angles (should change start_norm, then restore it)
+    unrotated = sp.start_norm;
+    sp.angles = [0, 0, 45];
+    isequal(sp.start_norm, unrotated)
+    sp.angles = [0, 0, 0];
+    isequal(sp.start_norm, unrotated)
+
+    %% Offset in Y (should shift start_norm by 0.5)
+    sp.start_norm_raw = [0; 0.5; 0];
+    sp.start_norm(:, 1) - unrotated(:, 1)
+    sp.start_norm_raw = [0; 0; 0];
+
+    %% Old headers, without mainscan_x_pixel_density (should use mainscan_voxel_density_1D, and update num_drives to 256 then 128)
+    sp.mainscan_x_pixel_density = [];
+    sp.mainscan_voxel_density_1D = 256;
+    sp.num_drives
+    sp.mainscan_voxel_density_1D = 128;
+    sp.num_drives
+    sp.mainscan_voxel_density_1D = [];
+    sp.mainscan_x_pixel_density = 256;
+
+    %% Miniscans, same number of ramps (should keep pockels_raw)
+    c.reset_frame_and_send('miniscan', 64);
+    sp = c.scan_params;
+    sp.pockels_raw = 1;
+    sp.start_norm_raw = sp.start_norm_raw;
+    size(sp.pockels_raw)
+
+    %% Miniscans, half of the ramps (should clear pockels_raw, and update num_drives to 32)
+    half = 1:(sp.num_drives / 2);
+    sp.start_norm_raw = sp.start_norm_raw(:, half);
+    sp.pockels_raw
+    sp.stop_norm_raw = sp.stop_norm_raw(:, half);
+    sp.num_drives
+
+    c.reset_frame_and_send('raster');
+end
+
+
+if test_scan_path
+
+    %% ===================
+    %% Testing optimise_scan_path groupings
+    %% ===================
+
+    c.reset_frame_and_send('raster');
+    transform = c.aol_params.get_transform(c.scan_params.acceptance_angle, c.scan_params.mainscan_x_pixel_density);
+
+    %% Points along 20 random segments, some closer than one voxel, and 100 isolated points
+    points = [];
+    for segment = 1:20
+        direction = [randn(2, 1); 0];
+        direction = direction / norm(direction);
+        spacing = 0.4 + rand() * 1.5;
+        points = [points, [randi([100, 400], 2, 1); 0] + direction * (0:spacing:20)]; %#ok<AGROW>
+    end
+    points = [points, [randi(512, 2, 100); zeros(1, 100)]];
+    tolerance = 0.5;
+
+    %% Group the points into ramps (should be faster than one drive per point)
+    tic
+    [start, stop, res, point_map, report] = optimise_scan_path(transform.pixels_to_norm(points), c.scan_params, tolerance, 8, 0, true);
+    toc
+    report
+    figure();plot(points(1, :), points(2, :), 'o');hold on
+    start_px = transform.norm_to_pixels(start);
+    stop_px = transform.norm_to_pixels(stop);
+    plot([start_px(1, :); stop_px(1, :)], [start_px(2, :); stop_px(2, :)], 'k-');title('optimise\_scan\_path : points and grouped ramps')
+
+    %% Voxel of each point (should be one distinct voxel per point, within its ramp, and within sqrt(2) x tolerance of the point)
+    size(unique(point_map', 'rows'), 1) == size(points, 2)
+    all(point_map(2, :) >= 1 & point_map(2, :) <= res(point_map(1, :)))
+    frac = (point_map(2, :) - 1) ./ max(res(point_map(1, :)) - 1, 1);
+    voxel_px = start_px(:, point_map(1, :)) + (stop_px(:, point_map(1, :)) - start_px(:, point_map(1, :))) .* frac;
+    max(vecnorm(voxel_px - points))
+
+    %% Longest ramp (should not exceed ScanParams.MAX_SCAN_TIME)
+    max(res) * c.aol_params.discretize(c.scan_params.voxel_time)
+end
+
+if test_pockels_lut
+
+    %% ===================
+    %% Testing PockelsLut as pockels_raw
+    %% ===================
+
+    lut = PockelsLut(-50, 50, 1.2, 0.4);
+
+    %% Miniscan, one value per ramp (should follow the depth of each ramp)
+    c.reset_frame_and_send('miniscan', 64);
+    c.scan_params.start_norm_raw(3, :) = linspace(-0.5, 0.5, c.scan_params.num_drives);
+    c.scan_params.stop_norm_raw(3, :) = c.scan_params.start_norm_raw(3, :);
+    tic
+    c.scan_params.pockels_raw = lut;
+    toc
+    figure();plot(c.scan_params.pockels_raw');title('Miniscan, PockelsLut value of each ramp, for each AOD')
+
+    %% Pointing, one value per point of the grid (should be [4 x 64^2], all equal)
+    c.reset_frame_and_send('pointing', 64);
+    c.scan_params.start_norm_raw = [0; 0; 0.3];
+    tic
+    c.scan_params.pockels_raw = lut;
+    toc
+    size(c.scan_params.pockels_raw)
+    unique(c.scan_params.pockels_raw)
+
+    c.reset_frame_and_send('raster');
+end
@@ -0,0 +1,45 @@
+frame_size = [64, 48];
+stack = single(randi([0, 2^16-1], [frame_size, 3, 2, 4])); % 3 planes, 2 channels, 4 repeats
+stack(1:5, 1:5, 1, 1, 2) = NaN; % some missing pixels
+folder = fullfile(tempdir, ['stack_store_test_', num2str(randi(1e9))]);
+store = StackStore(folder, frame_size, 3, 2, 4);
+
+%% Encode and decode one frame with the default filter and compression (should be reversible, NaN included)
+bytes = StackStore.encode(stack(:, :, 1, 1, 2), 'deflate', 'shuffle');
+isequaln(reshape(StackStore.decode(bytes, 'deflate', 'shuffle', prod(frame_size)), frame_size), stack(:, :, 1, 1, 2))
+
+%% Same with the delta filter (should be reversible)
+bytes = StackStore.encode(stack(:, :, 1, 1, 2), 'deflate', 'delta');
+isequaln(reshape(StackStore.decode(bytes, 'deflate', 'delta', prod(frame_size)), frame_size), stack(:, :, 1, 1, 2))
+
+%% Same without filter nor compression (should be reversible)
+bytes = StackStore.encode(stack(:, :, 1, 1, 2), 'none', 'none');
+isequaln(reshape(StackStore.decode(bytes, 'none', 'none', prod(frame_size)), frame_size), stack(:, :, 1, 1, 2))
+
+%% Write all repeats, plane by plane (should fill repeats_done with 4)
+tic
+for r = 1:4
+    for p = 1:3
+        store.write(p, r, stack(:, :, p, :, r));
+    end
+end
+toc
+store.repeats_done
+
+%% Read the repeats back (should be identical to the written stack)
+isequaln(store.read_repeats(), stack)
+
+%% Read the mean (should match nanmean over the repeats, error < 1e-2)
+max(abs(store.read_mean() - nanmean(stack, 5)), [], 'all')
+
+%% Write repeat 3 of plane 2 again (should replace it in the mean, and leave repeats_done unchanged)
+stack(:, :, 2, :, 3) = single(randi([0, 2^16-1], [frame_size, 1, 2]));
+store.write(2, 3, stack(:, :, 2, :, 3));
+store.repeats_done
+max(abs(store.read_mean() - nanmean(stack, 5)), [], 'all')
+
+%% Reopen the store from its folder (should give the same mean)
+reopened = StackStore(folder);
+isequaln(reopened.read_mean(), store.read_mean())
+
+rmdir(folder, 's');
@@ -0,0 +1,113 @@
+%% This scripts test the host-side MC tools (estimation, simulated MC
+% loop, automatic thresholds and offline registration) on synthetic
+% frames with known displacements.
+
+test_estimator = true;
+test_mc_loop = true;
+test_auto_thresholds = true;
+test_offline_registration = true;
+
+%% Synthetic reference: a gaussian object, and its Z profile on the Z lines
+roi_size    = 32;
+z_lines     = 8;
+[x, y]      = ndgrid(1:roi_size, 1:roi_size);
+object      = @(dx, dy) 1000 * exp(-((x - 14 - dx).^2 + (y - 17 - dy).^2) / 18);
+profile     = @(dz) repmat(1000 * exp(-((1:roi_size)' - 15 - dz).^2 / 18), 1, z_lines);
+reference   = [object(0, 0), profile(0)];
+
+if test_estimator
+
+    %% ===================
+    %% Testing MCEstimator
+    %% ===================
+
+    %% Generate 1000 frames with known integer displacements
+    n_frames = 1000;
+    shifts = randi([-4, 4], n_frames, 3);
+    frames = zeros(roi_size, roi_size + z_lines, n_frames, 'single');
+    for frame = 1:n_frames
+        frames(:,:,frame) = [object(shifts(frame, 1), shifts(frame, 2)), profile(shifts(frame, 3))];
+    end
+
+    %% Centroid method (should recover the displacements, error < 0.05 px)
+    estimator = MCEstimator(reference, [0, 0], z_lines, 'centroid');
+    tic
+    displacement = estimator.estimate(frames);
+    toc
+    max_error = max(abs(displacement(:) - shifts(:)))
+    figure();plot(shifts, displacement, '.');title('MCEstimator, centroid method : estimated vs true X, Y and Z displacements')
+
+    %% Phase method (should recover the displacements, error < 0.05 px)
+    estimator = MCEstimator(reference, [0, 0], z_lines, 'phase');
+    tic
+    displacement = estimator.estimate(frames);
+    toc
+    max_error = max(abs(displacement(:) - shifts(:)))
+    figure();plot(shifts, displacement, '.');title('MCEstimator, phase method : estimated vs true X, Y and Z displacements')
+end
+
+if test_mc_loop
+
+    %% ===================
+    %% Testing the simulated MC loop
+    %% ===================
+
+    %% Constant displacement, 2 proportional gains (should converge to [3, -2, 1] for both)
+    % The integral term removes the steady state error left by the
+    % proportional term alone, for any stable gain (P < 1 here)
+    motion = repmat([3, -2, 1], 5000, 1);
+    params = struct('proportianal_x10', {5, 9});
+    tic
+    correction = simulate_MC_loop(reference, motion, params, z_lines);
+    toc
+    final_correction = squeeze(correction(end, :, :))'
+    figure();plot(correction(:, :, 1));title('Simulated MC loop, P = 0.5 : X, Y and Z correction for a constant displacement')
+end
+
+if test_auto_thresholds
+
+    %% ===================
+    %% Testing auto_MC_thr
+    %% ===================
+
+    %% Noisy reference, background at 100 (should give an XY threshold between 130 and 1000, a Z threshold above 130 and a Z SNR above 10)
+    background = 100;
+    noisy = uint16(reference + background + 10 * randn(size(reference)));
+    tic
+    [thresholds, snr_z] = auto_MC_thr(noisy)
+    toc
+    figure();imagesc(noisy > thresholds(1));axis image;title('auto\_MC\_thr : pixels above the XY threshold')
+end
+
+if test_offline_registration
+
+    %% ===================
+    %% Testing register_from_mc_log
+    %% ===================
+
+    %% 200 frames, with an MC log starting 2 s before the acquisition
+    % Each frame has a known integer displacement, held in the log for
+    % the whole frame
+    n_reg = 200;
+    period = 0.01;
+    lead = 2;
+    reg_shifts = randi([-3, 3], n_reg, 2);
+    frames = zeros(roi_size, roi_size, n_reg, 'single');
+    for frame = 1:n_reg
+        frames(:,:,frame) = object(reg_shifts(frame, 1), reg_shifts(frame, 2));
+    end
+    record_t = -lead:1e-3:n_reg * period;
+    in_frame = min(max(floor(record_t / period) + 1, 1), n_reg);
+    mc_log = struct('Time', record_t + lead, 'Acquisition_start', lead,...
+                    'X_difference', reg_shifts(in_frame, 1)', 'Y_difference', reg_shifts(in_frame, 2)');
+    line_times = period / 4 + (0:roi_size - 1)' * period / (2 * roi_size) + (0:n_reg - 1) * period; % away from frame boundaries
+
+    %% Register the frames (should align every frame on the reference, error < 0.01 away from the edges)
+    tic
+    registered = register_from_mc_log(frames, mc_log, 1, line_times);
+    toc
+    crop = 5:roi_size - 4;
+    expected = object(0, 0);
+    max_error = max(max(max(abs(registered(crop, crop, :) - expected(crop, crop)))))
+    figure();imagesc([mean(frames, 3), mean(registered, 3)]);axis image;title('register\_from\_mc\_log : mean frame before (left) and after (right) registration')
+end
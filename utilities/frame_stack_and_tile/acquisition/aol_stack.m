@@ -4,7 +4,7 @@
 %
 % -------------------------------------------------------------------------
 % Syntax: 
-%   stack = aol_stack(controller, stack_parameters, varargin)
+%   [stack, dead_time] = aol_stack(controller, stack_parameters, varargin)
 %
 % -------------------------------------------------------------------------
 % Inputs: 
@@ -37,11 +37,21 @@
 %                                   - When using dynamic stack, one 
 %                                   cell per selected reference:
 %
+%   dead_time([num_planes x repeats] DOUBLE) : 
+%                                   In s, the time between the end of the
+%                                   previous recording and the start of the
+%                                   recording of each plane
+%
 % -------------------------------------------------------------------------
 % Extra Notes:
 % * Unless specified, aol_stack uses the current controller stack_params. 
 %   For other settings than the current ones, you can either pass some 
 %   settings as Name-Arguments pairs, or pass a stack_params object
+%
+% * If stack_parameters.precalculate_drives is true, the drives of all
+%   planes are computed before the stack starts (see
+%   precalculate_stack_drives), and only uploaded between planes. The dead
+%   time between planes is returned in dead_time (see stack_generic)
 % -------------------------------------------------------------------------
 % Examples: 
 %
@@ -86,12 +96,12 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   07-02-2018
+%   18-10-2026
 %
-% See also: stack_params, stack_generic
+% See also: stack_params, stack_generic, precalculate_stack_drives
 %
 
-function stack = aol_stack(controller, stack_parameters, varargin)
+function [stack, dead_time] = aol_stack(controller, stack_parameters, varargin)
     if nargin < 1 || isempty(controller)
         controller = get_existing_controller_name(true);
     end
@@ -108,6 +118,7 @@ function stack = aol_stack(controller, stack_parameters, varargin)
     %% Prepare the initial conditions
     controller.xyz_stage.move_to_stack_center(stack_parameters.move_to_stack_center); % Move stage if required
     stage_pos = controller.xyz_stage.get_position(3);
+    transform = controller.aol_params.get_transform(controller.scan_params.acceptance_angle, controller.scan_params.mainscan_x_pixel_density, stage_pos); % um plane positions to z norm
         
     %% Adjust angles depending on stack type
     initial_scan_params = controller.scan_params;
@@ -120,12 +131,21 @@ function stack = aol_stack(controller, stack_parameters, varargin)
     end
     
     %% Prepare function handle that will be called at each plane
-    function func(position, generate_viewer) % use a closure to make a single variable function with the desired params.
-        norm_position = controller.aol_params.convert_z_um_to_norm(position, controller.scan_params.acceptance_angle, stage_pos);
-        controller.scan_params.start_norm_raw(3) = norm_position;
-        controller.send_drives(generate_viewer);
+    function func(position, generate_viewer, drives) % use a closure to make a single variable function with the desired params.
+        if nargin < 3 % compute and send drives
+            controller.scan_params.start_norm_raw(3) = transform.z_um_to_norm(position);
+            controller.send_drives(generate_viewer);
+        else % only upload the precalculated drives
+            controller.scan_params.start_norm_raw(3) = drives.z_norm;
+            controller.send_drives(generate_viewer, controller.pockels.on_value, drives.xy_records, drives.drive_coeffs);
+        end
+    end
+
+    %% Prepare function handle that precalculates the drives of all planes
+    function plane_drives = prepare_func(positions, pockels)
+        plane_drives = precalculate_stack_drives(controller, transform.z_um_to_norm(positions), pockels);
     end
 
     %% Get stack
-    stack = stack_generic(controller, @func, stack_parameters, initial_scan_params);
+    [stack, dead_time] = stack_generic(controller, @func, stack_parameters, initial_scan_params, @prepare_func);
 end
\ No newline at end of file
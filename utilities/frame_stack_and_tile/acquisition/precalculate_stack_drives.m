@@ -0,0 +1,133 @@
+%% Precalculate the drives of all the planes of an AOL stack
+% Drives of each plane are computed before the stack starts, so that only
+% the upload remains between two planes. Drive coefficients are computed
+% in parallel if a parallel pool is already open.
+%
+% -------------------------------------------------------------------------
+% Syntax:
+%   plane_drives = precalculate_stack_drives(controller, z_norm, pockels)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   controller(Controller object):
+%                                   Contains information about the
+%                                   microscope setup. The current
+%                                   Controller.scan_params and aol_params
+%                                   are used for all planes.
+%
+%   z_norm([1 x N] FLOAT):
+%                                   Normalised Z offset of each plane, as
+%                                   set in scan_params.start_norm_raw(3)
+%
+%   pockels([1 x N] FLOAT) - Optional - Default is current pockel value:
+%                                   Pockel cell value of each plane
+% -------------------------------------------------------------------------
+% Outputs:
+%   plane_drives({1 x N} Cell array of STRUCT):
+%                                   For each plane, a struct with z_norm,
+%                                   xy_records and drive_coeffs fields.
+%                                   xy_records and drive_coeffs can be
+%                                   passed to Controller.send_drives.
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Drives are identical to the ones Controller.send_drives would compute
+%   for each plane. Use them after setting start_norm_raw(3) to z_norm, so
+%   that scan_params and the timing table match the uploaded drives.
+%
+% * No pool is started. If one is open, workers get a copy of scan_params
+%   and aol_params and only compute the drive coefficients. Without a
+%   pool, the coefficients are computed on the client.
+%
+% * Records are always built on the client by SynthFpga.load, from the
+%   precalculated coefficients (in pointing mode, records generation sends
+%   the plane size to the AOL Control FPGA). Controller.scan_params is
+%   restored at the end.
+% -------------------------------------------------------------------------
+% Examples:
+% * Precalculate drives for 3 planes, then send the second one
+%   drives = precalculate_stack_drives(c, [-0.1, 0, 0.1], [0.2, 0.3, 0.4]);
+%   c.scan_params.start_norm_raw(3) = drives{2}.z_norm;
+%   c.send_drives(false, 0.3, drives{2}.xy_records, drives{2}.drive_coeffs);
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: stack_generic, aol_stack, drives.precalculate_drives,
+%   SynthFpga.load
+
+function plane_drives = precalculate_stack_drives(controller, z_norm, pockels)
+    if nargin < 3 || isempty(pockels)
+        pockels = controller.pockels.on_value;
+    end
+    n_planes        = numel(z_norm);
+    pockels(end+1:n_planes) = pockels(end);
+
+    %% Local copies, so that workers don't need the controller
+    aol_params      = controller.aol_params;
+    scan_params     = controller.scan_params;
+    synth_fpga      = controller.synth_fpga;
+    z_pixel_size_um = controller.daq_fpga.z_pixel_size_um;
+    initial_z       = scan_params.start_norm_raw(3);
+    initial_pockels = scan_params.pockels_raw;
+    cleanupObj      = onCleanup(@() restore_plane(scan_params, initial_z, initial_pockels));
+
+    %% Compute the coefficients of each plane, on the open pool if any
+    drive_coeffs    = cell(1, n_planes);
+    parfor (plane = 1:n_planes, open_pool_size())
+        plane_params = scan_params; % a copy on workers, the client handle otherwise
+        plane_params.start_norm_raw(3) = z_norm(plane);
+        plane_params.pockels_raw = pockels(plane);
+        drive_coeffs{plane} = drives_for_synth_fpga(aol_params, plane_params);
+    end
+
+    %% Build the records of each plane on the client
+    xy_records      = cell(1, n_planes);
+    for plane = 1:n_planes
+        scan_params.start_norm_raw(3) = z_norm(plane);
+        xy_records{plane} = synth_fpga.load(aol_params, scan_params, false, scan_params.num_drives, scan_params.acceptance_angle, z_pixel_size_um, pockels(plane), [], drive_coeffs{plane});
+    end
+
+    plane_drives    = cellfun(@(z, r, d) struct('z_norm', z, 'xy_records', {r}, 'drive_coeffs', d),...
+                              num2cell(z_norm(:)'), xy_records, drive_coeffs, 'UniformOutput', false);
+end
+
+function n_workers = open_pool_size()
+    %% Number of workers of the current pool, without starting one
+    n_workers = 0;
+    if license('test', 'Distrib_Computing_Toolbox')
+        pool = gcp('nocreate');
+        if ~isempty(pool)
+            n_workers = pool.NumWorkers;
+        end
+    end
+end
+
+function restore_plane(scan_params, initial_z, initial_pockels)
+    %% Restore the client scan_params if planes were computed locally
+    scan_params.start_norm_raw(3) = initial_z;
+    scan_params.pockels_raw = initial_pockels;
+end
@@ -3,7 +3,8 @@
 % motor stack function as it requires a function handle.
 % -------------------------------------------------------------------------
 % Syntax: 
-%   stack = stack_generic(controller, func, stack_params, initial_scan_params)
+%   [stack, dead_time] = stack_generic(controller, func, stack_params,
+%                                      initial_scan_params, prepare_func)
 %
 % -------------------------------------------------------------------------
 % Inputs: 
@@ -25,6 +26,16 @@
 %                                   the initial Controller.scan_params
 %                                   You can pass any desired final state of
 %                                   the scan. This can be useful
+%
+%   prepare_func(function handle) - Optional - default is []
+%                                   If provided, and if
+%                                   stack_parameters.precalculate_drives is
+%                                   true, called once before the stack as
+%                                   prepare_func(plane_positions, pockels).
+%                                   It must return a {1 x num_planes} cell
+%                                   array of drives, and func is then called
+%                                   with the drives of the plane as a third
+%                                   argument.
 % -------------------------------------------------------------------------
 % Outputs:
 %
@@ -37,10 +48,36 @@
 %                                   NChannels = number of channel acquired
 %                                               by timed_image
 %
+%   dead_time([num_planes x repeats] DOUBLE) : 
+%                                   In s, the time spent between the end of
+%                                   the previous recording and the start of
+%                                   the recording of each plane
+%
 % -------------------------------------------------------------------------
 % Extra Notes:
 % * For stack fine control, many options are available. Check stack_params
 %   for detailed explanations.
+%
+% * With prepare_func, the drives of all planes are computed before the
+%   first plane (see precalculate_stack_drives). Between two planes, only
+%   the upload of the precomputed records, the pockels and the data storage
+%   remain. The AOL Control FPGA plays the current drives until the end of
+%   a recording, so the upload can't start earlier than that. Mean and max
+%   dead time are printed at the end of the stack unless silent is true.
+%
+% * If stack_parameters.store_folder is set, each plane is written to a
+%   StackStore as soon as it is recorded, and the mean across repeats is
+%   updated on disk. Only the final mean stack is loaded in memory. Each
+%   run creates its own timestamped subfolder (stack_yyyy-mm-dd_HH-MM-SS),
+%   so the same store_folder can be reused for successive stacks.
+%
+% * The Pockels value of each plane comes from a PockelsLut built for the
+%   stack limits (see StackAndTiles.get_pockels_lut), so values are
+%   interpolated between pockels_start and pockels_stop.
+%
+% * If stack_parameters.mosaic is set, the mean stack is added to the
+%   MosaicStitcher as a tile, at the stage position where the stack was
+%   acquired.
 % -------------------------------------------------------------------------
 % Examples: 
 % -------------------------------------------------------------------------
@@ -69,16 +106,17 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   12-10-2018
+%   18-10-2026
 %
-% See also: aol_stack, motor_stack, test_z_scaling, stack_post_processing
+% See also: aol_stack, motor_stack, test_z_scaling, stack_post_processing,
+%   precalculate_stack_drives, StackStore
 %
 
 % TODO : 
 %- not sure about the resolution part. Maybe we should use mainscan values 
 %- for y rotation, we can chose between linear and nonlinear drives
 
-function mean_stack = stack_generic(controller, func, stack_params, initial_scan_params)
+function [mean_stack, dead_time] = stack_generic(controller, func, stack_params, initial_scan_params, prepare_func)
     if nargin < 1 || isempty(controller)
         controller = get_existing_controller_name(true);
     end
@@ -86,6 +124,9 @@ function mean_stack = stack_generic(controller, func, stack_params, initial_scan
     if nargin < 4 || isempty(initial_scan_params)
         initial_scan_params = controller.scan_params;       
     end
+    if nargin < 5
+        prepare_func = [];
+    end
     
     initial_stage_position = controller.xyz_stage.get_position();
     initial_pockel_value = controller.pockels.on_value(); 
@@ -115,11 +156,27 @@ function mean_stack = stack_generic(controller, func, stack_params, initial_scan
     total_frames    = stack_params.repeats * stack_params.num_planes*ncycle;
     elapsed         = tic;   
     total_counter   = zeros(1,1);
+    dead_time       = NaN(stack_params.num_planes, stack_params.repeats);
+    
+    %% Precalculate the drives of all planes, so that only uploads remain between planes
+    plane_drives    = cell(1, stack_params.num_planes);
+    if stack_params.precalculate_drives && ~isempty(prepare_func)
+        plane_drives = prepare_func(round(plane_position), poc_val);
+    end
     
-    %% Preallocate memory for positive & dynamic stack
-    positive_stack               = {zeros(res_x, res_y, stack_params.num_planes, 2, stack_params.repeats, 'single')};
+    %% Preallocate memory for positive & dynamic stack, or create the on-disk store
+    if isempty(stack_params.store_folder)
+        positive_stack           = {zeros(res_x, res_y, stack_params.num_planes, 2, stack_params.repeats, 'single')};
+    else
+        store_folder             = fullfile(stack_params.store_folder, ['stack_', datestr(now, 'yyyy-mm-dd_HH-MM-SS')]);
+        store                    = StackStore(store_folder, [res_x, res_y], stack_params.num_planes, 2, stack_params.repeats);
+        if ~stack_params.silent
+            fprintf('Writing stack in %s\n', store_folder);
+        end
+    end
   
     %% Iterate though planes and get data
+    gap = tic; % time since the end of the last recording
     for r = 1:stack_params.repeats
         if ~stack_params.silent
             fprintf('########## stack %d/%d ############\n',r , stack_params.repeats)
@@ -135,8 +192,15 @@ function mean_stack = stack_generic(controller, func, stack_params, initial_scan
         
         while ~all(plan_completed)
             plane_num = plane_order(counter);
-            set_current_stack_plane(controller, poc_val, plane_position, plane_num, plane_order, func);
-            positive_stack{1}(:,:,plane_num,:,r) = controller.single_record(stack_params.averages, reuse_viewer, stack_params.averages_method); % First plane create the holder. next ones will just reset it
+            set_current_stack_plane(controller, poc_val, plane_position, plane_num, plane_order, func, plane_drives{plane_num});
+            dead_time(plane_num, r) = toc(gap);
+            data = controller.single_record(stack_params.averages, reuse_viewer, stack_params.averages_method); % First plane create the holder. next ones will just reset it
+            gap = tic;
+            if isempty(stack_params.store_folder)
+                positive_stack{1}(:,:,plane_num,:,r) = data;
+            else
+                store.write(plane_num, r, data);
+            end
             plan_completed = (counter == abs(stack_params.num_planes));
             counter = counter + 1;
             status = 1;
@@ -151,9 +215,21 @@ function mean_stack = stack_generic(controller, func, stack_params, initial_scan
     %% Finalise Scan - Resume MC if required
     cleanMeUp(controller, initial_scan_params, initial_stage_position, initial_pockel_value, stack_params);
     well_done_stack = true; % If the code didn't crash, cleanup handle will be ignored upon exit
+    if ~stack_params.silent
+        fprintf('Dead time between planes : %.1f ms mean, %.1f ms max (%.2f s in total)\n', 1e3 * nanmean(dead_time(:)), 1e3 * max(dead_time(:)), nansum(dead_time(:)));
+    end
     
     %% Do any required computation
-    mean_stack = {nanmean(positive_stack{1}, 5)};
+    if isempty(stack_params.store_folder)
+        mean_stack = {nanmean(positive_stack{1}, 5)};
+    else
+        mean_stack = {store.read_mean()};
+    end
+    
+    %% Add the stack to the mosaic, at the stage position of the stack
+    if ~isempty(stack_params.mosaic)
+        stack_params.mosaic.add_tile(mean_stack{1}, initial_stage_position);
+    end
     
     %% Show final result once finished.
     if stack_params.plot
@@ -209,27 +285,26 @@ end
 
 function poc_val = set_pockels_range(controller, stack_params, plane_position)
     if stack_params.use_default_stack_limits == true % if false, pockel range is read form stack_params
-        poc_val = controller.xyz_stage.get_pockels_vs_Z_values( stack_params.interpolation_mode,...
-                                                                stack_params.pockels_start,...
-                                                                stack_params.pockels_stop,...
-                                                                plane_position); % QQ possibly not ok for non z stacks if stack_params.pockels_start and stack_params.pockels_stop are different
+        xyz = controller.xyz_stage;
     else
        xyz = StackAndTiles();
        xyz.z_stop = stack_params.stack_stop;
        xyz.z_start = stack_params.stack_start;
-       poc_val = xyz.get_pockels_vs_Z_values(   stack_params.interpolation_mode,...
-                                                stack_params.pockels_start,...
-                                                stack_params.pockels_stop,...
-                                                plane_position); % QQ possibly not ok for non z stacks if stack_params.pockels_start and stack_params.pockels_stop are different
     end
+    lut = xyz.get_pockels_lut(stack_params.interpolation_mode, stack_params.pockels_start, stack_params.pockels_stop);
+    poc_val = lut.evaluate(plane_position); % QQ possibly not ok for non z stacks if stack_params.pockels_start and stack_params.pockels_stop are different
 end
 
-function set_current_stack_plane(controller, poc_val, plane_position, plane_num, plane_order, func)
+function set_current_stack_plane(controller, poc_val, plane_position, plane_num, plane_order, func, drives)
     % Update pockel value for the next plane
     controller.pockels.on_value = poc_val(plane_num);            
 
-    % Set imaging plane (aol offset or motor mvt), send new drives
-    func(round(plane_position(plane_num)), plane_num == plane_order(1)); % first plane create the dataholder and stop any bkg mc
+    % Set imaging plane (aol offset or motor mvt), send new or precalculated drives
+    if isempty(drives)
+        func(round(plane_position(plane_num)), plane_num == plane_order(1)); % first plane create the dataholder and stop any bkg mc
+    else
+        func(round(plane_position(plane_num)), plane_num == plane_order(1), drives);
+    end
 end
 
 function print_message(controller, dynamic_mode, status, global_counter, total_counter, total_frames, plane_position, poc_val, plane_num,r, elapsed, UItable_lines)
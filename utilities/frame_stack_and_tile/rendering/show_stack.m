@@ -6,16 +6,20 @@
 %   you require smoothing, use show_vaa3d_3D_timelapse() instead
 % -------------------------------------------------------------------------
 % Syntax: 
-%   show_stack(data, viewer, vaa3D_folder)
+%   show_stack(data, viewer, vaa3D_folder, display_level)
 %
 % -------------------------------------------------------------------------
 % Inputs: 
 %   data(STR Path OR [X * Y * C] OR [X * Y * Z_or_T * C] OR 
-%        [X * Y * Z * T * C] FLOAT):
+%        [X * Y * Z * T * C] FLOAT OR StackStore):
 %                                   - If STR Path, it must be a path to a
 %                                   datatype that can be loaded by
 %                                   load_stack. Mostly tif, v3draw or avi
 %                                   files.
+%                                   - If StackStore, the mean stack is
+%                                   displayed. With the 'matlab' viewer,
+%                                   planes are only read from disk when
+%                                   they are first displayed.
 %                                   - If you prove a matrix, it will be
 %                                   display with the appropriate rendering
 %                                   options. 3D timelapses need vaa3d for
@@ -30,12 +34,23 @@
 %                                   
 %   viewer(STR) - Required if viewer == 'vaa3d'
 %                                   The path to the vaa3d excutable
+%
+%   display_level(INT or STR) - Optional - default is 'auto'
+%                                   Only for the 'matlab' viewer. Planes
+%                                   are displayed 2^display_level times
+%                                   smaller (2x2 box filter, see
+%                                   FramePyramid). 'auto' picks the level
+%                                   that matches the screen size. Use 0
+%                                   for full resolution.
 % -------------------------------------------------------------------------
 % Outputs:
 %	data([X_res * Y_res * Z_res * timepoints * channels]) single array 
 %                                   The data as formated by the function.
 %                                   singletons are removed. This is only
 %                                   useful if you passed a path initially.
+%                                   This is always the full resolution
+%                                   data. A StackStore input is returned
+%                                   as is with the 'matlab' viewer.
 % -------------------------------------------------------------------------
 % Extra Notes:
 % -------------------------------------------------------------------------
@@ -66,11 +81,11 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Partial Revision Date:
-%   14-06-2019
+%   18-10-2026
 %
-% See also: load_stack, show_vaa3d_3D_timelapse
+% See also: load_stack, show_vaa3d_3D_timelapse, FramePyramid, StackStore
 
-function data = show_stack(data, viewer, vaa3D_folder)
+function data = show_stack(data, viewer, vaa3D_folder, display_level)
     %% Adjust inputs
     if nargin < 2 || isempty(viewer)
         viewer = 'matlab';
@@ -83,9 +98,19 @@ function data = show_stack(data, viewer, vaa3D_folder)
         f = folder_params(1);
         vaa3D_folder = f.vaa3D_folder;
     end
+    if nargin < 4 || isempty(display_level)
+        display_level = 'auto';
+    end
     
     %% If you provide a path, load the data before displaying it
-    if (isstr(data) || isstring(data)) && isfile(data) 
+    store = []; % StackStore read plane by plane
+    if isa(data, 'StackStore') && strcmp(viewer, 'matlab')
+        store = data;
+        name = store.folder;
+    elseif isa(data, 'StackStore')
+        data = data.read_mean();
+        name = [pwd '/temp.v3draw']; 
+    elseif (isstr(data) || isstring(data)) && isfile(data) 
         name = char(data);
         data = load_stack(name); 
     else % if stack is a numerical matrix 
@@ -93,19 +118,23 @@ function data = show_stack(data, viewer, vaa3D_folder)
     end
     
     %% Detect data type
-    data = squeeze(data); 
-    if ndims(data) == 5 || (ndims(data) == 4 && size(data, 4) > 3)
-        %% Necessarily X * Y * Z * T * C. C can be 1
-        % Data will go through a temporary vaa3d file
-        type = '3d_timelapse';
-        viewer = 'vaa3d';
-    elseif ndims(data) == 4 || (ndims(data) == 3 && size(data, 3) > 3) || contains(name, 'Stack')
-        %% Necessarily X * Y * Z_or_T * C. C can be 1
-        type = '3d_stack_or_2d_timelapse';
+    if ~isempty(store)
+        type = '3d_stack_or_2d_timelapse'; % read plane by plane in the matlab viewer
     else
-        %% Necessarily X * Y * C. C can be 1
-        type = 'image';
-        data = reshape(data, size(data, 1), size(data, 2), 1, size(data, 3));
+        data = squeeze(data); 
+        if ndims(data) == 5 || (ndims(data) == 4 && size(data, 4) > 3)
+            %% Necessarily X * Y * Z * T * C. C can be 1
+            % Data will go through a temporary vaa3d file
+            type = '3d_timelapse';
+            viewer = 'vaa3d';
+        elseif ndims(data) == 4 || (ndims(data) == 3 && size(data, 3) > 3) || contains(name, 'Stack')
+            %% Necessarily X * Y * Z_or_T * C. C can be 1
+            type = '3d_stack_or_2d_timelapse';
+        else
+            %% Necessarily X * Y * C. C can be 1
+            type = 'image';
+            data = reshape(data, size(data, 1), size(data, 2), 1, size(data, 3));
+        end
     end
     
     %% Load data for each viewer type
@@ -127,32 +156,53 @@ function data = show_stack(data, viewer, vaa3D_folder)
             Stack_Viewer(data);
             
         case 'matlab'
-            num_planes = size(data,3);
-            num_channels = size(data,4);
+            if isempty(store)
+                data_size = size(data);
+            else
+                data_size = [store.frame_size, store.num_planes, store.num_channels];
+            end
+            data_size(end+1:4) = 1;
+            num_planes = data_size(3);
+            num_channels = data_size(4);
             
             if num_channels > 3
                 error_box('only up to 3 channels are supported')
-            elseif num_channels == 3 && ~any(reshape(data(:,:,:,3),[],1))
+            elseif isempty(store) && num_channels == 3 && ~any(reshape(data(:,:,:,3),[],1))
                 num_channels = 2;
             end
+            
+            %% Downsample all planes at once for display. data is not modified
+            if strcmp(display_level, 'auto')
+                screen_size = get(0, 'ScreenSize');
+                display_level = FramePyramid.get_window_level(data_size, [screen_size(4), screen_size(3) / num_channels]);
+            end
+            if ~isempty(store) % planes are read and downsampled when first displayed
+                preview = NaN([ceil(store.frame_size / 2^display_level), num_planes, num_channels], 'single');
+                preview(:,:,1,:) = FramePyramid.downsample(store.read_mean(1, 1:num_channels), display_level);
+                loaded = [true, false(1, num_planes - 1)];
+            elseif display_level
+                preview = FramePyramid.downsample(data(:,:,:,1:num_channels), display_level);
+            else
+                preview = data;
+            end
 
             %% Create one subplot per channel
             f = figure(1011); hold on;
             cla();hold on
             f.Name = 'Close figure to continue function'; hold on
             subplot(1,num_channels,1); 
-            im1 = imagesc(data(:,:,1,1)); hold on;
+            im1 = imagesc(preview(:,:,1,1)); hold on;
             colormap('gray'); axis image; hold on;
             t1 = title(sprintf('Channel 1 ; plane %d',1));hold on;
             if num_channels > 1
                 subplot(1,num_channels,2);hold on; 
-                im2 = imagesc(data(:,:,1,2)); hold on;        
+                im2 = imagesc(preview(:,:,1,2)); hold on;        
                 colormap('gray'); axis image; hold on;
                 set(gca,'YDir','reverse');
                 t2 = title(sprintf('Channel 2 ; plane %d',1));hold on;
                 if num_channels > 2
                     subplot(1,num_channels,3);hold on; 
-                    im3 = imagesc(data(:,:,1,3)); hold on;        
+                    im3 = imagesc(preview(:,:,1,3)); hold on;        
                     colormap('gray'); axis image; hold on;
                     t3 = title(sprintf('Channel 3 ; plane %d',1));hold on;
                 end
@@ -162,13 +212,17 @@ function data = show_stack(data, viewer, vaa3D_folder)
             while isvalid(f)
                 for plane_num = 1:num_planes
                     if isvalid(f)
-                        im1.CData = data(:,:,plane_num,1); hold on;
+                        if ~isempty(store) && ~loaded(plane_num)
+                            preview(:,:,plane_num,:) = FramePyramid.downsample(store.read_mean(plane_num, 1:num_channels), display_level);
+                            loaded(plane_num) = true;
+                        end
+                        im1.CData = preview(:,:,plane_num,1); hold on;
                         t1.String = sprintf('Channel 1 ; plane %d',plane_num);hold on;
                         if num_channels > 1
-                            im2.CData = data(:,:,plane_num,2); hold on;
+                            im2.CData = preview(:,:,plane_num,2); hold on;
                             t2.String = sprintf('Channel 2 ; plane %d',plane_num);hold on;
                             if num_channels > 2
-                                im3.CData = data(:,:,plane_num,3); hold on;
+                                im3.CData = preview(:,:,plane_num,3); hold on;
                                 t3.String = sprintf('Channel 3 ; plane %d',plane_num);hold on;
                             end
                         end
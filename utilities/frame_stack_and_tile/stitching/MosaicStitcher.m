@@ -0,0 +1,492 @@
+%% Streaming assembly of tiles into a pyramidal mosaic on disk
+%   Tiles are added one at a time, as soon as they are acquired, at the
+%   stage position where they were recorded. The position can be refined
+%   by phase correlation with the overlapping part of the mosaic. Tiles are
+%   blended with a feathered weight, and the downsampled levels of the
+%   mosaic are updated for the area covered by each new tile, so that the
+%   full mosaic is available as soon as the last tile is added.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = MosaicStitcher(folder, tile_size, pixel_size_um, xy_start_um,
+%                         xy_stop_um, num_planes, num_channels)
+%   this = MosaicStitcher(folder)
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   folder (STR)
+%       The folder of the mosaic files. It is created if needed. If it is
+%       the only input, an existing mosaic is opened.
+%
+%   tile_size ([1 x 2] INT)
+%       [X, Y] size of each tile, in pixels.
+%
+%   pixel_size_um ([1 x 2] or FLOAT)
+%       Pixel size, in um, along X and Y. Use a negative value if the stage
+%       and image axes are opposite.
+%
+%   xy_start_um ([1 x 2] FLOAT)
+%       Smallest X and Y stage positions of the tiles, typically
+%       StackAndTiles.tile_xyz_start(1:2).
+%
+%   xy_stop_um ([1 x 2] FLOAT)
+%       Largest X and Y stage positions of the tiles, typically
+%       StackAndTiles.tile_xyz_stop(1:2).
+%
+%   num_planes (INT) - Optional - default is 1
+%       The number of planes of each tile.
+%
+%   num_channels (INT) - Optional - default is 2
+%       The number of channels of each tile.
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (MosaicStitcher object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Create a mosaic covering the Controller tiling range (static)
+%   this = MosaicStitcher.from_controller(controller, folder, num_planes,
+%                                         num_channels)
+%
+% * Blend a new tile in the mosaic
+%   offset = MosaicStitcher.add_tile(tile, position_um)
+%
+% * Read a region of the mosaic at any level
+%   img = MosaicStitcher.read(level, x_range, y_range, planes, channels)
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * The stage position of a tile is the position of its center. The
+%   mosaic covers the tiling range plus half a tile on each side.
+%
+% * Level 0 is stored as the weighted sum of tiles and the sum of weights,
+%   so that tiles can be added in any order. Levels 1 to n_levels are 2x2
+%   box-filtered copies (see FramePyramid), updated for the area of each
+%   new tile. Uncovered pixels are 0.
+%
+% * The blending weight of a tile decreases linearly from its center to
+%   its edges, so seams between overlapping tiles are smooth.
+%
+% * If refine is true, the shift between the new tile and the current
+%   mosaic is measured by phase correlation on the overlap (mean of all
+%   planes of refine_channel). The shift is applied if it is smaller than
+%   max_shift pixels and if the correlation peak is above min_peak.
+%
+% * All files are memory-mapped, and each tile only reads and writes its
+%   own area, so memory use only depends on the tile size. FFTs and array
+%   operations use Matlab's multithreaded routines.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Stitch tiles as they are acquired
+%   mosaic = MosaicStitcher.from_controller(c, 'D:/mosaic_01', 1, 2);
+%   for pos = positions' % one tile position per row
+%       c.xyz_stage.move_abs(pos');
+%       mosaic.add_tile(c.single_record(), c.xyz_stage.get_position());
+%   end
+%   imagesc(mosaic.read(mosaic.n_levels, [], [], 1, 1));
+%
+% * Stitch the mean stack of each tile, at the end of each stack
+%   mosaic = MosaicStitcher.from_controller(c, 'D:/mosaic_01', 20, 2);
+%   for pos = positions'
+%       c.xyz_stage.move_abs(pos');
+%       aol_stack(c, '', 'num_planes', 20, 'mosaic', mosaic);
+%   end
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: StackAndTiles, XyzStage, FramePyramid, StackStore
+
+classdef MosaicStitcher < handle
+    properties
+        folder          = ''        ; % Folder containing mosaic.mat and the level files
+        tile_size       = [0, 0]    ; % [X, Y] size of each tile, in pixels
+        pixel_size_um   = [1, 1]    ; % [X, Y] pixel size, in um. Negative if stage and image axes are opposite
+        origin_um       = [0, 0]    ; % Stage position of the center of a tile at pixel offset [0, 0]
+        mosaic_size     = [0, 0]    ; % [X, Y] size of the full resolution mosaic
+        num_planes      = 1         ; % Number of planes
+        num_channels    = 2         ; % Number of channels
+        n_levels        = 0         ; % Number of downsampled levels
+        refine          = true      ; % If true, refine tile positions by phase correlation
+        refine_channel  = 1         ; % Channel used for refinement
+        max_shift       = 20        ; % Largest accepted refinement, in pixels
+        min_peak        = 0.05      ; % Smallest accepted phase correlation peak
+        min_overlap     = 0.05      ; % Smallest overlap, as a fraction of the tile, for refinement
+        offsets         = zeros(0, 2); % [N x 2] pixel offset of each added tile
+    end
+
+    properties (Transient, Access = private)
+        maps            = {}; % memmapfiles of the level 0 weighted sum, the level 0 weights, then levels 1 to n_levels
+        map_sizes       = []; % [N_maps x 4] size of each map
+    end
+
+    methods
+        function this = MosaicStitcher(folder, tile_size, pixel_size_um, xy_start_um, xy_stop_um, num_planes, num_channels)
+            %% MosaicStitcher Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = MosaicStitcher(folder, tile_size, pixel_size_um,
+            %                         xy_start_um, xy_stop_um,
+            %                         num_planes, num_channels)
+            %   this = MosaicStitcher(folder)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   See class description
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (MosaicStitcher object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            this.folder = char(folder);
+
+            %% Open an existing mosaic
+            if nargin == 1
+                if ~isfile(fullfile(this.folder, 'mosaic.mat'))
+                    error(['No mosaic found in ', this.folder])
+                end
+                description = load(fullfile(this.folder, 'mosaic.mat'));
+                for field = fieldnames(description)'
+                    this.(field{1}) = description.(field{1});
+                end
+                this.map_files(false);
+                return
+            end
+
+            %% Create a new mosaic
+            if nargin >= 6 && ~isempty(num_planes)
+                this.num_planes = num_planes;
+            end
+            if nargin >= 7 && ~isempty(num_channels)
+                this.num_channels = num_channels;
+            end
+            if isfile(fullfile(this.folder, 'mosaic.mat'))
+                error([this.folder, ' already contains a mosaic. Use MosaicStitcher(folder) to open it, or choose another folder'])
+            elseif ~isfolder(this.folder)
+                mkdir(this.folder);
+            end
+            this.tile_size      = tile_size(1:2);
+            this.pixel_size_um  = pixel_size_um .* [1, 1];
+            xy_start_um         = min(xy_start_um(1:2), xy_stop_um(1:2));
+            xy_stop_um          = max(xy_start_um(1:2), xy_stop_um(1:2));
+            span_px             = ceil((xy_stop_um - xy_start_um) ./ abs(this.pixel_size_um));
+            this.origin_um      = xy_start_um;
+            this.origin_um(this.pixel_size_um < 0) = xy_stop_um(this.pixel_size_um < 0);
+            this.mosaic_size    = span_px + this.tile_size;
+            this.n_levels       = FramePyramid.default_levels(this.mosaic_size);
+            this.map_files(true);
+            this.save_description();
+        end
+
+        function offset = add_tile(this, tile, position_um)
+            %% Blend a new tile in the mosaic
+            % -------------------------------------------------------------
+            % Syntax:
+            %   offset = MosaicStitcher.add_tile(tile, position_um)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   tile ([X x Y x C] or [X x Y x P x C] NUMERIC)
+            %       The tile, as returned by Controller.single_record, or
+            %       the mean stack of a tile
+            %
+            %   position_um ([1 x 2] or [1 x 3] FLOAT)
+            %       The stage position of the tile, as returned by
+            %       XyzStage.get_position(). Z is ignored
+            % -------------------------------------------------------------
+            % Outputs:
+            %   offset ([1 x 2] INT)
+            %       The pixel offset of the tile in the mosaic, after
+            %       refinement
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            tile    = reshape(single(tile), this.tile_size(1), this.tile_size(2), this.num_planes, this.num_channels);
+            tile(isnan(tile)) = 0;
+            offset  = round((position_um(1:2) - this.origin_um) ./ this.pixel_size_um);
+
+            %% Refine the position on the overlap with the current mosaic
+            if this.refine && ~isempty(this.offsets)
+                offset = offset - this.measure_shift(tile, offset);
+            end
+
+            %% Clip the tile to the mosaic
+            [src, dst] = this.clip(offset);
+            if isempty(src{1}) || isempty(src{2})
+                warning('Tile at [%.1f, %.1f] um is outside of the mosaic and was ignored', position_um(1), position_um(2));
+                return
+            end
+
+            %% Accumulate weighted tile and weights
+            w       = this.feather_weight();
+            w       = w(src{:});
+            all_planes = {1:this.num_planes, 1:this.num_channels};
+            this.set_block(1, [dst, all_planes], this.get_block(1, [dst, all_planes]) + tile(src{:}, :, :) .* w);
+            this.set_block(2, [dst, {1, 1}], this.get_block(2, [dst, {1, 1}]) + w);
+            this.offsets(end + 1, :) = offset;
+
+            %% Update the downsampled levels over the tile area
+            this.update_levels(dst);
+            this.save_description();
+        end
+
+        function img = read(this, level, x_range, y_range, planes, channels)
+            %% Read a region of the mosaic at any level
+            % -------------------------------------------------------------
+            % Syntax:
+            %   img = MosaicStitcher.read(level, x_range, y_range, planes,
+            %                             channels)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   level (INT) - Optional - default is 0
+            %       The level to read, between 0 (full resolution) and
+            %       n_levels
+            %
+            %   x_range, y_range ([1 x N] INT) - Optional - default is
+            %           the full level
+            %       Pixel indexes in the level
+            %
+            %   planes, channels ([1 x N] INT) - Optional - default is
+            %           all
+            % -------------------------------------------------------------
+            % Outputs:
+            %   img ([X x Y x P x C] SINGLE)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 2 || isempty(level)
+                level = 0;
+            end
+            level_size = ceil(this.mosaic_size / 2^level);
+            if nargin < 3 || isempty(x_range)
+                x_range = 1:level_size(1);
+            end
+            if nargin < 4 || isempty(y_range)
+                y_range = 1:level_size(2);
+            end
+            if nargin < 5 || isempty(planes)
+                planes = 1:this.num_planes;
+            end
+            if nargin < 6 || isempty(channels)
+                channels = 1:this.num_channels;
+            end
+            if level
+                img = this.get_block(2 + level, {x_range, y_range, planes, channels});
+            else
+                img = this.normalised({x_range, y_range}, planes, channels);
+            end
+        end
+    end
+
+    methods (Static, Access = private)
+        function idx = block_index(dims, ranges)
+            %% Linear indexes of a block of an N-D array
+            idx     = 1;
+            stride  = 1;
+            for d = 1:numel(ranges)
+                shape   = [ones(1, d - 1), numel(ranges{d}), 1];
+                idx     = idx + reshape(ranges{d} - 1, shape) * stride;
+                stride  = stride * dims(d);
+            end
+        end
+    end
+
+    methods (Static)
+        function this = from_controller(controller, folder, num_planes, num_channels)
+            %% Create a mosaic covering the Controller tiling range
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = MosaicStitcher.from_controller(controller, folder,
+            %                                         num_planes,
+            %                                         num_channels)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   controller (Controller object) - Optional - default is
+            %           main Controller
+            %       Tile size and pixel size come from the current
+            %       scan_params, the range from xyz_stage.tile_xyz_start
+            %       and tile_xyz_stop
+            %
+            %   folder, num_planes, num_channels
+            %       See class description
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (MosaicStitcher object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 1 || isempty(controller)
+                controller = get_existing_controller_name(true);
+            end
+            if nargin < 3
+                num_planes = [];
+            end
+            if nargin < 4
+                num_channels = [];
+            end
+            tile_size   = [controller.scan_params.mainscan_x_pixel_density, controller.scan_params.num_drives];
+            pixel_size  = controller.aol_params.get_pixel_size(controller.scan_params.acceptance_angle, controller.scan_params.mainscan_x_pixel_density);
+            this        = MosaicStitcher(folder, tile_size, pixel_size, controller.xyz_stage.tile_xyz_start, controller.xyz_stage.tile_xyz_stop, num_planes, num_channels);
+        end
+    end
+
+    methods (Access = private)
+        function map_files(this, create)
+            %% Memory-map level files, creating them if required
+            sizes = [[this.mosaic_size, this.num_planes, this.num_channels];...
+                     [this.mosaic_size, 1, 1]];
+            names = {'level_0_sum.bin', 'level_0_weight.bin'};
+            for level = 1:this.n_levels
+                sizes(end + 1, :) = [ceil(this.mosaic_size / 2^level), this.num_planes, this.num_channels];
+                names{end + 1}    = sprintf('level_%d.bin', level);
+            end
+            this.maps = cell(1, numel(names));
+            for idx = 1:numel(names)
+                name = fullfile(this.folder, names{idx});
+                if create % zero filled file of the right size
+                    fid = fopen(name, 'w');
+                    if fid < 0
+                        error(['Unable to create ', name])
+                    end
+                    fseek(fid, 4 * prod(sizes(idx, :)) - 1, 'bof');
+                    fwrite(fid, 0, 'uint8');
+                    fclose(fid);
+                end
+                this.maps{idx} = memmapfile(name, 'Format', 'single', 'Writable', true);
+            end
+            this.map_sizes = sizes;
+        end
+
+        function img = normalised(this, region, planes, channels)
+            %% Level 0 blended image over a region. 0 where no tile
+            weights = this.get_block(2, [region, {1, 1}]);
+            img     = this.get_block(1, [region, {planes, channels}]) ./ weights;
+            img(isnan(img)) = 0;
+        end
+
+        function w = feather_weight(this)
+            %% Weight decreasing linearly from the tile center to its edges
+            wx  = min(1:this.tile_size(1), this.tile_size(1):-1:1)';
+            wy  = min(1:this.tile_size(2), this.tile_size(2):-1:1);
+            w   = single(wx .* wy);
+            w   = w / max(w(:));
+        end
+
+        function [src, dst] = clip(this, offset)
+            %% Tile and mosaic indexes of the part of the tile inside the mosaic
+            [src, dst] = deal(cell(1, 2));
+            for ax = 1:2
+                first   = max(1, 1 - offset(ax));
+                last    = min(this.tile_size(ax), this.mosaic_size(ax) - offset(ax));
+                src{ax} = first:last;
+                dst{ax} = src{ax} + offset(ax);
+            end
+        end
+
+        function shift = measure_shift(this, tile, offset)
+            %% Phase correlation between the tile and the current mosaic
+            shift       = [0, 0];
+            [src, dst]  = this.clip(offset);
+            if isempty(src{1}) || isempty(src{2})
+                return
+            end
+            mask        = this.get_block(2, [dst, {1, 1}]) > 0;
+            if nnz(mask) < this.min_overlap * prod(this.tile_size)
+                return
+            end
+            current     = mean(this.normalised(dst, 1:this.num_planes, this.refine_channel), 3);
+            new         = mean(tile(src{:}, :, this.refine_channel), 3);
+            current     = (current - mean(current(mask))) .* mask;
+            new         = (new - mean(new(mask))) .* mask;
+            spectrum    = fft2(new) .* conj(fft2(current));
+            correlation = ifft2(spectrum ./ max(abs(spectrum), eps('single')), 'symmetric');
+            [peak, idx] = max(correlation(:));
+            [sx, sy]    = ind2sub(size(correlation), idx);
+            candidate   = [sx, sy] - 1;
+            period      = size(correlation); % smaller than the tile if it was clipped
+            wrap        = candidate > period / 2;
+            candidate(wrap) = candidate(wrap) - period(wrap);
+            if peak >= this.min_peak && all(abs(candidate) <= this.max_shift)
+                shift = candidate;
+            end
+        end
+
+        function update_levels(this, region)
+            %% Recompute the downsampled levels over a level 0 region
+            for level = 1:this.n_levels
+                parent_size = ceil(this.mosaic_size / 2^(level - 1));
+                parent_region = cell(1, 2);
+                for ax = 1:2 % level pixels covering the region, and their 2x2 parent pixels
+                    region{ax}          = ceil(region{ax}(1) / 2):ceil(region{ax}(end) / 2);
+                    parent_region{ax}   = 2 * region{ax}(1) - 1:min(2 * region{ax}(end), parent_size(ax));
+                end
+                parent = this.read(level - 1, parent_region{:});
+                this.set_block(2 + level, [region, {1:this.num_planes, 1:this.num_channels}], FramePyramid.downsample(parent, 1));
+            end
+        end
+
+        function block = get_block(this, map_idx, ranges)
+            %% Read a [x, y, plane, channel] block. Only these values are read from disk
+            idx     = MosaicStitcher.block_index(this.map_sizes(map_idx, :), ranges);
+            block   = reshape(this.maps{map_idx}.Data(idx), size(idx));
+        end
+
+        function set_block(this, map_idx, ranges, block)
+            %% Write a [x, y, plane, channel] block
+            idx     = MosaicStitcher.block_index(this.map_sizes(map_idx, :), ranges);
+            this.maps{map_idx}.Data(idx(:)) = block(:);
+        end
+
+        function save_description(this)
+            %% Update mosaic.mat
+            description = struct('tile_size'    , this.tile_size    , 'pixel_size_um', this.pixel_size_um,...
+                                 'origin_um'    , this.origin_um    , 'mosaic_size'  , this.mosaic_size,...
+                                 'num_planes'   , this.num_planes   , 'num_channels' , this.num_channels,...
+                                 'n_levels'     , this.n_levels     , 'refine'       , this.refine,...
+                                 'refine_channel', this.refine_channel, 'max_shift'  , this.max_shift,...
+                                 'min_peak'     , this.min_peak     , 'min_overlap'  , this.min_overlap,...
+                                 'offsets'      , this.offsets);
+            save(fullfile(this.folder, 'mosaic.mat'), '-struct', 'description');
+        end
+    end
+end
@@ -7,7 +7,7 @@
 %                     reset_drives,  suggested_ROI, ref_channel, 
 %                     absolute_z_for_ref, MC_rate, non_default_resolution,
 %                     non_default_aa, non_default_dwelltime, 
-%                     non_default_pockel_voltages)
+%                     non_default_pockel_voltages, interactive)
 %
 % -------------------------------------------------------------------------
 % Inputs: 
@@ -76,6 +76,11 @@
 %                                   In V, the pockel value to use for both
 %                                   the full frame preview and the miniscan
 %                                   THR selection.
+%
+%   interactive(BOOL) - Optional - Default is true
+%                                   If false, ROI and thresholds are set
+%                                   without GUI (see prepare_MC_Ref), so
+%                                   the pipeline can run unattended.
 % -------------------------------------------------------------------------
 % Outputs:
 %   selection_status(BOOL):
@@ -116,7 +121,7 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   14-03-2019
+%   18-10-2026
 %
 % See also: preview_at_any_z, select_ROI, prepare_MC_miniscan,
 %   prepare_MC_Ref, select_MC_thr, start_tracking_mc_ROI, MC_off
@@ -125,7 +130,7 @@
 % TODO : check the stop MC function.
 % Add background MC plot
 
-function [selection_status, tracking_status] = MC_selection_pipeline(controller, preview, image_with_mc, finalise_mc, reset_drives, suggested_ROI, ref_channel, absolute_z_for_ref, MC_rate, non_default_resolution, non_default_aa, non_default_dwelltime, non_default_pockel_voltages)
+function [selection_status, tracking_status] = MC_selection_pipeline(controller, preview, image_with_mc, finalise_mc, reset_drives, suggested_ROI, ref_channel, absolute_z_for_ref, MC_rate, non_default_resolution, non_default_aa, non_default_dwelltime, non_default_pockel_voltages, interactive)
     if nargin < 1 || isempty(controller)
         controller = get_existing_controller_name(true);
     end
@@ -165,9 +170,12 @@ function [selection_status, tracking_status] = MC_selection_pipeline(controller,
     if nargin < 13 || isempty(non_default_pockel_voltages)
         non_default_pockel_voltages = controller.pockels.on_value;
     end
+    if nargin < 14 || isempty(interactive)
+        interactive = true;
+    end
 
     %% In a first time, you must select the ROI and the threshold
-    [selection_status, suggested_ROI, suggested_thr, absolute_z_for_ref, ~] = prepare_MC_Ref(controller, absolute_z_for_ref, ref_channel, suggested_ROI, non_default_resolution, non_default_aa, non_default_dwelltime, non_default_pockel_voltages);
+    [selection_status, suggested_ROI, suggested_thr, absolute_z_for_ref, ~] = prepare_MC_Ref(controller, absolute_z_for_ref, ref_channel, suggested_ROI, non_default_resolution, non_default_aa, non_default_dwelltime, non_default_pockel_voltages, interactive);
     if ~selection_status || any(isnan(suggested_ROI(1))) || any(isnan(suggested_thr)) % if cancelled, abort
         fprintf('MC selection or ROI threshold selection aborted\n')
         return
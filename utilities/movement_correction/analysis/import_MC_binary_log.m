@@ -0,0 +1,181 @@
+%% Load binary MC logs (.mcbin) and format them in a mc_log struct
+%   Binary equivalent of import_MC_log + save_MC_log. All the files are
+%   read at once and sorted per trial, using the trial index stored in
+%   each record.
+%
+% -------------------------------------------------------------------------
+% Syntax:
+%   [mc_log, flags] = import_MC_binary_log(files, rendering, remove_duplicates)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   files(STR Path or CELL ARRAY of STR or DIR STRUCT)
+%                       The .mcbin file(s) to load
+%
+%   rendering(BOOL) - Optional - default is false:
+%                       If true, the MC log of each trial is displayed
+%
+%   remove_duplicates(BOOL) - Optional - default is true:
+%                       If true, consecutive records with identical values
+%                       are removed (the registers are usually sampled
+%                       faster than they are updated). This is what
+%                       import_MC_log does on text logs.
+% -------------------------------------------------------------------------
+% Outputs:
+%   mc_log             (STRUCT of [1 X M] CELL ARRAYS)
+%                       struct object containing the MC log, one cell per
+%                       trial, sorted by trial index. Same fields as
+%                       save_MC_log : X_correction, Y_correction,
+%                       Z_correction (NaN if ZMC was off), X_difference,
+%                       Y_difference, Z_difference (NaN if ZMC was off),
+%                       and Time, in seconds since the first record.
+%                       Acquisition_start is the acquisition start of
+%                       each trial, on the same time base as Time (NaN if
+%                       the log has no marker).
+%
+%   flags              ([1 X M] CELL ARRAY of [1 x N] UINT16)
+%                       The flags of each record. See Extra Notes.
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * File layout (little-endian) :
+%       - a 16 bytes header : 'SLMC', UINT32 version (1), UINT32 record
+%         size in bytes (24), UINT32 reserved
+%       - N records of 24 bytes :
+%           INT64  timestamp, in ns since 1970-01-01 (local time)
+%           INT16  x_correction_X10,  y_correction_X10, z_correction_X100,
+%                  x_diff_X100, y_diff_X100, z_diff_X100 (raw registers)
+%           UINT16 flags : 1 = ZMC enabled, 2 = lostx, 4 = lostz,
+%                          8 = MC was correcting, 16 = acquisition start
+%                          marker (values are 0)
+%           UINT16 trial index (repeat number of timed_image, 0 if none)
+%
+% * Files are written by MCViewer. A partially written last record (e.g.
+%   after a crash) is ignored. Marker records are not returned in the
+%   MC fields.
+% -------------------------------------------------------------------------
+% Examples:
+% * Load all the binary logs of a folder
+%   mc_log = import_MC_binary_log(dir('*MC_log_*.mcbin'));
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: MCViewer, save_MC_log, import_MC_log, load_mc_log
+
+
+function [mc_log, flags] = import_MC_binary_log(files, rendering, remove_duplicates)
+    if nargin < 2 || isempty(rendering)
+        rendering = false;
+    end
+    if nargin < 3 || isempty(remove_duplicates)
+        remove_duplicates = true;
+    end
+
+    %% List files
+    if isstruct(files)
+        files = arrayfun(@(f) [f.folder, '/', f.name], files, 'UniformOutput', false);
+    elseif ischar(files)
+        files = {files};
+    end
+
+    %% Read all records as raw bytes, one column per record
+    record_bytes = 24;
+    records = cell(1, numel(files));
+    for f = 1:numel(files)
+        fid = fopen(files{f}, 'r');
+        if fid < 0
+            error(['Unable to open MC log ', files{f}])
+        end
+        bytes = fread(fid, Inf, '*uint8');
+        fclose(fid);
+        if numel(bytes) < 16 || ~strcmp(char(bytes(1:4)'), 'SLMC')
+            error([files{f}, ' is not a binary MC log'])
+        elseif typecast(bytes(5:8), 'uint32') ~= 1 || typecast(bytes(9:12), 'uint32') ~= record_bytes
+            error(['Unsupported MC log version in ', files{f}])
+        end
+        n_records = floor((numel(bytes) - 16) / record_bytes);
+        records{f} = reshape(bytes(17:16 + n_records * record_bytes), record_bytes, n_records);
+    end
+    records = [records{:}];
+
+    %% Decode fields
+    t_ns    = typecast(reshape(records(1:8, :), 1, []), 'int64');
+    raw     = reshape(typecast(reshape(records(9:20, :), 1, []), 'int16'), 6, []);
+    flag    = typecast(reshape(records(21:22, :), 1, []), 'uint16');
+    trial   = typecast(reshape(records(23:24, :), 1, []), 'uint16');
+
+    %% Sort by trial then time, and remove consecutive duplicates within a trial
+    if isempty(t_ns)
+        t0 = int64(0);
+    else
+        t0 = min(t_ns);
+    end
+    time            = double(t_ns - t0) / 1e9; % in seconds
+
+    %% Acquisition start markers
+    marker          = bitand(flag, 16) > 0;
+    [marker_time, marker_trial] = deal(time(marker), trial(marker));
+    [time, raw, flag, trial] = deal(time(~marker), raw(:, ~marker), flag(~marker), trial(~marker));
+    [~, order]      = sortrows([double(trial)', time']);
+    [time, raw, flag, trial] = deal(time(order), raw(:, order), flag(order), trial(order));
+    if remove_duplicates && ~isempty(time)
+        keep = [true, any(diff(raw, 1, 2), 1) | diff(trial) ~= 0];
+        [time, raw, flag, trial] = deal(time(keep), raw(:, keep), flag(keep), trial(keep));
+    end
+
+    %% Rescale, and hide Z when ZMC was off
+    values          = double(raw) ./ [10; 10; 100; 100; 100; 100];
+    values([3, 6], ~bitand(flag, 1)) = NaN;
+
+    %% Split per trial
+    [trials, ~, group] = unique(trial);
+    counts          = accumarray(group(:), 1)';
+    per_trial       = mat2cell([values; time], 7, counts);
+    flags           = mat2cell(flag, 1, counts);
+    fields          = {'X_correction', 'Y_correction', 'Z_correction', 'X_difference', 'Y_difference', 'Z_difference', 'Time'};
+    mc_log          = {};
+    for field = 1:numel(fields)
+        mc_log.(fields{field}) = cellfun(@(v) v(field, :), per_trial, 'UniformOutput', false);
+    end
+    mc_log.Acquisition_start = num2cell(NaN(1, numel(trials)));
+    for el = 1:numel(trials)
+        start = min(marker_time(marker_trial == trials(el)));
+        if ~isempty(start)
+            mc_log.Acquisition_start{el} = start;
+        end
+    end
+
+    if rendering
+        figure(1052);clf();whitebg('w')
+        colors = 'rbkrbk';
+        for field = 1:6
+            subplot(2, 3, field); hold on;
+            cellfun(@(t, v) plot(t, v, colors(field)), mc_log.Time, mc_log.(fields{field}));
+            title(strrep(fields{field}, '_', ' '));
+        end
+    end
+end
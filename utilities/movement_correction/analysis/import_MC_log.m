@@ -41,17 +41,10 @@ function [X_corr, Y_corr, Z_corr, X_diff, Y_diff, Z_diff, MCTime, initial_time]
 
         %% Reformat data, remove duplicated values.
         % Duplicated values happens if you read the capi too fast
+        % Lines with NaN (no ZMC) are never considered as duplicates
         data = cell2mat(data(1:9));
-        dataArray_no_duplicates = nan(size(data));
-        counter = 1;
-        dataArray_no_duplicates(1,:) = data(1,:);
-        for line = 2:size(data,1)
-            if ~all(dataArray_no_duplicates(counter,4:end) == data(line,4:end))
-                counter = counter + 1;
-                dataArray_no_duplicates(counter,:) = data(line,:);                
-            end
-        end
-        dataArray_no_duplicates = dataArray_no_duplicates(1:counter,:);
+        keep = [true; any(diff(data(:,4:end), 1, 1) ~= 0, 2)];
+        dataArray_no_duplicates = data(keep,:);
 
         %% Get the timescale right
         ms = mod(dataArray_no_duplicates(:,3),1);
@@ -8,8 +8,9 @@
 % -------------------------------------------------------------------------
 % Inputs:
 %   source(STR Path or STRUCT):
-%                                   The path to a given data folder, or a
-%                                   mc_log object
+%                                   The path to a given data folder, a
+%                                   binary MC log (.mcbin), or a mc_log
+%                                   object
 %
 %   repeats(1 * N INT): - Optional - Default is all trials:
 %                                   If provided, only a subset of the
@@ -35,6 +36,8 @@
 %                                   - Y_diff
 %                                   - Z_diff 
 %                                   - timescale
+%                                   - Acquisition_start (binary logs
+%                                   only, shifted with timescale)
 %                                   to contatenate axes :
 %                                   log = structfun(@(x) [x{:}], log,...
 %                                           'UniformOutput', false)
@@ -96,7 +99,7 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   03-07-2019
+%   18-10-2026
 %
 % See also: get_recordings_info, load_quick_preview, load_generic_scan,
 % save_MC_log 
@@ -123,6 +126,10 @@ function [mc_log, concatenated_MC_displacement_um, concatenated_Time, mc_pixel_s
         %% Passing file path
             mc_log = save_MC_log(1, false, false);
             n_lines = 2;
+    elseif ischar(source) && endsWith(source, '.mcbin') && exist(source, 'file')
+        %% Passing a binary log path
+            mc_log = import_MC_binary_log(source, false);
+            n_lines = 2;
     elseif ~isstruct(source)
         if ~strcmp(source(end-10:end),'\mc_log.mat')
             source = [source, '\mc_log.mat'];
@@ -187,9 +194,7 @@ function [mc_log, concatenated_MC_displacement_um, concatenated_Time, mc_pixel_s
             starts = cellfun(@(t) t(1), mc_log.Time);
             stops = cellfun(@(t) t(end), mc_log.Time);
             inter_trial = starts(2:end) - stops(1:end-1);
-            for trial = 2:numel(mc_log.Time)
-                mc_log.Time{trial} = mc_log.Time{trial} - sum(inter_trial(1:trial-1));
-            end
+            mc_log = shift_time(mc_log, -[0, cumsum(inter_trial)]);
             
 %             starts = cellfun(@(t) t(1), mc_log.Time);
 %             stops = cellfun(@(t) t(2), mc_log.Time);
@@ -226,7 +231,7 @@ function [mc_log, concatenated_MC_displacement_um, concatenated_Time, mc_pixel_s
         else 
             offset = 0;
         end
-        mc_log.Time = cellfun(@(x) x + offset, mc_log.Time, 'UniformOutput', false);
+        mc_log = shift_time(mc_log, offset);
         
         %% Filter for trials
         if ~isempty(repeats) && any(repeats)
@@ -265,7 +270,7 @@ function [mc_log, concatenated_MC_displacement_um, concatenated_Time, mc_pixel_s
 %         timescale = interpolate_to(timescale, 10000);
         
         if fix_log_start_issue || timescale(1) < 0 % Not sure that's the right flag
-            mc_log.Time = cellfun(@(x) x - timescale(1) , mc_log.Time, 'UniformOutput', false);
+            mc_log = shift_time(mc_log, -timescale(1));
             timescale = timescale - timescale(1);            
         end
         
@@ -349,6 +354,15 @@ function [mc_log, concatenated_MC_displacement_um, concatenated_Time, mc_pixel_s
     end
 end
 
+function mc_log = shift_time(mc_log, offset)
+    %% Shift Time (and Acquisition_start if any) by one offset, or one per trial
+    offset = num2cell(offset .* ones(1, numel(mc_log.Time)));
+    mc_log.Time = cellfun(@(t, o) t + o, mc_log.Time, offset, 'UniformOutput', false);
+    if isfield(mc_log, 'Acquisition_start')
+        mc_log.Acquisition_start = cellfun(@(t, o) t + o, mc_log.Acquisition_start, offset, 'UniformOutput', false);
+    end
+end
+
  function [concatenated_MC_displacement_um, concatenated_Time, mc_pixel_size] = get_scaled_output(X_corr, Y_corr, Z_corr, timescale, source, MC_status)
     %% Check if we can get the information
     if ischar(source)
@@ -0,0 +1,238 @@
+%% Correct recorded frames for the residual motion measured by the MC loop
+%   Interpolate the MC residual displacement (X_difference, Y_difference)
+%   at the time of each line, and apply the corresponding sub-pixel shift
+%   to the recorded frames. Frames are processed in chunks, so trials
+%   larger than memory can be read from and written to memory-mapped
+%   files in one pass.
+%
+% -------------------------------------------------------------------------
+% Syntax:
+%   [registered, shifts] = register_from_mc_log(frames, mc_log, trial,
+%                                               line_times, scaling, output)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   frames([X x Y x T] NUMERIC or MEMMAPFILE):
+%                                   The recorded frames, X voxels per line,
+%                                   Y lines per frame. With a memmapfile,
+%                                   Data must have a single [X Y] field,
+%                                   one element per frame (see Examples).
+%
+%   mc_log(STRUCT):
+%                                   The MC log, as returned by
+%                                   import_MC_binary_log or load_mc_log.
+%                                   Time, Acquisition_start, X_difference
+%                                   and Y_difference are used.
+%
+%   trial(INT) - Optional - Default is 1:
+%                                   The trial to use, if mc_log fields are
+%                                   cell arrays (one cell per trial).
+%
+%   line_times([Y x T] or [1 x Y*T] or [Y x 1] FLOAT):
+%                                   Time of each line, in s since the start
+%                                   of the trial, typically t_line from
+%                                   ScanParams.get_fps(). A [Y x 1] input
+%                                   is one cycle, repeated with a period of
+%                                   line_times(end) + line_times(2) -
+%                                   line_times(1).
+%
+%   scaling(FLOAT or [1 x 2] FLOAT) - Optional - Default is 1:
+%                                   Image pixels per MC pixel, in X and Y.
+%                                   Use a negative value to flip an axis if
+%                                   the MC and image axes are opposite.
+%
+%   output(STR) - Optional - Default is '':
+%                                   If provided, registered frames are
+%                                   written in this file (raw SINGLE, X*Y
+%                                   values per frame) instead of memory.
+% -------------------------------------------------------------------------
+% Outputs:
+%   registered([X x Y x T] SINGLE or MEMMAPFILE):
+%                                   The registered frames. Pixels sampled
+%                                   outside of the recorded frame are NaN.
+%                                   If output is set, a memmapfile of the
+%                                   output file, with one 'frame' field per
+%                                   frame.
+%
+%   shifts([Y x T x 2] DOUBLE):
+%                                   X and Y shifts applied to each line, in
+%                                   image pixels.
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * registered(x, y) = frames(x + dx, y + dy), with (dx, dy) the scaled MC
+%   residual at the time of line y. Shifts are applied separately along
+%   the lines (one shift per line), then across lines (one shift per
+%   output line), with linear interpolation. A line lasts < 250 us, so the
+%   displacement is considered constant within a line.
+%
+% * MC log times are aligned to the acquisition start of the trial, marked
+%   in binary logs by MCViewer.mark_acquisition_start() on the MC sampler
+%   clock. Logs without marker (e.g. text logs) fall back to the first
+%   record of the trial, with a warning, which is only correct if logging
+%   started with the acquisition. Records are held constant before the
+%   first and after the last record.
+%
+% * Each chunk is processed with a few vectorised operations, which use
+%   all cores. Chunks are about 64 MB, independently of the trial size.
+%
+% * Z residuals are not corrected, as frames are 2D.
+% -------------------------------------------------------------------------
+% Examples:
+% * Register the first channel of a frame scan recorded with timed_image,
+%   with 2 image pixels per MC pixel
+%   [all_data, n_cycles] = c.timed_image();
+%   [X, Y] = deal(c.scan_params.voxels_for_ramp(1), c.scan_params.num_drives);
+%   frames = reshape(all_data{1}(:, 1), X, Y, n_cycles);
+%   [~, ~, ~, t_line] = c.scan_params.get_fps(n_cycles, c.mc_scan_params, c.daq_fpga.MC_rate);
+%   mc_log = import_MC_binary_log(dir('*MC_log_timed_image_repeat_001.mcbin'));
+%   registered = register_from_mc_log(frames, mc_log, 1, t_line, 2);
+%
+% * Register a file of frames larger than memory, stored as consecutive
+%   [X Y] UINT16 frames, and write the result in another file
+%   frames = memmapfile('frames.bin', 'Format', {'uint16', [X, Y], 'frame'});
+%   registered = register_from_mc_log(frames, mc_log, 1, t_line, 2, 'frames_registered.bin');
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: load_mc_log, import_MC_binary_log, ScanParams.get_fps,
+%   MCEstimator
+
+function [registered, shifts] = register_from_mc_log(frames, mc_log, trial, line_times, scaling, output)
+    if nargin < 3 || isempty(trial)
+        trial = 1;
+    end
+    if nargin < 5 || isempty(scaling)
+        scaling = 1;
+    end
+    if nargin < 6
+        output = '';
+    end
+    scaling(end+1:2) = scaling(1);
+
+    %% Frames size
+    mapped = isa(frames, 'memmapfile');
+    if mapped
+        field = fieldnames(frames.Data);
+        if numel(field) ~= 1
+            error('register_from_mc_log memmapfile must have a single field, one [X Y] frame per element')
+        end
+        field = field{1};
+        [n_x, n_y] = size(frames.Data(1).(field));
+        n_frames = numel(frames.Data);
+    else
+        [n_x, n_y, n_frames] = size(frames);
+    end
+
+    %% Time of each line
+    if numel(line_times) == n_y
+        period = line_times(end) + line_times(min(2, n_y)) - line_times(1);
+        line_times = line_times(:) + (0:n_frames - 1) * period;
+    elseif numel(line_times) == n_y * n_frames
+        line_times = reshape(line_times, n_y, n_frames);
+    else
+        error('register_from_mc_log line_times must have one value per line, for one or all frames')
+    end
+
+    %% Residual displacement at each line, in image pixels
+    t_acq = NaN;
+    if iscell(mc_log.Time)
+        [mc_time, dx, dy] = deal(mc_log.Time{trial}, mc_log.X_difference{trial}, mc_log.Y_difference{trial});
+        if isfield(mc_log, 'Acquisition_start')
+            t_acq = mc_log.Acquisition_start{trial};
+        end
+    else
+        [mc_time, dx, dy] = deal(mc_log.Time, mc_log.X_difference, mc_log.Y_difference);
+        if isfield(mc_log, 'Acquisition_start')
+            t_acq = mc_log.Acquisition_start;
+        end
+    end
+    if isnan(t_acq)
+        warning('The MC log has no acquisition start marker. MC times are aligned to the first record')
+        t_acq = mc_time(1);
+    end
+    [mc_time, idx] = unique(mc_time(:) - t_acq);
+    if numel(mc_time) < 2
+        error('register_from_mc_log needs at least 2 MC log records')
+    end
+    residual = [reshape(dx(idx), [], 1), reshape(dy(idx), [], 1)];
+    residual(isnan(residual)) = 0;
+    shifts = interp1(mc_time, residual, line_times(:), 'linear');
+    shifts = fillmissing(shifts, 'nearest', 1) .* scaling;
+    shifts = reshape(shifts, n_y, n_frames, 2);
+
+    %% Prepare output
+    if isempty(output)
+        registered = zeros(n_x, n_y, n_frames, 'single');
+    else
+        fid = fopen(output, 'w');
+        if fid < 0
+            error(['Unable to open ', output])
+        end
+        cleanup = onCleanup(@() fclose(fid));
+    end
+
+    %% Register chunks of frames
+    chunk_size = max(1, floor(2^24 / (n_x * n_y)));
+    for first = 1:chunk_size:n_frames
+        last    = min(first + chunk_size - 1, n_frames);
+        if mapped
+            chunk = cat(3, frames.Data(first:last).(field));
+        else
+            chunk = frames(:, :, first:last);
+        end
+        chunk   = shift_first_dim(single(chunk), permute(shifts(:, first:last, 1), [3, 1, 2]));          % along lines
+        chunk   = shift_first_dim(permute(chunk, [2, 1, 3]), permute(shifts(:, first:last, 2), [1, 3, 2])); % across lines
+        chunk   = permute(chunk, [2, 1, 3]);
+        if isempty(output)
+            registered(:, :, first:last) = chunk;
+        else
+            fwrite(fid, chunk, 'single');
+        end
+    end
+
+    if ~isempty(output)
+        clear cleanup
+        registered = memmapfile(output, 'Format', {'single', [n_x, n_y], 'frame'});
+    end
+end
+
+function out = shift_first_dim(in, shift)
+    %% out(i, j, k) = in(i + shift, j, k), with linear interpolation
+    % shift is broadcast to the size of in. Out of range samples are NaN
+    n       = size(in, 1);
+    pos     = (1:n)' + shift;
+    pos     = pos + zeros(size(in), 'like', pos);
+    low     = floor(pos);
+    frac    = single(pos - low);
+    valid   = low >= 1 & low <= n;
+    low     = min(max(low, 1), n);
+    high    = min(low + 1, n);
+    base    = reshape(0:numel(in) / n - 1, [1, size(in, 2), size(in, 3)]) * n;
+    out     = (1 - frac) .* in(low + base) + frac .* in(high + base);
+    out(~valid | (low == n & frac > 0)) = NaN;
+end
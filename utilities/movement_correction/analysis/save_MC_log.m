@@ -32,6 +32,8 @@
 %                       - Time         = System timestamps of read time.
 % -------------------------------------------------------------------------
 % Extra Notes:
+% * If binary logs (*.mcbin) are found, they are loaded with
+%   import_MC_binary_log and text logs are ignored.
 % -------------------------------------------------------------------------
 % Examples:
 % -------------------------------------------------------------------------
@@ -60,9 +62,9 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   05-02-2019
+%   18-10-2026
 %
-% See also: import_MC_log, timed_image, load_mc_log
+% See also: import_MC_log, import_MC_binary_log, timed_image, load_mc_log
 
 
 function mc_log = save_MC_log(source_folder, rendering, keep_raw)
@@ -80,6 +82,18 @@ function mc_log = save_MC_log(source_folder, rendering, keep_raw)
         cleanupObj = onCleanup(@() clear_logs()); %run on normal completion, or a forced exit, such as an error or CTRL+C
     end
     
+    %% Binary logs, loaded in one go
+    files = dir([source_folder, '*MC_log_timed_image_repeat_*.mcbin']);
+    if ~isempty(files)
+        mc_log = import_MC_binary_log(files, rendering);
+        if ~keep_raw
+            for r = 1:numel(files)
+                force_delete([files(r).folder,'/',files(r).name]); % delete temporary file if processed
+            end
+        end
+        return
+    end
+    
     %% Initialise cells (one per trial)
     X_correction = {};
     Y_correction = {};
@@ -130,4 +144,8 @@ function clear_logs()
     for idx = 1:numel(files)
         movefile([files(idx).folder,'/',files(idx).name],strrep([files(idx).folder,'/',files(idx).name],'.txt','.mcbkp'));
     end
+    files = dir('*MC_log_*.mcbin');
+    for idx = 1:numel(files)
+        movefile([files(idx).folder,'/',files(idx).name],strrep([files(idx).folder,'/',files(idx).name],'.mcbin','.mcbinbkp'));
+    end
 end
\ No newline at end of file
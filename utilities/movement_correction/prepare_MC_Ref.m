@@ -9,7 +9,7 @@
 %           prepare_MC_Ref( controller, absolute_z_for_ref, ref_channel,
 %                           suggested_ROI, non_default_resolution,
 %                           non_default_aa, non_default_dwelltime,
-%                           non_default_pockel_voltages)
+%                           non_default_pockel_voltages, interactive)
 %
 % -------------------------------------------------------------------------
 % Inputs: 
@@ -55,6 +55,13 @@
 %                                   In V, the pockel value to use for both
 %                                   the full frame preview and the miniscan
 %                                   THR selection.
+%
+%   interactive(BOOL) - Optional - Default is true
+%                                   If false, the ROI is placed at
+%                                   suggested_ROI (or at the center of the
+%                                   FOV) without the ROI selection GUI, and
+%                                   thresholds are set with auto_MC_thr.
+%                                   This allows unattended MC setup.
 % -------------------------------------------------------------------------
 % Outputs:
 %   status(BOOL):
@@ -118,13 +125,13 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   14-03-2019
+%   18-10-2026
 %
 % See also: preview_at_any_z, select_ROI, prepare_MC_miniscan,
-%   get_averaged_data, select_MC_thr 
+%   get_averaged_data, select_MC_thr, auto_MC_thr 
 %
 
-function [status, miniscan_ROI, suggested_thr, absolute_z_for_ref, ref_channel] = prepare_MC_Ref(controller, absolute_z_for_ref, ref_channel, suggested_ROI, non_default_resolution, non_default_aa, non_default_dwelltime, non_default_pockel_voltages)
+function [status, miniscan_ROI, suggested_thr, absolute_z_for_ref, ref_channel] = prepare_MC_Ref(controller, absolute_z_for_ref, ref_channel, suggested_ROI, non_default_resolution, non_default_aa, non_default_dwelltime, non_default_pockel_voltages, interactive)
     if nargin < 1 || isempty(controller)
         controller = get_existing_controller_name(true);
     end
@@ -149,6 +156,9 @@ function [status, miniscan_ROI, suggested_thr, absolute_z_for_ref, ref_channel]
     if nargin < 8 || isempty(non_default_pockel_voltages)
         non_default_pockel_voltages = controller.pockels.on_value;
     end
+    if nargin < 9 || isempty(interactive)
+        interactive = true;
+    end
     
     %% Store initial scan_params
     controller.reset_frame_and_send();
@@ -174,14 +184,18 @@ function [status, miniscan_ROI, suggested_thr, absolute_z_for_ref, ref_channel]
     end
 
     %% Open GUI to adjust ROI size and location
-    fprintf('ctrl-c to cancel ROI location selection...\n')
-    input_params    = {};
-    input_params{1} = absolute_z_for_ref;
-    input_params{2} = non_default_resolution;
-    input_params{3} = non_default_aa;
-    input_params{4} = 5e-8; % for maximal FOV
-    input_params{5} = non_default_pockel_voltages;
-    [miniscan_ROI, ref_channel, absolute_z_for_ref] = select_ROI(controller, suggested_ROI, ROI_size, ref_channel, reference_frame, input_params);
+    if interactive
+        fprintf('ctrl-c to cancel ROI location selection...\n')
+        input_params    = {};
+        input_params{1} = absolute_z_for_ref;
+        input_params{2} = non_default_resolution;
+        input_params{3} = non_default_aa;
+        input_params{4} = 5e-8; % for maximal FOV
+        input_params{5} = non_default_pockel_voltages;
+        [miniscan_ROI, ref_channel, absolute_z_for_ref] = select_ROI(controller, suggested_ROI, ROI_size, ref_channel, reference_frame, input_params);
+    else
+        miniscan_ROI = [suggested_ROI(1), suggested_ROI(2), suggested_ROI(1)+ROI_size, suggested_ROI(2)+ROI_size, ROI_size, ROI_size]; % Same format as select_ROI
+    end
     
     %% If completed, get a miniscan of the region, and open a GUI to select threshold
     if ~isempty(miniscan_ROI) && ~isnan(miniscan_ROI(1))
@@ -191,7 +205,7 @@ function [status, miniscan_ROI, suggested_thr, absolute_z_for_ref, ref_channel]
         %% Get miniscan frame
         controller.initialise();  
         reference_frame = get_averaged_data(controller, n_averages, false, false);
-        suggested_thr = select_MC_thr(permute(reference_frame(:,:,ref_channel),[2,1,3])); %% qq not sure if the rotation comes from XYswapped
+        suggested_thr = select_MC_thr(permute(reference_frame(:,:,ref_channel),[2,1,3]), interactive); %% qq not sure if the rotation comes from XYswapped
         
         %% If completed, set ref_channel and some other variables 
         if ~isnan(suggested_thr)
@@ -199,6 +213,7 @@ function [status, miniscan_ROI, suggested_thr, absolute_z_for_ref, ref_channel]
             controller.suggested_MC_ROI = miniscan_ROI;
             controller.suggested_z_ref  = absolute_z_for_ref;
             controller.suggested_thr    = suggested_thr;
+            controller.mc_reference     = reference_frame(:,:,ref_channel); % Same layout as FIFOREFHOSTFRAME frames
             status                      = true; % success            
         end
     end
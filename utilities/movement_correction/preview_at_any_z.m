@@ -76,7 +76,7 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   14-03-2019
+%   18-10-2026
 %
 % See also: controller.single_record, get_averaged_data, prepare_MC_Ref
 
@@ -121,7 +121,8 @@ function reference = preview_at_any_z(controller, absolute_z_for_ref, non_defaul
     controller.scan_params.mainscan_x_pixel_density = non_default_resolution;
     controller.scan_params.acceptance_angle = non_default_aa;
     controller.scan_params.voxel_time = non_default_dwelltime;
-    z_norm = controller.aol_params.convert_z_um_to_norm(absolute_z_for_ref, controller.scan_params.acceptance_angle, controller.xyz_stage.get_position(3));
+    transform = controller.aol_params.get_transform(controller.scan_params.acceptance_angle, controller.scan_params.mainscan_x_pixel_density, controller.xyz_stage.get_position(3));
+    z_norm = transform.z_um_to_norm(absolute_z_for_ref);
     controller.scan_params.start_norm_raw(3) = z_norm;
     controller.send_drives(true, non_default_pockel_voltages); %since cropped data is taken from the viewer using coordinates, we have to change it
     
@@ -1,7 +1,7 @@
 %% Select movement correction threshold from selected ROI
 % -------------------------------------------------------------------------
 % Syntax: 
-% thresholds = select_MC_thr(cropped)
+% thresholds = select_MC_thr(cropped, interactive, method)
 %
 % -------------------------------------------------------------------------
 % Inputs: 
@@ -10,6 +10,17 @@
 %                                   IF N = M, we assume XY movement only.
 %                                   If M > N, the we assume M-N Z lines.
 %                                   For now, XY-ref must be square
+%
+%   interactive(BOOL) - Optional - Default is true:
+%                                   If true, thresholds are adjusted in a
+%                                   GUI, starting from the automatic
+%                                   values. If false, the automatic values
+%                                   are returned directly.
+%
+%   method(STR) - Optional - any of {'otsu', 'triangle'} - Default is
+%           'otsu':
+%                                   The method used for the automatic XY
+%                                   threshold. See auto_MC_thr
 % -------------------------------------------------------------------------
 % Outputs:
 %   thresholds([1 X 2] UINT16 OR [NaN, NaN]):
@@ -27,6 +38,8 @@
 %   the thresholded object. You may want the same value than for XY, but 
 %   having a lower threshold allow the vertical scan to keep working even
 %   when being on the edge of the reference.
+%
+% * Initial values come from auto_MC_thr.
 % -------------------------------------------------------------------------
 % Examples:
 % -------------------------------------------------------------------------
@@ -55,12 +68,27 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   14-03-2019
+%   18-10-2026
 %
-% See also: prepare_MC_Ref, select_ROI, Controller.prepare_daq_for_mc
+% See also: prepare_MC_Ref, select_ROI, Controller.prepare_daq_for_mc,
+%   auto_MC_thr
 
-function thresholds = select_MC_thr(cropped)
+function thresholds = select_MC_thr(cropped, interactive, method)
+    if nargin < 2 || isempty(interactive)
+        interactive = true;
+    end
+    if nargin < 3 || isempty(method)
+        method = 'otsu';
+    end
+    
+    %% Automatic thresholds
+    thresholds = auto_MC_thr(cropped, method);
+    if ~interactive
+        return
+    end
+    
     global I first_run z_lines
+    I = struct('auto_thr', thresholds);
     
     %% Generate Figure
     I.fig = figure(1051);
@@ -95,7 +123,7 @@ function I = image_plot(I)
        
        %% Prepare X-Y plot
        subplot(1,2,1);
-       I.thrXY = max(I.croppedxy(:))/2; % Suggest half max as initial value   
+       I.thrXY = min(I.auto_thr(1), max(I.croppedxy(:))); % Suggest auto_MC_thr value as initial value
        I.title1 = title(num2str(round(I.thrXY))); hold on;
        I.thrXY_im = I.croppedxy > I.thrXY; % Binarize view
        I.XY = imagesc(I.thrXY_im); axis image       
@@ -104,8 +132,7 @@ function I = image_plot(I)
        %% If any Z-Lines, Prepare Z plot
        if ~isempty(I.croppedz)
            subplot(1,2,2);
-           cont = logical(imdilate(I.thrXY_im,strel('disk',1)) - I.thrXY_im);
-           I.thrZ = prctile(I.croppedxy(cont),20);
+           I.thrZ = min(I.auto_thr(2), max(I.croppedz(:)));
            I.title2 = title(num2str(round(I.thrZ))); hold on;
            I.thrZ_im = I.croppedz > I.thrZ;
            I.Z  = imagesc(I.thrZ_im);axis image   
@@ -0,0 +1,331 @@
+%% Host-side estimation of the MC displacement from reference frames
+% Compute XYZ displacements from MC reference frames (as read from the
+% FIFOREFHOSTFRAME FIFO, or extracted from recorded data), using the same
+% thresholded centroid as the FPGA, or FFT phase correlation against the
+% reference acquired by prepare_MC_Ref. Use it to validate the FPGA PI loop
+% offline, or to estimate motion in recordings done without MC.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = MCEstimator(reference, thresholds, z_lines, method);
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   reference ([X x (Y + Z)] NUMERIC)
+%       The MC reference frame, in the FIFOREFHOSTFRAME layout, i.e.
+%       Controller.daq_fpga.mc_roi_size. Z lines are the last z_lines
+%       columns. Controller.mc_reference is set by prepare_MC_Ref.
+%
+%   thresholds ([1 x 2] INT) - Optional - default is [0, 0]
+%       XY and Z thresholds, as selected with select_MC_thr. Values below
+%       the threshold do not contribute to the centroids.
+%
+%   z_lines (INT) - Optional - default is size(reference, 2) -
+%           size(reference, 1)
+%       The number of Z lines at the end of the frame.
+%
+%   method (STR) - Optional - any of {'centroid', 'phase'} - default is
+%           'centroid'
+%       XY estimation method. Z always uses the centroid of the Z lines.
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (MCEstimator object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Estimate the displacement of a series of frames
+%   [displacement, score] = MCEstimator.estimate(frames)
+%
+% * Estimate and store the displacement of frames from the live stream
+%   displacement = MCEstimator.push(frames)
+%
+% * Build an estimator from the current controller MC settings (static)
+%   this = MCEstimator.from_controller(controller, method)
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Displacements are [x, y, z] in miniscan pixels, positive when the
+%   sample moved towards higher indexes. The FPGA correction should be the
+%   opposite of the displacement.
+%
+% * All frames are processed at once (frames are stacked along the 3rd
+%   dimension). Centroids are weighted sums, and phase correlation uses
+%   fft2 on the whole stack, which are both multithreaded in MATLAB.
+%
+% * Phase correlation peaks are refined with a 3-point parabolic fit, so
+%   displacements are sub-pixel for both methods.
+%
+% * score is the thresholded intensity (centroid) or the correlation peak
+%   height (phase). Frames with no pixel above threshold return NaN.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Track the live MC stream
+%   estimator = MCEstimator.from_controller(controller);
+%   controller.daq_fpga.mc_estimator = estimator;
+%   controller.daq_fpga.live_rendering_mode = 1; % read FIFOREFHOSTFRAME
+%   ...
+%   plot(estimator.history(:, 1:3))
+%
+% * Estimate motion in a recorded miniscan, using the first frame as
+%   reference
+%   estimator = MCEstimator(mean(frames(:,:,1:10), 3), [], 0, 'phase');
+%   displacement = estimator.estimate(frames);
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: prepare_MC_Ref, select_MC_thr, MCViewer, data_acquisition
+
+classdef MCEstimator < handle
+    properties
+        reference       = [];           % [X x (Y + Z)] SINGLE reference frame
+        thresholds      = [0, 0];       % XY and Z thresholds
+        z_lines         = 0;            % Number of Z lines
+        method          = 'centroid';   % 'centroid' or 'phase'
+        history         = zeros(0, 5);  % [time, x, y, z, score] of each pushed frame. time is a datenum
+        max_history     = 100000;       % Oldest estimates are dropped after that
+    end
+
+    properties (SetAccess = private)
+        ref_centroid    = [NaN, NaN, NaN]; % [x, y, z] centroid of the reference
+        ref_spectrum    = [];           % conj(fft2) of the normalised XY reference
+    end
+
+    methods
+        function this = MCEstimator(reference, thresholds, z_lines, method)
+            %% MCEstimator Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = MCEstimator(reference, thresholds, z_lines, method);
+            % -------------------------------------------------------------
+            % Inputs:
+            %   reference ([X x (Y + Z)] NUMERIC)
+            %       The MC reference frame
+            %
+            %   thresholds ([1 x 2] INT) - Optional - default is [0, 0]
+            %       XY and Z thresholds
+            %
+            %   z_lines (INT) - Optional - default is the number of extra
+            %           columns of the reference
+            %       The number of Z lines
+            %
+            %   method (STR) - Optional - default is 'centroid'
+            %       XY estimation method, 'centroid' or 'phase'
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (MCEstimator object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 2 || isempty(thresholds)
+                thresholds = [0, 0];
+            end
+            if nargin < 3 || isempty(z_lines)
+                z_lines = max(0, size(reference, 2) - size(reference, 1));
+            end
+            if nargin >= 4 && ~isempty(method)
+                this.method = method;
+            end
+            if ~any(strcmp(this.method, {'centroid', 'phase'}))
+                error('MCEstimator method must be ''centroid'' or ''phase''')
+            elseif z_lines >= size(reference, 2)
+                error('The reference frame has no XY lines')
+            end
+
+            this.thresholds     = double(thresholds([1, end]));
+            this.z_lines        = z_lines;
+            this.reference      = single(reference);
+            [xy, z]             = this.split(this.reference);
+            this.ref_centroid   = this.centroids(xy, z);
+            this.ref_spectrum   = conj(fft2(MCEstimator.normalise(xy)));
+        end
+
+        function [displacement, score] = estimate(this, frames)
+            %% Estimate the displacement of a series of frames
+            % -------------------------------------------------------------
+            % Syntax:
+            %   [displacement, score] = MCEstimator.estimate(frames)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   frames ([X x (Y + Z) x T] NUMERIC or [1 x N] NUMERIC)
+            %       T frames with the same size as the reference. A vector
+            %       (as read from the FIFO) is reshaped to T frames.
+            % -------------------------------------------------------------
+            % Outputs:
+            %   displacement ([T x 3] DOUBLE)
+            %       [x, y, z] displacement, in pixels, of each frame
+            %       relative to the reference. z is NaN if there are no Z
+            %       lines.
+            %
+            %   score ([T x 1] DOUBLE)
+            %       Thresholded intensity (centroid) or correlation peak
+            %       (phase) of each frame.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            frames          = reshape(single(frames), size(this.reference, 1), size(this.reference, 2), []);
+            [xy, z]         = this.split(frames);
+            [centroid, score] = this.centroids(xy, z);
+            displacement    = centroid - this.ref_centroid;
+
+            if strcmp(this.method, 'phase')
+                [displacement(:, 1:2), score] = this.phase_correlation(xy);
+            end
+        end
+
+        function displacement = push(this, frames)
+            %% Estimate and store the displacement of frames from the live stream
+            % -------------------------------------------------------------
+            % Syntax:
+            %   displacement = MCEstimator.push(frames)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   frames ([X x (Y + Z) x T] NUMERIC or [1 x N] NUMERIC)
+            %       Frames, as in MCEstimator.estimate()
+            % -------------------------------------------------------------
+            % Outputs:
+            %   displacement ([T x 3] DOUBLE)
+            %       [x, y, z] displacements, also appended to this.history
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            [displacement, score] = this.estimate(frames);
+            this.history = [this.history; repmat(now, size(score)), displacement, score];
+            if size(this.history, 1) > this.max_history
+                this.history = this.history(end-this.max_history+1:end, :);
+            end
+        end
+    end
+
+    methods (Access = private)
+        function [xy, z] = split(this, frames)
+            %% Separate XY lines and Z lines
+            xy  = frames(:, 1:end-this.z_lines, :);
+            z   = frames(:, end-this.z_lines+1:end, :);
+        end
+
+        function [centroid, score] = centroids(this, xy, z)
+            %% Thresholded centroids of a stack of frames, [T x 3]
+            w           = max(xy - this.thresholds(1), 0);
+            score       = squeeze(sum(sum(w, 1), 2));
+            cx          = squeeze(sum((1:size(w, 1))' .* sum(w, 2), 1)) ./ score;
+            cy          = squeeze(sum((1:size(w, 2)) .* sum(w, 1), 2)) ./ score;
+            if this.z_lines
+                wz      = max(z - this.thresholds(2), 0);
+                cz      = squeeze(sum((1:size(wz, 1))' .* sum(wz, 2), 1) ./ sum(sum(wz, 1), 2));
+            else
+                cz      = NaN(size(cx));
+            end
+            score       = double(score(:));
+            centroid    = double([cx(:), cy(:), cz(:)]);
+            centroid(score == 0, :) = NaN;
+            score(score == 0) = NaN;
+        end
+
+        function [shift, peak] = phase_correlation(this, xy)
+            %% Sub-pixel phase correlation of a stack of frames, [T x 2]
+            [n1, n2, n_frames] = size(xy);
+            cross       = fft2(MCEstimator.normalise(xy)) .* this.ref_spectrum;
+            corr        = real(ifft2(cross ./ max(abs(cross), eps('single'))));
+
+            %% Integer peak, then parabolic refinement on each axis
+            [peak, idx] = max(reshape(corr, [], n_frames), [], 1);
+            [i1, i2]    = ind2sub([n1, n2], idx);
+            page        = (0:n_frames - 1) * n1 * n2;
+            at          = @(a, b) double(corr(a + (b - 1) * n1 + page));
+            d1          = MCEstimator.parabolic_peak(at(mod(i1 - 2, n1) + 1, i2), peak, at(mod(i1, n1) + 1, i2));
+            d2          = MCEstimator.parabolic_peak(at(i1, mod(i2 - 2, n2) + 1), peak, at(i1, mod(i2, n2) + 1));
+            shift       = [i1 - 1 + d1; i2 - 1 + d2]';
+
+            %% Circular shifts to signed displacements
+            shift(:, 1) = shift(:, 1) - n1 * (shift(:, 1) > n1 / 2);
+            shift(:, 2) = shift(:, 2) - n2 * (shift(:, 2) > n2 / 2);
+            peak        = double(peak(:));
+        end
+    end
+
+    methods (Static)
+        function this = from_controller(controller, method)
+            %% Build an estimator from the current controller MC settings
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = MCEstimator.from_controller(controller, method)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   controller (Controller object) - Optional - default is the
+            %           current controller
+            %
+            %   method (STR) - Optional - default is 'centroid'
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (MCEstimator object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 1 || isempty(controller)
+                controller = get_existing_controller_name(true);
+            end
+            if nargin < 2
+                method = [];
+            end
+            if isempty(controller.mc_reference)
+                error('No MC reference available. Run prepare_MC_Ref first')
+            end
+            this = MCEstimator(controller.mc_reference, controller.suggested_thr, controller.daq_fpga.Z_Lines, method);
+        end
+    end
+
+    methods (Static, Access = private)
+        function frames = normalise(frames)
+            %% Remove the mean of each frame
+            frames = frames - mean(mean(frames, 1), 2);
+        end
+
+        function d = parabolic_peak(left, center, right)
+            %% Sub-pixel offset of a peak from its 2 neighbours
+            d = (left - right) ./ (2 * (left - 2 * double(center) + right));
+            d(~isfinite(d)) = 0;
+        end
+    end
+end
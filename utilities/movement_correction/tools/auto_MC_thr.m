@@ -0,0 +1,156 @@
+%% Estimate movement correction thresholds without user interaction
+% -------------------------------------------------------------------------
+% Syntax:
+%   [thresholds, snr_z] = auto_MC_thr(cropped, method, min_snr)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   cropped([N X M] UINT16):
+%                                   The frame coming from the selected ROI,
+%                                   with the same layout as in
+%                                   select_MC_thr. If M > N, the last M-N
+%                                   rows are Z lines.
+%
+%   method(STR) - Optional - any of {'otsu', 'triangle'} - Default is
+%           'otsu':
+%                                   The histogram method used for the XY
+%                                   threshold. 'triangle' is better suited
+%                                   to small bright objects on a large
+%                                   dark background.
+%
+%   min_snr(FLOAT) - Optional - Default is 3:
+%                                   The Z threshold is never set less than
+%                                   min_snr noise standard deviations above
+%                                   the Z lines background.
+% -------------------------------------------------------------------------
+% Outputs:
+%   thresholds([1 X 2] DOUBLE):
+%                                   XY and Z Threshold. If there are no Z
+%                                   lines, then Z-threshold == XY-threshold
+%
+%   snr_z(FLOAT):
+%                                   (max - background) / noise of the Z
+%                                   lines. NaN if there are no Z lines.
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * XY : Otsu or triangle threshold of a 256 bins histogram of the XY ROI.
+%
+% * Z : like in select_MC_thr, the 20th percentile of the pixels on the
+%   contour of the thresholded XY object, so that Z tracking still works
+%   on the edges of the reference. The background and noise of the Z lines
+%   are estimated with the median and the MAD, and the threshold is raised
+%   to background + min_snr * noise if needed, so that noise alone can't
+%   drive the Z centroid.
+%
+% * Thresholds are computed in a few vectorised operations, and can be
+%   used unattended (see prepare_MC_Ref and MC_selection_pipeline).
+% -------------------------------------------------------------------------
+% Examples:
+% * Get thresholds for a random 18 x 18 ROI with 5 Z lines
+%   thresholds = auto_MC_thr(randi(2000, 23, 18));
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: select_MC_thr, prepare_MC_Ref, sweep_MC_params
+
+function [thresholds, snr_z] = auto_MC_thr(cropped, method, min_snr)
+    if nargin < 2 || isempty(method)
+        method = 'otsu';
+    end
+    if nargin < 3 || isempty(min_snr)
+        min_snr = 3;
+    end
+
+    %% Split XY and Z lines, as in select_MC_thr
+    cropped     = double(cropped);
+    z_lines     = max(size(cropped)) - min(size(cropped));
+    croppedxy   = cropped(1:end-z_lines,:);
+    croppedz    = cropped(end-z_lines+1:end,:);
+
+    %% XY threshold from the histogram
+    if strcmp(method, 'otsu')
+        thr_xy  = otsu_threshold(croppedxy(:));
+    elseif strcmp(method, 'triangle')
+        thr_xy  = triangle_threshold(croppedxy(:));
+    else
+        error('auto_MC_thr method must be ''otsu'' or ''triangle''')
+    end
+
+    %% Z threshold from the XY object contour, above the Z lines noise
+    snr_z       = NaN;
+    if ~z_lines
+        thr_z   = thr_xy;
+    else
+        object  = croppedxy > thr_xy;
+        contour = logical(imdilate(object, strel('disk', 1)) - object);
+        if any(contour(:))
+            thr_z = prctile(croppedxy(contour), 20);
+        else
+            thr_z = thr_xy;
+        end
+        background = median(croppedz(:));
+        noise   = max(1.4826 * median(abs(croppedz(:) - background)), eps);
+        snr_z   = (max(croppedz(:)) - background) / noise;
+        thr_z   = max(thr_z, background + min_snr * noise);
+    end
+
+    thresholds  = round([thr_xy, thr_z]);
+end
+
+function [counts, centers] = get_histogram(values)
+    %% 256 bins histogram between min and max
+    edges       = linspace(min(values), max(values) + eps(max(values)), 257);
+    counts      = histcounts(values, edges);
+    centers     = (edges(1:end-1) + edges(2:end)) / 2;
+end
+
+function thr = otsu_threshold(values)
+    %% Threshold maximising the between-class variance
+    [counts, centers] = get_histogram(values);
+    p           = counts / sum(counts);
+    w0          = cumsum(p);
+    mu          = cumsum(p .* centers);
+    between     = (mu(end) * w0 - mu).^2 ./ (w0 .* (1 - w0));
+    between(~isfinite(between)) = 0;
+    [~, idx]    = max(between);
+    thr         = centers(idx);
+end
+
+function thr = triangle_threshold(values)
+    %% Bin furthest from the line between the histogram peak and its tail
+    [counts, centers] = get_histogram(values);
+    [peak, p_idx] = max(counts);
+    t_idx       = find(counts, 1, 'last');
+    if t_idx <= p_idx % Peak at the bright end. Use the dark tail instead
+        t_idx   = find(counts, 1, 'first');
+    end
+    bins        = min(p_idx, t_idx):max(p_idx, t_idx);
+    distance    = abs((counts(t_idx) - peak) * (bins - p_idx) - (t_idx - p_idx) * (counts(bins) - peak));
+    [~, idx]    = max(distance);
+    thr         = centers(bins(idx));
+end
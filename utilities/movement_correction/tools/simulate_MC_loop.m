@@ -0,0 +1,227 @@
+%% Simulate the FPGA MC control loop on a reference frame and a motion trace
+%   Replay a motion trace on the MC reference frame, and run the centroid /
+%   difference / PI correction / lost tracking loop for one or several sets
+%   of MC parameters at once. Use it (or sweep_MC_params) to choose
+%   thresholds and gains before an experiment.
+%
+% -------------------------------------------------------------------------
+% Syntax:
+%   [correction, difference, lost] = simulate_MC_loop(reference, motion,
+%                                               params, z_lines, noise_std)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   reference ([X x (Y + Z)] NUMERIC)
+%                       The MC reference frame, in the FIFOREFHOSTFRAME
+%                       layout (see MCEstimator). Controller.mc_reference
+%                       is set by prepare_MC_Ref.
+%
+%   motion ([T x 3] or [T x 2] FLOAT)
+%                       [x, y, z] displacement of the sample, in miniscan
+%                       pixels, at each MC cycle. See Examples to build it
+%                       from a MC log or from recorded reference frames.
+%
+%   params (STRUCT or [1 x N] STRUCT) - Optional - default is the
+%           update_daq_parameters defaults
+%                       MC parameters, using the DaqFpga names :
+%                       threshold_xy, threshold_z, proportianal_x10,
+%                       proportianal_x10_z, Integral_scale,
+%                       Integral_scale_z, diff_thresh_x10,
+%                       diff_thresh_x10_z, ref_diff_x_y, ref_diff_z.
+%                       Missing fields use the defaults. With N structs, N
+%                       loops are simulated in parallel.
+%
+%   z_lines (INT) - Optional - default is size(reference, 2) -
+%           size(reference, 1)
+%                       The number of Z lines at the end of the reference.
+%
+%   noise_std (FLOAT) - Optional - default is 0
+%                       Standard deviation of gaussian noise added to each
+%                       simulated frame, in reference intensity units.
+% -------------------------------------------------------------------------
+% Outputs:
+%   correction ([T x 3 x N] DOUBLE)
+%                       Correction applied after each cycle, in pixels
+%                       (x_correction_X10 / 10, etc...)
+%
+%   difference ([T x 3 x N] DOUBLE)
+%                       Measured centroid difference at each cycle, in
+%                       pixels (x_diff_X100 / 100, etc...). NaN when no
+%                       pixel is above threshold.
+%
+%   lost ([T x 2 x N] LOGICAL)
+%                       XY and Z lost tracking flags
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * The loop is a model of the FPGA logic based on the register semantics,
+%   not a bit-exact port of the FPGA VI (which is not part of this
+%   repository). At each cycle :
+%       - the reference is shifted by (motion - correction), XY in 2D and
+%         Z lines along their first dimension (Fourier shift)
+%       - difference = thresholded centroid - reference centroid, rounded
+%         to 0.01 px (X100 registers)
+%       - differences below diff_thresh_x10 / 10 are zeroed
+%       - if a difference is above ref_diff / 10, or nothing is above
+%         threshold, tracking is lost and the correction is held
+%       - otherwise correction = P * difference + integral / I, with
+%         P = proportianal_x10 / 10, I = Integral_scale and integral the
+%         sum of the differences measured while tracking. This is a
+%         positional PI loop: a constant motion is fully corrected by the
+%         integral term, and the proportional term only acts on the last
+%         residual. The register scaling (X10 gain, integral divided by
+%         Integral_scale) is an assumption, as the FPGA VI is not available
+%       - while tracking is lost, the last correction is held
+%       - corrections are rounded to 0.1 px (XY, X10 registers) and 0.01 px
+%         (Z, X100 register), and clipped to +/-128 px
+%
+% * The N parameter sets are simulated together, with one fft2 on a
+%   [X x Y x N] stack per cycle.
+% -------------------------------------------------------------------------
+% Examples:
+% * Replay the first trial of a MC log with 2 proportional gains
+%   motion = [mc_log.X_correction{1} + mc_log.X_difference{1};...
+%             mc_log.Y_correction{1} + mc_log.Y_difference{1}]';
+%   params = struct('proportianal_x10', {5, 9});
+%   correction = simulate_MC_loop(controller.mc_reference, motion, params);
+%
+% * Replay motion estimated from recorded reference frames
+%   estimator = MCEstimator.from_controller(controller, 'phase');
+%   motion = estimator.estimate(recorded_frames);
+%   [correction, ~, lost] = simulate_MC_loop(controller.mc_reference, motion);
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: sweep_MC_params, MCEstimator, update_daq_parameters,
+%   select_MC_thr
+
+function [correction, difference, lost] = simulate_MC_loop(reference, motion, params, z_lines, noise_std)
+    if nargin < 3 || isempty(params)
+        params = struct();
+    end
+    if nargin < 4 || isempty(z_lines)
+        z_lines = max(0, size(reference, 2) - size(reference, 1));
+    end
+    if nargin < 5 || isempty(noise_std)
+        noise_std = 0;
+    end
+
+    %% Fill missing parameters with DaqFpga defaults
+    defaults = struct(  'threshold_xy'      , 0     , 'threshold_z'         , 0     ,...
+                        'proportianal_x10'  , 9     , 'proportianal_x10_z'  , 9     ,...
+                        'Integral_scale'    , 400   , 'Integral_scale_z'    , 400   ,...
+                        'diff_thresh_x10'   , 0     , 'diff_thresh_x10_z'   , 0     ,...
+                        'ref_diff_x_y'      , 255   , 'ref_diff_z'          , 255   );
+    for field = fieldnames(defaults)'
+        if ~isfield(params, field{1})
+            [params.(field{1})] = deal(defaults.(field{1}));
+        end
+    end
+    n_sets      = numel(params);
+    per_axis    = @(xy, z) [[params.(xy)]', [params.(xy)]', [params.(z)]'];
+    gain        = per_axis('proportianal_x10', 'proportianal_x10_z') / 10;
+    i_scale     = per_axis('Integral_scale', 'Integral_scale_z');
+    deadband    = per_axis('diff_thresh_x10', 'diff_thresh_x10_z') / 10;
+    max_diff    = per_axis('ref_diff_x_y', 'ref_diff_z') / 10;
+    thr_xy      = reshape([params.threshold_xy], 1, 1, []);
+    thr_z       = reshape([params.threshold_z], 1, 1, []);
+
+    %% Prepare reference spectra and centroids
+    motion(:, end+1:3)  = 0;
+    n_cycles    = size(motion, 1);
+    reference   = double(reference);
+    xy_ref      = reference(:, 1:end-z_lines);
+    z_ref       = reference(:, end-z_lines+1:end);
+    [n1, n2]    = size(xy_ref);
+    k1          = ifftshift((0:n1-1) - floor(n1 / 2))' / n1;
+    k2          = ifftshift((0:n2-1) - floor(n2 / 2)) / n2;
+    xy_spectrum = fft2(xy_ref);
+    z_spectrum  = fft(z_ref, [], 1);
+    ref_xy      = centroid_2d(repmat(xy_ref, 1, 1, n_sets), thr_xy);
+    ref_z       = centroid_1d(repmat(z_ref, 1, 1, n_sets), thr_z);
+
+    %% Run the loop
+    correction  = zeros(n_cycles, 3, n_sets);
+    difference  = NaN(n_cycles, 3, n_sets);
+    lost        = false(n_cycles, 2, n_sets);
+    current     = zeros(n_sets, 3);
+    integral    = zeros(n_sets, 3);
+    for t = 1:n_cycles
+        %% Frames seen by the FPGA for each parameter set
+        residual    = motion(t, :) - current;
+        frames      = real(ifft2(xy_spectrum .* exp(-2i * pi * (k1 .* reshape(residual(:, 1), 1, 1, []) + k2 .* reshape(residual(:, 2), 1, 1, [])))));
+        frames      = frames + noise_std * randn(size(frames));
+        delta       = centroid_2d(frames, thr_xy) - ref_xy;
+        if z_lines
+            frames  = real(ifft(z_spectrum .* exp(-2i * pi * k1 .* reshape(residual(:, 3), 1, 1, [])), [], 1));
+            frames  = frames + noise_std * randn(size(frames));
+            delta(:, 3) = centroid_1d(frames, thr_z) - ref_z;
+        else
+            delta(:, 3) = 0;
+        end
+        delta       = round(delta * 100) / 100;
+
+        %% Lost tracking, deadband and PI update
+        is_lost     = [any(isnan(delta(:, 1:2)) | abs(delta(:, 1:2)) > max_diff(:, 1:2), 2),...
+                       isnan(delta(:, 3)) | abs(delta(:, 3)) > max_diff(:, 3)];
+        step        = delta;
+        step(abs(step) < deadband) = 0;
+        step(is_lost(:, [1, 1, 2])) = 0;
+        integral    = integral + step;
+        tracking    = ~is_lost(:, [1, 1, 2]);
+        update      = gain .* step + integral ./ i_scale;
+        current(tracking) = update(tracking); % Hold the last correction while lost
+        current     = max(min([round(current(:, 1:2) * 10) / 10, round(current(:, 3) * 100) / 100], 128), -128);
+
+        correction(t, :, :) = permute(current, [3, 2, 1]);
+        difference(t, :, :) = permute(delta, [3, 2, 1]);
+        lost(t, :, :)       = permute(is_lost, [3, 2, 1]);
+    end
+    if ~z_lines
+        correction(:, 3, :) = NaN;
+        difference(:, 3, :) = NaN;
+    end
+end
+
+function c = centroid_2d(frames, thr)
+    %% [N x 2] thresholded centroids of a [X x Y x N] stack
+    w       = max(frames - thr, 0);
+    total   = sum(sum(w, 1), 2);
+    cx      = sum((1:size(w, 1))' .* sum(w, 2), 1) ./ total;
+    cy      = sum((1:size(w, 2)) .* sum(w, 1), 2) ./ total;
+    c       = [cx(:), cy(:)];
+    c(total(:) == 0, :) = NaN;
+end
+
+function c = centroid_1d(frames, thr)
+    %% [N x 1] thresholded centroids along the first dimension of a stack
+    w       = max(frames - thr, 0);
+    total   = sum(sum(w, 1), 2);
+    c       = sum((1:size(w, 1))' .* sum(w, 2), 1) ./ total;
+    c       = c(:);
+    c(total(:) == 0) = NaN;
+end
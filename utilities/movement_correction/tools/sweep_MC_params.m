@@ -0,0 +1,149 @@
+%% Sweep MC thresholds and gains on a motion trace, and rank the settings
+%   Run simulate_MC_loop on every combination of a parameter grid, and
+%   sort the combinations by tracking error. Chunks of combinations are
+%   distributed over workers when the Parallel Computing Toolbox is
+%   available.
+%
+% -------------------------------------------------------------------------
+% Syntax:
+%   [results, best] = sweep_MC_params(reference, motion, grid, z_lines,
+%                                     noise_std, settle_cycles)
+%
+% -------------------------------------------------------------------------
+% Inputs:
+%   reference ([X x (Y + Z)] NUMERIC)
+%                       The MC reference frame. See simulate_MC_loop.
+%
+%   motion ([T x 3] or [T x 2] FLOAT)
+%                       The motion trace, in pixels, one row per MC cycle
+%
+%   grid (STRUCT)
+%                       One field per swept parameter, with the list of
+%                       values to test, e.g. grid.proportianal_x10 = 4:2:18.
+%                       Field names are the simulate_MC_loop parameters.
+%                       Other parameters use their defaults.
+%
+%   z_lines (INT) - Optional - default is size(reference, 2) -
+%           size(reference, 1)
+%                       The number of Z lines at the end of the reference.
+%
+%   noise_std (FLOAT) - Optional - default is 0
+%                       Frame noise, see simulate_MC_loop
+%
+%   settle_cycles (INT) - Optional - default is 10
+%                       Number of initial cycles excluded from the error
+% -------------------------------------------------------------------------
+% Outputs:
+%   results ([1 x N] STRUCT)
+%                       One element per combination, sorted from best to
+%                       worst score, with the swept parameters and :
+%                       - rms_xy : RMS residual motion in XY, in pixels
+%                       - rms_z : RMS residual motion in Z, in pixels
+%                       - lost_fraction : fraction of lost cycles
+%                       - score : (rms_xy + rms_z) * (1 + 10 * lost_fraction)
+%
+%   best (STRUCT)
+%                       The best combination (results(1))
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * The residual motion is the motion the FPGA had to measure at each
+%   cycle, i.e. motion minus the correction of the previous cycle.
+%
+% * NaN residuals (lost tracking) are excluded from the RMS and counted in
+%   lost_fraction instead.
+% -------------------------------------------------------------------------
+% Examples:
+% * Choose the XY threshold and gains for the current reference
+%   grid = struct('threshold_xy', 0:50:300, 'proportianal_x10', 4:2:16, 'Integral_scale', [200, 400, 800]);
+%   [results, best] = sweep_MC_params(controller.mc_reference, motion, grid);
+%   controller.daq_fpga.proportianal_x10 = best.proportianal_x10;
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also: simulate_MC_loop, MCEstimator, select_MC_thr
+
+function [results, best] = sweep_MC_params(reference, motion, grid, z_lines, noise_std, settle_cycles)
+    if nargin < 4 || isempty(z_lines)
+        z_lines = max(0, size(reference, 2) - size(reference, 1));
+    end
+    if nargin < 5 || isempty(noise_std)
+        noise_std = 0;
+    end
+    if nargin < 6 || isempty(settle_cycles)
+        settle_cycles = 10;
+    end
+
+    %% Build all combinations as a struct array
+    names           = fieldnames(grid)';
+    values          = struct2cell(grid)';
+    [combos{1:numel(values)}] = ndgrid(values{:});
+    combos          = cellfun(@(c) num2cell(c(:)'), combos, 'UniformOutput', false);
+    args            = [names; combos];
+    params          = struct(args{:});
+
+    %% Simulate chunks of combinations (in parallel if a pool is available)
+    motion(:, end+1:3) = 0;
+    chunk_size      = 64;
+    n_chunks        = ceil(numel(params) / chunk_size);
+    chunks          = cell(1, n_chunks);
+    for chunk = 1:n_chunks
+        chunks{chunk} = params((chunk - 1) * chunk_size + 1:min(chunk * chunk_size, numel(params)));
+    end
+    metrics         = cell(1, n_chunks);
+    parfor chunk = 1:n_chunks
+        [correction, ~, lost] = simulate_MC_loop(reference, motion, chunks{chunk}, z_lines, noise_std);
+        metrics{chunk} = score_chunk(motion, correction, lost, settle_cycles);
+    end
+    metrics         = vertcat(metrics{:});
+
+    %% Merge and sort
+    results         = params;
+    for idx = 1:numel(results)
+        results(idx).rms_xy         = metrics(idx, 1);
+        results(idx).rms_z          = metrics(idx, 2);
+        results(idx).lost_fraction  = metrics(idx, 3);
+        results(idx).score          = metrics(idx, 4);
+    end
+    [~, order]      = sort(metrics(:, 4));
+    results         = results(order);
+    best            = results(1);
+end
+
+function metrics = score_chunk(motion, correction, lost, settle_cycles)
+    %% [N x 4] rms_xy, rms_z, lost_fraction and score of each combination
+    applied     = [zeros(1, 3, size(correction, 3)); correction(1:end-1, :, :)];
+    applied(isnan(applied)) = 0; % No Z correction without Z lines
+    residual    = motion - applied;
+    residual(lost(:, [1, 1, 2], :)) = NaN;
+    residual    = residual(settle_cycles + 1:end, :, :);
+    rms_xy      = sqrt(squeeze(mean(mean(residual(:, 1:2, :).^2, 1, 'omitnan'), 2, 'omitnan')));
+    rms_z       = sqrt(squeeze(mean(residual(:, 3, :).^2, 1, 'omitnan')));
+    lost_frac   = squeeze(mean(any(lost(settle_cycles + 1:end, :, :), 2), 1));
+    score       = (rms_xy + rms_z) .* (1 + 10 * lost_frac);
+    metrics     = [rms_xy(:), rms_z(:), lost_frac(:), score(:)];
+end
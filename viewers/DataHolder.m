@@ -5,7 +5,7 @@
 % the function inputs and outputs.
 % -------------------------------------------------------------------------
 % Syntax: 
-%   this = DataHolder(size, repeats);
+%   this = DataHolder(size, repeats, reduction_method);
 % -------------------------------------------------------------------------
 % Class Generation Inputs:
 %   size (INT) - Optional - default is 1.
@@ -16,6 +16,11 @@
 %   repeats (INT) - Optional - default is 0
 %       The expected number of time the scan will be repeated (use 0 
 %       for a single trial)
+%
+%   reduction_method (STR) - Optional - any in {'none','mean','max','min',
+%           'median','var'} - default is 'none'
+%       If not 'none', cycles are reduced online as they complete, and
+%       only one cycle is held in memory. See FrameReducer.
 % -------------------------------------------------------------------------
 % Outputs: 
 %   this (DataHolder object)
@@ -31,11 +36,18 @@
 %   trials.
 %   data = DataHolder.reshape_and_average()
 %
+% * Get the online reduction of all completed cycles
+%   data = DataHolder.get_reduced_data()
+%
 % * Reset DataHolder buffer.
 %   DataHolder.reset()
 %
 % -------------------------------------------------------------------------
 % Extra Notes:
+% * With a reduction_method, DataHolder.data0 and DataHolder.data1 only
+%   contain the cycle currently being acquired. Every time a cycle is 
+%   complete, it is pushed to DataHolder.reducer0 / reducer1, so the
+%   reduced frame is available as soon as the last cycle lands.
 % -------------------------------------------------------------------------
 % Examples:
 % -------------------------------------------------------------------------
@@ -85,14 +97,18 @@ classdef DataHolder < BaseViewer
         data_size = 0;          % The expected number of points in each cycle 
         refresh_limit = 0;      % No averages in this mode
         type = 'data_holder';   % The viewer type, as read in the BaseViewer superclass
+        reduction_method = 'none'; % If not 'none', cycles are reduced online. Any in {'none','mean','max','min','median','var'}
+        cycle_points = 0;       % The number of points in one cycle
+        reducer0 = [];          % FrameReducer for channel 1, if reduction_method is not 'none'
+        reducer1 = [];          % FrameReducer for channel 2, if reduction_method is not 'none'
     end
 
     methods
-        function this = DataHolder(size, repeats)
+        function this = DataHolder(size, repeats, reduction_method)
             %% DataHolder Object Constructor
             % -------------------------------------------------------------
             % Syntax: 
-            %   this = DataHolder(size, repeats);
+            %   this = DataHolder(size, repeats, reduction_method);
             % -------------------------------------------------------------
             % Inputs:    
             %   size (INT) - Optional - default is 1.
@@ -104,6 +120,11 @@ classdef DataHolder < BaseViewer
             %   repeats (INT) - Optional - default is 0
             %       The expected number of time the scan will be repeated 
             %       (use 0 for a single trial)
+            %
+            %   reduction_method (STR) - Optional - any in {'none','mean',
+            %           'max','min','median','var'} - default is 'none'
+            %       If not 'none', cycles are reduced online as they
+            %       complete, and only one cycle is held in memory.
             % -------------------------------------------------------------
             % Outputs: 
             %   this (DataHolder object)
@@ -112,13 +133,15 @@ classdef DataHolder < BaseViewer
             % -------------------------------------------------------------
             % Extra Notes:
             %   Data type is UINT16. Data is stored in a linear array, but
-            %   can be reshaped with DataHolder.reshape_and_average()
+            %   can be reshaped with DataHolder.reshape_and_average(). If
+            %   there is a reduction_method, use 
+            %   DataHolder.get_reduced_data() instead.
             % -------------------------------------------------------------
             % Author(s):
             %   Antoine Valera
             % ---------------------------------------------
             % Revision Date:
-            %   16-07-2018
+            %   18-10-2026
             
             if nargin < 1 || isempty(size)
                 size = 1;
@@ -126,11 +149,23 @@ classdef DataHolder < BaseViewer
             if nargin < 2 || isempty(repeats)
                 repeats = 0;
             end
+            if nargin < 3 || isempty(reduction_method)
+                reduction_method = 'none';
+            end
             
             this.repeats = repeats;
             this.data_size = size;
-            this.data0 = zeros(sum(prod(this.data_size,2)) * this.repeats, 1, 'uint16');
-            this.data1 = zeros(sum(prod(this.data_size,2)) * this.repeats, 1, 'uint16');
+            this.cycle_points = sum(prod(this.data_size,2));
+            this.reduction_method = reduction_method;
+            if strcmp(this.reduction_method, 'none')
+                this.data0 = zeros(this.cycle_points * this.repeats, 1, 'uint16');
+                this.data1 = zeros(this.cycle_points * this.repeats, 1, 'uint16');
+            else
+                this.data0 = zeros(this.cycle_points, 1, 'uint16'); % Only the current cycle is kept
+                this.data1 = zeros(this.cycle_points, 1, 'uint16');
+                this.reducer0 = FrameReducer(this.reduction_method, this.cycle_points);
+                this.reducer1 = FrameReducer(this.reduction_method, this.cycle_points);
+            end
             this.zeroed_frame = this.data0;
             this.type = 'data_holder';
         end
@@ -152,11 +187,24 @@ classdef DataHolder < BaseViewer
             % -------------------------------------------------------------
             % Outputs: 
             % -------------------------------------------------------------
+            % Extra Notes:
+            %   If there is a reduction_method, data is written in a
+            %   single cycle buffer, and each completed cycle is pushed to
+            %   the channel FrameReducer.
+            % -------------------------------------------------------------
             % Author(s):
             %   Antoine Valera
             % ---------------------------------------------
             % Revision Date:
-            %   16-07-2018
+            %   18-10-2026
+            
+            if ~strcmp(this.reduction_method, 'none')
+                this.counter_ch1_post = this.reduce_new_data(new_data0, 'data0', this.reducer0, this.counter_ch1_pre);
+                this.counter_ch1_pre = this.counter_ch1_post;
+                this.counter_ch2_post = this.reduce_new_data(new_data1, 'data1', this.reducer1, this.counter_ch2_pre);
+                this.counter_ch2_pre = this.counter_ch2_post;
+                return
+            end
             
             if ~isempty(new_data0)
                 ndata1 = size(new_data0,1);
@@ -181,39 +229,75 @@ classdef DataHolder < BaseViewer
             %% Average all recorded trials 
             % -------------------------------------------------------------
             % Syntax: 
-            %   data = DataHolder.update(new_data0, new_data1)  
+            %   data = DataHolder.reshape_and_average()  
             % -------------------------------------------------------------
             % Inputs:    
-            %   new_data0 (1 x N INT)
-            %       The new data to be added in data0 channel.
-            %       DataHolder.counter_ch1_pre/post are updated accordingly
-            %
-            %   new_data1 (1 x N INT)
-            %       The new data to be added in data1 channel.
-            %       DataHolder.counter_ch2_pre/post are updated accordingly
             % -------------------------------------------------------------
             % Outputs: 
             %   data ([DataHolder.data_size * 2] INT)
             %       The data reshaped as specified in DataHolder.data_size,
             %       for each channel, and averaged across repeats.
             % -------------------------------------------------------------
+            % Extra Notes:
+            %   If DataHolder.data_size is a list of lines (one row per
+            %   line, as generated by initialise_timed_image), the output
+            %   is a column of concatenated lines. If there was an online
+            %   reduction, the reduced data is returned instead.
+            % -------------------------------------------------------------
             % Author(s):
             %   Antoine Valera
             % ---------------------------------------------
             % Revision Date:
-            %   16-07-2018
+            %   18-10-2026
             
-            if ndims(this.data_size) == 2 && size(a,2) == 1
-                dimensions = 1;
+            if ~strcmp(this.reduction_method, 'none')
+                data = this.get_reduced_data();
+                return
+            end
+            
+            if isrow(this.data_size)
+                frame_size = this.data_size;
             else
-                dimensions = ndims(this.data_size);
+                frame_size = this.cycle_points;
             end
+            dimensions = numel(frame_size);
             
-            this.data0 = mean(reshape(this.data0, this.data_size, []), dimensions+1);
-            this.data1 = mean(reshape(this.data1, this.data_size, []), dimensions+1);
+            this.data0 = mean(reshape(this.data0, [frame_size, numel(this.data0) / this.cycle_points]), dimensions+1);
+            this.data1 = mean(reshape(this.data1, [frame_size, numel(this.data1) / this.cycle_points]), dimensions+1);
             data = cat(dimensions+1, this.data0, this.data1);
         end
         
+        function data = get_reduced_data(this)
+            %% Get the online reduction of all completed cycles
+            % -------------------------------------------------------------
+            % Syntax: 
+            %   data = DataHolder.get_reduced_data()  
+            % -------------------------------------------------------------
+            % Inputs:    
+            % -------------------------------------------------------------
+            % Outputs: 
+            %   data ([DataHolder.cycle_points x 2] SINGLE)
+            %       The reduction of all completed cycles, one column per
+            %       channel. Incomplete cycles are ignored.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            
+            if strcmp(this.reduction_method, 'none')
+                error('No online reduction for this DataHolder. Use DataHolder.reshape_and_average() instead')
+            end
+            data = zeros(this.cycle_points, 2, 'single');
+            if this.reducer0.n_cycles
+                data(:,1) = this.reducer0.get_result();
+            end
+            if this.reducer1.n_cycles
+                data(:,2) = this.reducer1.get_result();
+            end
+        end
+        
         function reset(this)
             %% Reset DataHolder buffer.
             % -------------------------------------------------------------
@@ -236,6 +320,10 @@ classdef DataHolder < BaseViewer
             this.counter_ch1_post = 0; 
             this.counter_ch2_pre = 0;
             this.counter_ch2_post = 0; 
+            if ~strcmp(this.reduction_method, 'none')
+                this.reducer0.reset();
+                this.reducer1.reset();
+            end
         end
         
         function remove_trailing_zeros(this)
@@ -258,10 +346,34 @@ classdef DataHolder < BaseViewer
             % Revision Date:
             %   16-07-2018
             
-            this.data0 = this.data0(1:this.counter_ch1_post);
-            this.data1 = this.data1(1:this.counter_ch2_post);
+            if strcmp(this.reduction_method, 'none') % Reduced holders only keep one cycle
+                this.data0 = this.data0(1:this.counter_ch1_post);
+                this.data1 = this.data1(1:this.counter_ch2_post);
+            end
         end 
         
     end
+    
+    methods (Access = private)
+        function counter = reduce_new_data(this, new_data, field, reducer, counter)
+            %% Write new data in the cycle buffer, reduce each completed cycle
+            % counter is the total number of points received on this
+            % channel, so the position in the current cycle is 
+            % mod(counter, this.cycle_points). A single FIFO read can 
+            % complete zero, one or several cycles.
+            n_new = numel(new_data);
+            offset = 0;
+            while offset < n_new
+                position = mod(counter, this.cycle_points);
+                n_copy = min(n_new - offset, this.cycle_points - position);
+                this.(field)(position + 1:position + n_copy) = new_data(offset + 1:offset + n_copy);
+                offset = offset + n_copy;
+                counter = counter + n_copy;
+                if ~mod(counter, this.cycle_points)
+                    reducer.add(this.(field));
+                end
+            end
+        end
+    end
 end
 
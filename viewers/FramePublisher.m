@@ -0,0 +1,287 @@
+%% Publish live frames and raw channel blocks in shared memory
+% Completed frames (from LiveViewer) and raw FIFO blocks (from
+% data_acquisition) are copied into a named shared memory ring, so that
+% other processes (C++, Python, another MATLAB session...) can read them
+% at their own pace, without going through the acquisition loop.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = FramePublisher(name, scan_params, n_slots, slot_bytes);
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   name (STR) - Optional - default is 'silverlab_live'
+%       The name of the shared memory. Readers must use the same name.
+%
+%   scan_params (ScanParams object) - Optional - default is []
+%       The current scan settings. imaging_mode, num_drives and
+%       num_voxels are written in the header of each item.
+%
+%   n_slots (INT) - Optional - default is 4
+%       The number of items kept in the ring.
+%
+%   slot_bytes (INT) - Optional - default is 2048 * 2048 * 3 * 2
+%       The max size of one item. Larger items are not published.
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (FramePublisher object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Update the geometry written in item headers
+%   FramePublisher.set_geometry(scan_params)
+%
+% * Publish a completed frame
+%   FramePublisher.publish_frame(frame)
+%
+% * Publish a raw FIFO block
+%   FramePublisher.publish_block(data0, data1)
+%
+% * Read the latest item of a ring, from any session (static)
+%   [header, data] = FramePublisher.read_latest(name)
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * The publisher requires frame_publisher.mex, see
+%   viewers/frame_publisher_mex/compile_frame_publisher.m. The memory
+%   layout and the (lock free) reading protocol are described in
+%   viewers/frame_publisher_mex/frame_ring.h
+%
+% * Each FramePublisher opens its own ring, and deleting it only closes
+%   that ring. Two publishers in the same session must use different
+%   names.
+%
+% * Publishing is a single memcpy per item. The writer never waits for
+%   the readers. Slow readers skip items, which they can detect with
+%   header.item_id.
+%
+% * Attach the publisher to the viewer for frames, and to the DaqFpga for
+%   raw blocks. create_viewer keeps the publisher when the viewer is
+%   regenerated.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Publish frames and raw data of the live acquisition
+%   publisher = FramePublisher('silverlab_live', controller.scan_params);
+%   controller.viewer.publisher = publisher;
+%   controller.daq_fpga.publisher = publisher;
+%
+% * Read the last item from another MATLAB session
+%   [header, data] = FramePublisher.read_latest('silverlab_live');
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also
+%   LiveViewer, data_acquisition, create_viewer
+
+classdef FramePublisher < handle
+    properties
+        name            = 'silverlab_live'; % Shared memory name
+        n_slots         = 4;                % Number of items in the ring
+        slot_bytes      = 2048*2048*3*2;    % Max size of one item, in bytes
+        geometry        = [0, 0, 0];        % [imaging_mode, num_drives, num_voxels] written in each item header
+        frame_id        = 0;                % Number of frames published
+        block_id        = 0;                % Number of raw blocks published
+        n_dropped       = 0;                % Number of items too large to be published
+    end
+
+    properties (SetAccess = private)
+        handle          = [];               % Handle of the ring opened by this publisher, see frame_publisher.c
+    end
+
+    properties (Constant)
+        KIND_FRAME      = 0; % See frame_ring.h
+        KIND_BLOCK      = 1;
+    end
+
+    methods
+        function this = FramePublisher(name, scan_params, n_slots, slot_bytes)
+            %% FramePublisher Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = FramePublisher(name, scan_params, n_slots, slot_bytes);
+            % -------------------------------------------------------------
+            % Inputs:
+            %   name (STR) - Optional - default is 'silverlab_live'
+            %       The name of the shared memory.
+            %
+            %   scan_params (ScanParams object) - Optional - default is []
+            %       The current scan settings
+            %
+            %   n_slots (INT) - Optional - default is 4
+            %       The number of items kept in the ring.
+            %
+            %   slot_bytes (INT) - Optional - default is 2048*2048*3*2
+            %       The max size of one item.
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (FramePublisher object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin >= 1 && ~isempty(name)
+                this.name = name;
+            end
+            if nargin >= 2 && ~isempty(scan_params)
+                this.set_geometry(scan_params);
+            end
+            if nargin >= 3 && ~isempty(n_slots)
+                this.n_slots = n_slots;
+            end
+            if nargin >= 4 && ~isempty(slot_bytes)
+                this.slot_bytes = slot_bytes;
+            end
+            if ~exist('frame_publisher', 'file')
+                error('frame_publisher mex file not found. Run viewers/frame_publisher_mex/compile_frame_publisher.m')
+            end
+
+            this.handle = frame_publisher('open', this.name, this.n_slots, this.slot_bytes);
+        end
+
+        function delete(this)
+            %% FramePublisher Object Destructor. Release this ring only
+            if ~isempty(this.handle) && exist('frame_publisher', 'file')
+                frame_publisher('close', this.handle);
+                this.handle = [];
+            end
+        end
+
+        function set_geometry(this, scan_params)
+            %% Update the geometry written in item headers
+            % -------------------------------------------------------------
+            % Syntax:
+            %   FramePublisher.set_geometry(scan_params)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   scan_params (ScanParams object)
+            %       The current scan settings
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            this.geometry = double([uint32(scan_params.imaging_mode), scan_params.num_drives, scan_params.num_voxels]);
+        end
+
+        function publish_frame(this, frame)
+            %% Publish a completed frame
+            % -------------------------------------------------------------
+            % Syntax:
+            %   FramePublisher.publish_frame(frame)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   frame ([X x Y x C] NUMERIC)
+            %       The frame. Numeric classes are published as is.
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            this.frame_id = this.frame_id + 1;
+            if ~frame_publisher('publish', this.handle, this.KIND_FRAME, this.frame_id, this.geometry, frame)
+                this.n_dropped = this.n_dropped + 1;
+            end
+        end
+
+        function publish_block(this, data0, data1)
+            %% Publish a raw FIFO block
+            % -------------------------------------------------------------
+            % Syntax:
+            %   FramePublisher.publish_block(data0, data1)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   data0 ([N x 1] or [1 x N] UINT16)
+            %       Channel 1 data
+            %
+            %   data1 ([N x 1] or [1 x N] UINT16)
+            %       Channel 2 data. Must be the same class as data0.
+            %       Channels are cropped to the shortest one.
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if isempty(data0)
+                return
+            end
+            this.block_id = this.block_id + 1;
+            if ~frame_publisher('publish', this.handle, this.KIND_BLOCK, this.block_id, this.geometry, data0, data1)
+                this.n_dropped = this.n_dropped + 1;
+            end
+        end
+    end
+
+    methods (Static)
+        function [header, data] = read_latest(name)
+            %% Read the latest item of a ring, from any session
+            % -------------------------------------------------------------
+            % Syntax:
+            %   [header, data] = FramePublisher.read_latest(name)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   name (STR) - Optional - default is 'silverlab_live'
+            %       The name of the shared memory.
+            % -------------------------------------------------------------
+            % Outputs:
+            %   header (STRUCT)
+            %       item_id, timestamp (POSIX time), kind, dims,
+            %       imaging_mode, num_drives, num_voxels and write_count.
+            %       Empty fields if nothing was published yet.
+            %
+            %   data (NUMERIC)
+            %       The item, with its original class and dimensions.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 1 || isempty(name)
+                name = 'silverlab_live';
+            end
+            [header, data] = frame_publisher('read', name);
+        end
+    end
+end
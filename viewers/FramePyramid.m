@@ -0,0 +1,262 @@
+%% Multi-resolution (mip) pyramid of a live frame
+% Maintain 2x2 box-filtered copies of a frame, so that displays and remote
+% viewers can use the resolution that matches their window size instead of
+% the full resolution frame.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = FramePyramid(frame_size, n_levels);
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   frame_size ([1 x 2] or [1 x 3] INT)
+%       The size of the full resolution frame, [x, y] or [x, y, channels].
+%
+%   n_levels (INT) - Optional - default is FramePyramid.default_levels()
+%       The number of downsampled levels. Level n is 2^n times smaller
+%       than the full resolution frame (level 0) in each dimension.
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (FramePyramid object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Update the pyramid for lines (2nd dimension) of the frame that changed
+%   FramePyramid.update_lines(frame, lines)
+%
+% * Get the frame at a given level
+%   img = FramePyramid.get_level(level)
+%
+% * Get the level that best matches a window size
+%   level = FramePyramid.level_for_window(window_size)
+%
+% * Reduce any array n times in its first 2 dimensions (static)
+%   img = FramePyramid.downsample(img, n)
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * Level 0 is the full resolution frame itself. It is not copied in the
+%   pyramid.
+%
+% * Odd sizes are handled by replicating the last row/column, so level n
+%   has ceil(size / 2^n) pixels.
+%
+% * update_lines() only recomputes the columns covering the updated lines
+%   at each level, so the cost of a partial update is proportional to the
+%   number of updated lines.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Get a 256 x 256 preview of a 2048 x 2048 frame
+%   pyramid = FramePyramid([2048, 2048], 3);
+%   pyramid.update_lines(frame);
+%   preview = pyramid.get_level(3);
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also
+%   LiveViewer, show_stack
+
+classdef FramePyramid < handle
+    properties
+        frame_size              = [];   % [x, y, channels] of the full resolution frame
+        n_levels                = 0;    % Number of downsampled levels
+        levels                  = {};   % {1 x n_levels} SINGLE. levels{n} is 2^n smaller than the frame
+    end
+
+    methods
+        function this = FramePyramid(frame_size, n_levels)
+            %% FramePyramid Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = FramePyramid(frame_size, n_levels);
+            % -------------------------------------------------------------
+            % Inputs:
+            %   frame_size ([1 x 2] or [1 x 3] INT)
+            %       The size of the full resolution frame
+            %
+            %   n_levels (INT) - Optional - default is
+            %           FramePyramid.default_levels(frame_size)
+            %       The number of downsampled levels.
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (FramePyramid object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if numel(frame_size) < 3
+                frame_size(3) = 1;
+            end
+            if nargin < 2 || isempty(n_levels)
+                n_levels = FramePyramid.default_levels(frame_size);
+            end
+
+            this.frame_size = frame_size(1:3);
+            this.n_levels   = n_levels;
+            this.levels     = cell(1, n_levels);
+            for level = 1:n_levels
+                this.levels{level} = zeros([ceil(this.frame_size(1:2) / 2^level), this.frame_size(3)], 'single');
+            end
+        end
+
+        function update_lines(this, frame, lines)
+            %% Update the pyramid for lines of the frame that changed
+            % -------------------------------------------------------------
+            % Syntax:
+            %   FramePyramid.update_lines(frame, lines)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   frame ([X x Y x C] NUMERIC)
+            %       The full resolution frame
+            %
+            %   lines ([1 x N] INT) - Optional - default is 1:Y
+            %       The indexes (along the 2nd dimension) of the lines that
+            %       changed since the last update.
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 3 || isempty(lines)
+                lines = 1:this.frame_size(2);
+            end
+
+            parent = frame;
+            for level = 1:this.n_levels
+                %% Columns of this level covering the changed lines
+                lines = unique(ceil(double(lines(:)') / 2));
+                this.levels{level}(:, lines, :) = FramePyramid.reduce_columns(parent, lines);
+                parent = this.levels{level};
+            end
+        end
+
+        function img = get_level(this, level, frame)
+            %% Get the frame at a given level
+            % -------------------------------------------------------------
+            % Syntax:
+            %   img = FramePyramid.get_level(level, frame)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   level (INT)
+            %       The level to return, between 0 and n_levels
+            %
+            %   frame ([X x Y x C] NUMERIC) - Optional
+            %       The full resolution frame, returned for level 0
+            % -------------------------------------------------------------
+            % Outputs:
+            %   img ([ceil(X/2^level) x ceil(Y/2^level) x C] SINGLE)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            level = min(max(0, round(level)), this.n_levels);
+            if level
+                img = this.levels{level};
+            elseif nargin > 2
+                img = frame;
+            else
+                error('Level 0 is the full resolution frame, which is not stored in the pyramid')
+            end
+        end
+
+        function level = level_for_window(this, window_size)
+            %% Get the smallest level that still fills a window
+            % -------------------------------------------------------------
+            % Syntax:
+            %   level = FramePyramid.level_for_window(window_size)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   window_size ([1 x 2] INT)
+            %       The window size in screen pixels, in the frame
+            %       dimensions order ([X, Y]).
+            % -------------------------------------------------------------
+            % Outputs:
+            %   level (INT)
+            %       The highest level for which the image has at least as
+            %       many pixels as the window in both dimensions.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            level = FramePyramid.get_window_level(this.frame_size, window_size);
+            level = min(level, this.n_levels);
+        end
+    end
+
+    methods (Static)
+        function n_levels = default_levels(frame_size)
+            %% Number of levels to get down to ~256 pixels
+            n_levels = max(0, nextpow2(max(frame_size(1:2))) - 8);
+        end
+
+        function level = get_window_level(frame_size, window_size)
+            %% Level matching a window size, without pyramid object
+            window_size = max(1, window_size(1:2));
+            level = max(0, floor(log2(min(frame_size(1:2) ./ window_size))));
+        end
+
+        function img = downsample(img, n)
+            %% Apply n 2x2 box filters on the first 2 dimensions of img
+            % Trailing dimensions (channels, planes, timepoints) are
+            % processed at once.
+            img = single(img);
+            for level = 1:n
+                img = FramePyramid.reduce_columns(img, 1:ceil(size(img, 2) / 2));
+            end
+        end
+    end
+
+    methods (Static, Access = private)
+        function out = reduce_columns(parent, cols)
+            %% 2x2 box filter, for a subset of output columns
+            sz          = size(parent);
+            sz(end+1:3) = 1;
+            parent      = reshape(parent, sz(1), sz(2), []);
+            rows        = 1:ceil(sz(1) / 2);
+            out         =   single(parent(2*rows - 1, 2*cols - 1, :)) ...
+                          + single(parent(min(2*rows, sz(1)), 2*cols - 1, :)) ...
+                          + single(parent(2*rows - 1, min(2*cols, sz(2)), :)) ...
+                          + single(parent(min(2*rows, sz(1)), min(2*cols, sz(2)), :));
+            out         = reshape(out / 4, [numel(rows), numel(cols), sz(3:end)]);
+        end
+    end
+end
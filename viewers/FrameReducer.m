@@ -0,0 +1,323 @@
+%% Online reduction of successive cycles into a single frame
+% Accumulate cycles one at a time and keep only the reduced result (plus a
+% few frames of state), instead of holding every cycle in memory.
+%
+% Type doc function_name or help function_name to get more details about
+% the function inputs and outputs.
+% -------------------------------------------------------------------------
+% Syntax:
+%   this = FrameReducer(method, n_points);
+% -------------------------------------------------------------------------
+% Class Generation Inputs:
+%   method (STR) - Optional - any in {'mean','max','min','median','var'}
+%           - default is 'mean'
+%       The reduction applied across cycles.
+%
+%   n_points (INT) - Optional - default is 1.
+%       The number of points in one cycle. This is used for memory
+%       preallocation.
+% -------------------------------------------------------------------------
+% Outputs:
+%   this (FrameReducer object)
+% -------------------------------------------------------------------------
+% Class Methods:
+%
+% * Add one complete cycle to the running reduction
+%   FrameReducer.add(cycle)
+%
+% * Get the current reduced frame
+%   result = FrameReducer.get_result()
+%
+% * Clear accumulated cycles
+%   FrameReducer.reset()
+% -------------------------------------------------------------------------
+% Extra Notes:
+% * 'mean' and 'var' use Welford's running update, 'max' and 'min' a
+%   running element-wise comparison. Results match mean(), var(), max()
+%   and min() along the cycle dimension.
+%
+% * 'median' is exact up to FrameReducer.median_buffer_depth cycles
+%   (default 5). Above that, the buffer is used to seed a per-pixel P^2
+%   estimator (Jain & Chlamtac, 1985), which tracks the median with 5
+%   markers per pixel whatever the number of cycles. The result is then an
+%   approximation, so Controller.single_record only reduces the methods
+%   listed in FrameReducer.EXACT_METHODS online.
+%
+% * All per-pixel operations are vectorised across the frame. Memory cost
+%   is 1 frame for mean/max/min, 2 for var and 10 for median.
+% -------------------------------------------------------------------------
+% Examples:
+%
+% * Average 100 cycles of 512 x 512 pixels
+%   reducer = FrameReducer('mean', 512*512);
+%   for cycle = 1:100
+%       reducer.add(uint16(randi(2^16-1, 512*512, 1)));
+%   end
+%   frame = reshape(reducer.get_result(), 512, 512);
+% -------------------------------------------------------------------------
+%                               Notice
+%
+% Author(s): Antoine Valera
+%
+% This function was initially released as part of The SilverLab MatLab
+% Imaging Software, an open-source application for controlling an
+% Acousto-Optic Lens laser scanning microscope. The software was
+% developed in the laboratory of Prof Robin Angus Silver at University
+% College London with funds from the NIH, ERC and Wellcome Trust.
+%
+% Copyright  2015-2020 University College London
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+% -------------------------------------------------------------------------
+% Revision Date:
+%   18-10-2026
+%
+% See also
+%   DataHolder, imaging.single_record
+
+classdef FrameReducer < handle
+    properties
+        method                  = 'mean';   % The reduction method, any in {'mean','max','min','median','var'}
+        n_points                = 1;        % The number of points per cycle
+        n_cycles                = 0;        % The number of cycles reduced so far
+        median_buffer_depth     = 5;        % Number of cycles for which the median is exact. Must be >= 5 (P^2 initialisation)
+        result                  = [];       % Running mean/max/min. Unused for median
+        m2                      = [];       % Running sum of squared differences (for 'var')
+        buffer                  = [];       % First cycles, for exact median and P^2 initialisation
+        markers                 = [];       % P^2 marker heights ([n_points x 5] SINGLE)
+        positions               = [];       % P^2 marker positions ([n_points x 5] SINGLE)
+        desired                 = [];       % P^2 desired marker positions ([1 x 5] DOUBLE)
+    end
+
+    properties (Constant)
+        EXACT_METHODS           = {'mean','max','min','var'}; % Methods giving the same result as the offline reduction
+        P2_INCREMENTS           = [0, 0.25, 0.5, 0.75, 1]; % Desired position increments for p = 0.5
+    end
+
+    methods
+        function this = FrameReducer(method, n_points)
+            %% FrameReducer Object Constructor
+            % -------------------------------------------------------------
+            % Syntax:
+            %   this = FrameReducer(method, n_points);
+            % -------------------------------------------------------------
+            % Inputs:
+            %   method (STR) - Optional - any in {'mean','max','min',
+            %           'median','var'} - default is 'mean'
+            %       The reduction applied across cycles.
+            %
+            %   n_points (INT) - Optional - default is 1.
+            %       The number of points in one cycle.
+            % -------------------------------------------------------------
+            % Outputs:
+            %   this (FrameReducer object)
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if nargin < 1 || isempty(method)
+                method = 'mean';
+            end
+            if nargin < 2 || isempty(n_points)
+                n_points = 1;
+            end
+            if ~any(strcmp(method, {'mean','max','min','median','var'}))
+                error('Online reduction method must be any in {''mean'',''max'',''min'',''median'',''var''}')
+            end
+
+            this.method     = method;
+            this.n_points   = n_points;
+            this.reset();
+        end
+
+        function add(this, cycle)
+            %% Add one complete cycle to the running reduction
+            % -------------------------------------------------------------
+            % Syntax:
+            %   FrameReducer.add(cycle)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   cycle ([N x 1] NUMERIC)
+            %       One full cycle, where N is FrameReducer.n_points
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            cycle           = single(cycle(:));
+            this.n_cycles   = this.n_cycles + 1;
+            switch this.method
+                case 'mean'
+                    this.result = this.result + (cycle - this.result) / this.n_cycles;
+                case 'var'
+                    delta       = cycle - this.result;
+                    this.result = this.result + delta / this.n_cycles;
+                    this.m2     = this.m2 + delta .* (cycle - this.result);
+                case 'max'
+                    if this.n_cycles == 1
+                        this.result = cycle;
+                    else
+                        this.result = max(this.result, cycle);
+                    end
+                case 'min'
+                    if this.n_cycles == 1
+                        this.result = cycle;
+                    else
+                        this.result = min(this.result, cycle);
+                    end
+                case 'median'
+                    this.add_median(cycle);
+            end
+        end
+
+        function result = get_result(this)
+            %% Get the current reduced frame
+            % -------------------------------------------------------------
+            % Syntax:
+            %   result = FrameReducer.get_result()
+            % -------------------------------------------------------------
+            % Inputs:
+            % -------------------------------------------------------------
+            % Outputs:
+            %   result ([N x 1] SINGLE)
+            %       The reduction of all the cycles added since the last
+            %       reset. Empty if no cycle was added.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            if ~this.n_cycles
+                result = [];
+            elseif strcmp(this.method, 'var')
+                result = this.m2 / max(1, this.n_cycles - 1);
+            elseif strcmp(this.method, 'median') && this.n_cycles <= this.median_buffer_depth
+                result = median(this.buffer(:, 1:this.n_cycles), 2);
+            elseif strcmp(this.method, 'median')
+                result = this.markers(:, 3);
+            else
+                result = this.result;
+            end
+        end
+
+        function reset(this)
+            %% Clear accumulated cycles
+            % -------------------------------------------------------------
+            % Syntax:
+            %   FrameReducer.reset()
+            % -------------------------------------------------------------
+            % Inputs:
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            % ---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+
+            this.n_cycles = 0;
+            this.median_buffer_depth = max(5, this.median_buffer_depth);
+            if strcmp(this.method, 'median')
+                this.buffer     = zeros(this.n_points, this.median_buffer_depth, 'single');
+                this.markers    = [];
+                this.positions  = [];
+                this.result     = [];
+            else
+                this.result     = zeros(this.n_points, 1, 'single');
+            end
+            if strcmp(this.method, 'var')
+                this.m2         = zeros(this.n_points, 1, 'single');
+            end
+        end
+    end
+
+    methods (Access = private)
+        function add_median(this, cycle)
+            %% Exact median buffer, then per-pixel P^2 median estimator
+            if this.n_cycles <= this.median_buffer_depth
+                this.buffer(:, this.n_cycles) = cycle;
+                return
+            elseif isempty(this.markers)
+                %% Seed the 5 markers with the first 5 buffered cycles
+                this.markers    = sort(this.buffer(:, 1:5), 2);
+                this.positions  = repmat(single(1:5), this.n_points, 1);
+                this.desired    = 1:5;
+                for n = 6:this.median_buffer_depth
+                    this.update_markers(this.buffer(:, n));
+                end
+                this.buffer     = [];
+            end
+            this.update_markers(cycle);
+        end
+
+        function update_markers(this, x)
+            %% One P^2 step, vectorised across all pixels
+            q = this.markers;
+            n = this.positions;
+
+            %% Extend extreme markers and find the cell containing x
+            low         = x < q(:,1);
+            q(low,1)    = x(low);
+            high        = x >= q(:,5);
+            q(high,5)   = x(high);
+            k           = 1 + sum(x >= q(:,2:4), 2);        % 1 to 4
+
+            %% Shift positions of markers above x, and desired positions
+            n           = n + single(bsxfun(@gt, 1:5, k));
+            this.desired = this.desired + this.P2_INCREMENTS;
+
+            %% Adjust central markers if they drifted from their desired position
+            for i = 2:4
+                d       = this.desired(i) - n(:,i);
+                up      = d >= 1  & (n(:,i+1) - n(:,i)) > 1;
+                down    = d <= -1 & (n(:,i-1) - n(:,i)) < -1;
+                idx     = find(up | down);
+                if isempty(idx)
+                    continue
+                end
+                s       = single(up(idx)) - single(down(idx));
+                qi = q(idx,i);   qp = q(idx,i+1); qm = q(idx,i-1);
+                ni = n(idx,i);   np = n(idx,i+1); nm = n(idx,i-1);
+
+                %% Piecewise parabolic prediction
+                q_new   = qi + s ./ (np - nm) .* ((ni - nm + s) .* (qp - qi) ./ (np - ni) + ...
+                                                  (np - ni - s) .* (qi - qm) ./ (ni - nm));
+
+                %% Linear prediction where the parabola is not monotonic
+                bad     = ~(qm < q_new & q_new < qp);
+                if any(bad)
+                    going_up    = s > 0;
+                    q_next      = qm;   q_next(going_up) = qp(going_up);
+                    n_next      = nm;   n_next(going_up) = np(going_up);
+                    q_lin       = qi + s .* (q_next - qi) ./ (n_next - ni);
+                    q_new(bad)  = q_lin(bad);
+                end
+                q(idx,i)  = q_new;
+                n(idx,i)  = ni + s;
+            end
+
+            this.markers    = q;
+            this.positions  = n;
+        end
+    end
+end
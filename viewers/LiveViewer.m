@@ -47,8 +47,23 @@
 % * Reset DataHolder buffer.
 %   LiveViewer.reset()
 %
+% * Display non-rectangular scans as a mosaic of patches
+%   LiveViewer.set_layout(layout)
+%
+% * Display a downsampled version of the frame
+%   LiveViewer.set_display_level(level)
+%
+% * Display the lines acquired since the last refresh
+%   LiveViewer.refresh_dirty_lines()
+%
 % -------------------------------------------------------------------------
 % Extra Notes:
+% * When there is no averaging, lines acquired within a frame are pushed
+%   to the display every 1/line_refresh_rate seconds, so slow scans are
+%   displayed progressively. Only the new lines are processed, using the
+%   contrast of the last full frame. Frames faster than line_refresh_rate
+%   are only refreshed once complete. Use line_refresh_rate = 0 to
+%   disable partial updates.
 % -------------------------------------------------------------------------
 % Examples:
 % -------------------------------------------------------------------------
@@ -105,7 +120,16 @@ classdef LiveViewer < viewer_params & BaseViewer
         holder0                 ;
         holder1                 ;
         num_pixels              ; % number of pixels per frame
+        frame_points            ; % number of points per cycle in the FIFO stream. Equals num_pixels unless there is a scatter_map
+        scatter_map     = []    ; % If not empty, frame pixel index of each stream point (see ScanLayout)
         data_size               ;
+        pyramid         = []    ; % FramePyramid, updated as lines are acquired if display_level ~= 0
+        publisher       = []    ; % FramePublisher. If not empty, every completed frame is published in shared memory
+        display_level   = 0     ; % 0 for full resolution, n for 2^n downsampling, -1 to match the axes size
+        display_scale   = []    ; % Red and green auto-contrast gains used for the last full frame. Seeded from the first partial refresh if empty
+        display_flat_field = [] ; % flat_field at the current display level, see get_display_flat_field()
+        line_refresh_rate = 10  ; % Max rate (Hz) of partial updates of the lines acquired since the last refresh. 0 to disable
+        dirty_lines             ; % [1 x y] BOOL. Lines written since the last refresh
         
         %% Image correction
         zeroed_frame            ;
@@ -126,6 +150,7 @@ classdef LiveViewer < viewer_params & BaseViewer
         %% Counter and timers
         timer1          = []    ;
         timer2          = []    ;
+        line_timer      = []    ; % Time of the last (full or partial) refresh
         current_frame   = -1    ; % frame counter
         
         preset_mode     = []    ; % Load a specific set of settings from viewer_params
@@ -167,11 +192,14 @@ classdef LiveViewer < viewer_params & BaseViewer
             
             %% Set Frame properties (and frames indexes)
             this.num_pixels = x * y;
+            this.frame_points = this.num_pixels;
             this.data_size  = [x,y];
             this.data       = zeros(x, y, 3, 'uint16'); 
             this.zeroed_frame = zeros(x, y, 3, 'single'); %this blank frame will not be modified and can be used for a faster reset
             this.idx0       = zeros(1,buffer_size(1),'uint32'); % supports up to 65536 * 65536 pixels frames...
             this.idx1       = zeros(1,buffer_size(2),'uint32');
+            this.dirty_lines = false(1, y);
+            this.line_timer = tic;
             
             %% Adjust frame rate and buffer size
             this.preset_mode = viewer_preset;
@@ -226,13 +254,13 @@ classdef LiveViewer < viewer_params & BaseViewer
             % should ideally be done at the end of the function, but it
             % would clear the data and prevent further access from another
             % function (through the CData field), which can be handy.
-            if max(this.idx0) == this.num_pixels && this.current_frame >= n_frame_limit && (n_frame_limit > 1 || strcmp(this.mode, 'frame_average') || strcmp(this.mode, 'time_average'))
+            if max(this.idx0) == this.frame_points && this.current_frame >= n_frame_limit && (n_frame_limit > 1 || strcmp(this.mode, 'frame_average') || strcmp(this.mode, 'time_average'))
                  this.data = this.zeroed_frame;
                  this.current_frame = 0;
             end
  
             %% Generate bar object if required
-            if this.intensity_bar && max(this.idx0) == this.num_pixels && this.current_frame >= n_frame_limit
+            if this.intensity_bar && max(this.idx0) == this.frame_points && this.current_frame >= n_frame_limit
                set(this.bar, 'YData', max([new_data0; new_data1])); hold on;
             end
             
@@ -246,34 +274,63 @@ classdef LiveViewer < viewer_params & BaseViewer
             end
 
             %% We update data indexes
-            this.idx0 = uint32(mod(this.next_elem0 - 1 + uint32(1:numel(new_data0)) - 1, this.num_pixels) + 1); 
-            this.idx1 = uint32(mod(this.next_elem1 - 1 + uint32(1:numel(new_data1)) - 1, this.num_pixels) + 1);
+            this.idx0 = uint32(mod(this.next_elem0 - 1 + uint32(1:numel(new_data0)) - 1, this.frame_points) + 1); 
+            this.idx1 = uint32(mod(this.next_elem1 - 1 + uint32(1:numel(new_data1)) - 1, this.frame_points) + 1);
             this.next_elem0 = this.idx0(end) + 1; % This is the the next pixel location in the frame
             this.next_elem1 = this.idx1(end) + 1;
+            
+            %% For non-rectangular scans, stream points are scattered in the mosaic
+            if isempty(this.scatter_map)
+                pix0 = this.idx0;
+                pix1 = this.idx1;
+            else
+                pix0 = this.scatter_map(this.idx0);
+                pix1 = this.scatter_map(this.idx1);
+            end
 
             %% We push the data at the right index location. If there is averaging, we add it to previous data
             if strcmp(this.mode, 'none') || ~n_frame_limit%no averaging 
-                this.data(this.idx0) = new_data0; %1 to this.num_pixels is red
-                this.data(this.idx1 + this.num_pixels) = new_data1; %(this.num_pixels + 1) to (this.num_pixels*2) is green
+                this.data(pix0) = new_data0; %1 to this.num_pixels is red
+                this.data(pix1 + this.num_pixels) = new_data1; %(this.num_pixels + 1) to (this.num_pixels*2) is green
                 %(this.num_pixels *2 + 1) to (this.num_pixels * 3) is blue
             elseif strcmp(this.mode, 'frame_average') || strcmp(this.mode, 'time_average')
                 if ~this.sliding
-                    this.data(this.idx0) = uint16(this.data(this.idx0)) + new_data0'/ n_frame_limit;
-                    this.data(this.idx1 + this.num_pixels) = uint16(this.data(this.idx1 + this.num_pixels)) + new_data1' / n_frame_limit;
+                    this.data(pix0) = uint16(this.data(pix0)) + new_data0'/ n_frame_limit;
+                    this.data(pix1 + this.num_pixels) = uint16(this.data(pix1 + this.num_pixels)) + new_data1' / n_frame_limit;
                 else
-                    this.holder0(this.idx0 + this.num_pixels * (this.current_frame)) = new_data0; %1 to this.num_pixels is red
-                    this.holder1(this.idx1 + this.num_pixels * (this.current_frame)) = new_data1; 
+                    this.holder0(pix0 + this.num_pixels * (this.current_frame)) = new_data0; %1 to this.num_pixels is red
+                    this.holder1(pix1 + this.num_pixels * (this.current_frame)) = new_data1; 
+                end
+            end
+            
+            %% Find the lines we just wrote, if the pyramid or the partial refresh need them
+            update_pyramid = ~isempty(this.pyramid) && ~this.sliding;
+            partial_refresh = this.line_refresh_rate && (strcmp(this.mode, 'none') || ~n_frame_limit) && ~this.rotate;
+            if update_pyramid || partial_refresh
+                written_lines = unique(ceil(double([pix0(:); pix1(:)]) / this.data_size(1)));
+            end
+            
+            %% Update the preview pyramid for these lines
+            if update_pyramid
+                this.pyramid.update_lines(this.data, written_lines);
+            end
+            
+            %% Without averaging, display new lines at a capped rate
+            if partial_refresh
+                this.dirty_lines(written_lines) = true;
+                if mod(max(this.idx0),this.frame_points) && toc(this.line_timer) > 1 / this.line_refresh_rate
+                    this.refresh_dirty_lines();
                 end
             end
             
             %% Every time we fill a frame, we increase the counter
-            if max(this.idx0) >= this.num_pixels
+            if max(this.idx0) >= this.frame_points
                 this.current_frame = this.current_frame + 1;
             end
             
             %% If we have a complete frame AND if we averaged enough frames or
             %% time, we display the result
-            if ~mod(max(this.idx0),this.num_pixels) && (this.current_frame >= n_frame_limit || this.sliding)
+            if ~mod(max(this.idx0),this.frame_points) && (this.current_frame >= n_frame_limit || this.sliding)
                 % We display a cross if wanted
                 this.add_cross(); 
 
@@ -282,44 +339,54 @@ classdef LiveViewer < viewer_params & BaseViewer
                     this.data(this.num_pixels+1:this.num_pixels*2)  =    mean(this.holder1,3);
                 end
                 
+                %% Publish the frame before any display processing
+                if ~isempty(this.publisher)
+                    this.publisher.publish_frame(this.data);
+                end
+                
+                %% Select the resolution to display. Full resolution frame is left untouched if we use the pyramid
+                if this.sliding && ~isempty(this.pyramid)
+                    this.pyramid.update_lines(this.data);
+                end
+                level = this.get_current_display_level();
+                if level
+                    frame = this.pyramid.get_level(level);
+                else
+                    frame = this.data;
+                end
+                this.dirty_lines(:) = false;
+                this.line_timer = tic;
+                
                 if this.flatten_field %achieved with (acquired image - background) / (flatfield image - background)
 %                     initial_max = single(max(this.data(:)));
-                    this.data = uint16(single(this.data) ./ (single(this.flat_field )));
+                    frame = uint16(single(frame) ./ this.get_display_flat_field(level));
                 end
 
                 
                 %% Rotate frame if required
                 if this.rotate
-                    this.data = rot90(this.data);
+                    frame = rot90(frame);
                 end
                                
                 %% Note because of an unidentified pb with fast viewer mode, the autocontrast is done only on 90% of the picture
-                this.data = single(this.data);
-                if this.auto_contrast_red
-                    initial_max = prctile(reshape(this.data(:,ceil(this.data_size(1)/5):end,1),[],1),this.autocontrast_thr);
-                    if initial_max > 2000 %qq  mitigates autocontrast issue
-                        initial_max = 2000;
-                    end
-                    this.data(:,:,1) = (2^16 * this.data(:,:,1) / (initial_max/this.red_contrast));
-                end
-                if this.auto_contrast_green
-                    initial_max = prctile(reshape(this.data(:,ceil(this.data_size(1)/5):end,2),[],1),this.autocontrast_thr);
-                    if initial_max > 2000 %qq  mitigates autocontrast issue
-                        initial_max = 2000;
-                    end
-                    this.data(:,:,2) = (2^16 * this.data(:,:,2) / (initial_max/this.green_contrast));
-                end
+                frame = single(frame);
+                this.display_scale = this.get_display_scale(frame(:,ceil(size(frame, 1)/5):end,:));
+                frame(:,:,1) = frame(:,:,1) * this.display_scale(1);
+                frame(:,:,2) = frame(:,:,2) * this.display_scale(2);
 
                 %% Plot frame. If contrast is 0 for one channel, plot only 1 color
-                % Be aware that this.data was altered by contrast and 
-                % recasting and do not represent the original data
-                this.data = uint16(this.data);
+                % Be aware that without pyramid, this.data was altered by 
+                % contrast and recasting and do not represent the original data
+                frame = uint16(frame);
+                if isempty(this.pyramid)
+                    this.data = frame;
+                end
                 if ~this.green_contrast
-                    set(this.plt, 'cdata', this.data(:,:,1));
+                    set(this.plt, 'cdata', frame(:,:,1));
                 elseif ~this.red_contrast
-                    set(this.plt, 'cdata', this.data(:,:,2));  %be aware that this.data was altered by contrast and recasting and do not represent the real values
+                    set(this.plt, 'cdata', frame(:,:,2));  %be aware that this.data was altered by contrast and recasting and do not represent the real values
                 else
-                    set(this.plt, 'cdata', this.data);  %be aware that this.data was altered by contrast and recasting and do not represent the real values
+                    set(this.plt, 'cdata', frame);  %be aware that this.data was altered by contrast and recasting and do not represent the real values
                 end
                 drawnow limitrate;
             end
@@ -340,6 +407,171 @@ classdef LiveViewer < viewer_params & BaseViewer
             end
         end
         
+        function set_layout(this, layout)
+            %% Display non-rectangular scans as a mosaic of patches
+            % -------------------------------------------------------------
+            % Syntax: 
+            %   LiveViewer.set_layout(layout)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   layout (ScanLayout object)
+            %       The layout of the current scan. The viewer must have
+            %       been created with a size of layout.mosaic_size. Use []
+            %       to go back to a direct stream to frame mapping.
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            %---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            
+            if isempty(layout)
+                this.scatter_map = [];
+                this.frame_points = this.num_pixels;
+            elseif prod(layout.mosaic_size) ~= this.num_pixels
+                error('The LiveViewer size must match the ScanLayout mosaic size')
+            else
+                this.scatter_map = uint32(layout.scatter_map);
+                this.frame_points = layout.n_points;
+            end
+            this.reset();
+        end
+        
+        function refresh_dirty_lines(this)
+            %% Display the lines acquired since the last refresh
+            % -------------------------------------------------------------
+            % Syntax: 
+            %   LiveViewer.refresh_dirty_lines()
+            % -------------------------------------------------------------
+            % Inputs:
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   Only the columns of the displayed image covering the dirty
+            %   lines are processed and updated, using the flat field and
+            %   auto-contrast of the last full frame. The cost of a refresh
+            %   is therefore proportional to the number of new lines.
+            %   Before the first full frame, the auto-contrast is computed
+            %   on the first refreshed lines.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            %---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            
+            lines = find(this.dirty_lines);
+            this.dirty_lines(:) = false;
+            this.line_timer = tic;
+            if isempty(lines)
+                return
+            end
+
+            %% Get the matching columns at the displayed resolution
+            level = this.get_current_display_level();
+            if level
+                lines = unique(ceil(lines / 2^level));
+                img = single(this.pyramid.levels{level}(:, lines, :));
+            else
+                img = single(this.data(:, lines, :));
+            end
+            if this.flatten_field
+                flat_field = this.get_display_flat_field(level);
+                img = img ./ flat_field(:, lines, :);
+            end
+            if isempty(this.display_scale)
+                this.display_scale = this.get_display_scale(img);
+            end
+            img(:,:,1) = img(:,:,1) * this.display_scale(1);
+            img(:,:,2) = img(:,:,2) * this.display_scale(2);
+            img = uint16(img);
+
+            %% Update these columns only. Skip if the displayed image has another size (e.g. level just changed)
+            cdata = get(this.plt, 'cdata');
+            if size(cdata, 1) ~= size(img, 1) || size(cdata, 2) < lines(end)
+                return
+            end
+            if ~this.green_contrast
+                cdata(:, lines) = img(:,:,1);
+            elseif ~this.red_contrast
+                cdata(:, lines) = img(:,:,2);
+            else
+                cdata(:, lines, :) = img;
+            end
+            set(this.plt, 'cdata', cdata);
+            drawnow limitrate;
+        end
+        
+        function set_display_level(this, level)
+            %% Display a downsampled version of the frame
+            % -------------------------------------------------------------
+            % Syntax: 
+            %   LiveViewer.set_display_level(level)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   level (INT)
+            %       - 0 displays the full resolution frame (default).
+            %       - n > 0 displays the frame 2^n times smaller in each
+            %       dimension.
+            %       - -1 selects the level that matches the axes size in
+            %       screen pixels, at each refresh.
+            % -------------------------------------------------------------
+            % Outputs:
+            % -------------------------------------------------------------
+            % Extra Notes:
+            %   Downsampled levels are maintained in a FramePyramid, which
+            %   is updated incrementally as lines are acquired. Only the
+            %   displayed level is processed (flat field, contrast) and
+            %   sent to the figure. this.data remains the full resolution
+            %   frame, unaltered by the display.
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            %---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            
+            this.display_level = round(level);
+            this.display_flat_field = [];
+            if this.display_level
+                this.pyramid = FramePyramid([this.data_size, 3], max(1, FramePyramid.default_levels(this.data_size)));
+            else
+                this.pyramid = [];
+            end
+            
+            %% Keep the same axes whatever the resolution
+            set(this.plt, 'XData', [1, this.data_size(2)], 'YData', [1, this.data_size(1)]);
+        end
+        
+        function level = get_current_display_level(this)
+            %% Return the pyramid level currently displayed. 0 is full resolution
+            if isempty(this.pyramid)
+                level = 0;
+            elseif this.display_level < 0
+                window_size = getpixelposition(this.plt.Parent);
+                level = this.pyramid.level_for_window(window_size([4, 3]));
+            else
+                level = min(this.display_level, this.pyramid.n_levels);
+            end
+        end
+        
+        function flat_field = get_display_flat_field(this, level)
+            %% Return flat_field at the displayed resolution, as SINGLE
+            % Downsampled flat fields are cached. Clear
+            % this.display_flat_field if you change this.flat_field
+            if ~level
+                flat_field = single(this.flat_field);
+            else
+                if size(this.display_flat_field, 1) ~= ceil(this.data_size(1) / 2^level)
+                    this.display_flat_field = FramePyramid.downsample(this.flat_field, level);
+                end
+                flat_field = this.display_flat_field;
+            end
+        end
+        
         function set.preset_mode(this, value)
             % update the viewer_params. If you use time average, you have
             % to set the frame duration
@@ -381,6 +613,38 @@ classdef LiveViewer < viewer_params & BaseViewer
             this.regenerate_buffers(round(this.refresh_limit * this.refresh_scaling_factor));
         end
 
+        function display_scale = get_display_scale(this, frame)
+            %% Red and green auto-contrast gains for a [x y channel] region
+            % -------------------------------------------------------------
+            % Syntax: 
+            %   display_scale = LiveViewer.get_display_scale(frame)
+            % -------------------------------------------------------------
+            % Inputs:
+            %   frame ([X * Y * C] SINGLE)
+            %       Pixels used to estimate the contrast
+            % -------------------------------------------------------------
+            % Outputs:
+            %   display_scale ([1 x 2] FLOAT)
+            %       Red and green gains. 1 if auto-contrast is off
+            % -------------------------------------------------------------
+            % Author(s):
+            %   Antoine Valera
+            %---------------------------------------------
+            % Revision Date:
+            %   18-10-2026
+            
+            display_scale = [1, 1];
+            contrast = [this.red_contrast, this.green_contrast];
+            auto_contrast = [this.auto_contrast_red, this.auto_contrast_green];
+            for ch = find(auto_contrast)
+                initial_max = prctile(reshape(frame(:,:,ch),[],1),this.autocontrast_thr);
+                if initial_max > 2000 %qq  mitigates autocontrast issue
+                    initial_max = 2000;
+                end
+                display_scale(ch) = 2^16 / (initial_max/contrast(ch));
+            end
+        end
+
         function regenerate_buffers(this, n_frames)
             this.holder0 = zeros(this.data_size(1), this.data_size(2), n_frames+1, 'uint16');
             this.holder1 = zeros(this.data_size(1), this.data_size(2), n_frames+1, 'uint16');
@@ -390,6 +654,7 @@ classdef LiveViewer < viewer_params & BaseViewer
             this.next_elem0 = 1;
             this.next_elem1 = 1;
             this.data = this.zeroed_frame;
+            this.dirty_lines(:) = false;
             %this.plt = figure(1000);
             %set(this.plt, 'cdata', get(this.plt, 'cdata')*0.5);
             this.current_frame = 0;
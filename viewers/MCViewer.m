@@ -4,7 +4,8 @@
 % the function inputs and outputs.
 % -------------------------------------------------------------------------
 % Syntax: 
-%   this = MCViewer(plot, name_suffix)
+%   this = MCViewer(plot, name_suffix, sampling_rate, log_format,
+%                   refresh_period)
 % -------------------------------------------------------------------------
 % Class Generation Inputs:
 %   plot (BOOL) - Optional - default is false
@@ -13,6 +14,26 @@
 %
 %   name_suffix (STR) - Optional - default is ''
 %                           filename suffix when writing log in file. 
+%
+%   sampling_rate (FLOAT) - Optional - default is 
+%           controller.rig_params.mc_sampling_rate, or 0 if not set
+%                           If > 0, MC registers are sampled at this rate
+%                           (in Hz) by an MCSampler, and update() processes
+%                           all the samples acquired since the last call.
+%                           If 0, update() reads the registers once per
+%                           call.
+%
+%   refresh_period (FLOAT) - Optional - default is 0.1
+%                           When logging sampled data, period (in s) of
+%                           the timer calling update().
+%
+%   log_format (STR) - Optional - any of {'binary', 'text'} - default is
+%           controller.rig_params.mc_log_format, or 'text' if not set
+%                           Format of the log file, when plot is false.
+%                           'text' writes the legacy tab separated .txt
+%                           file (see import_MC_log). 'binary' writes fixed
+%                           size records in a .mcbin file (see
+%                           import_MC_binary_log).
 % -------------------------------------------------------------------------
 % Outputs: 
 %   this (MCViewer object)
@@ -33,10 +54,33 @@
 % * Update MCViewer currently data (for display)
 %   MCViewer.update_data_array(controller, var1, var2, var3, var4, var5, var6)
 %
+% * Set the acquisition start, as a reference for sample and event times
+%   MCViewer.mark_acquisition_start()
+%
 % * Delete MCViewer, close figure or stop writing log file and close
 %   MCViewer.delete()
 % -------------------------------------------------------------------------
 % Extra Notes:
+% * With an MCSampler, logs are uniformly sampled and their rate does not
+%   depend on the acquisition loop (FIFO buffer size, display...). Each
+%   logged line is timestamped with its own sample time.
+%
+% * When logging with an MCSampler, update() is called by a timer
+%   (refresh_timer) instead of the FIFO read loop, so a slow or blocked
+%   FIFO read does not delay MC logging. Lost / recovered tracking events
+%   queued by the sampler are appended to MCViewer.events at each update,
+%   as [t_acq, register index, value] rows (see MCSampler.EVENT_REGISTERS).
+%   Without sampler, or when plotting, data_acquisition.get_data still
+%   calls update() between FIFO reads. The timer keeps the viewer alive,
+%   so replace Controller.rig_params.bg_mc_monitoring with
+%   Controller.set_mc_monitoring(), which deletes the previous viewer.
+%
+% * Binary logs store the raw register values, the lost/correcting flags
+%   and the trial index (parsed from a 'repeat_N' name_suffix), plus one
+%   marker record at the acquisition start (mark_acquisition_start()),
+%   on the same clock as the samples. A batch of
+%   samples is written with a single fwrite, and the file is loaded with a
+%   few typecasts instead of textscan.
 % -------------------------------------------------------------------------
 % Examples:
 % -------------------------------------------------------------------------
@@ -65,9 +109,9 @@
 % limitations under the License. 
 % -------------------------------------------------------------------------
 % Revision Date:
-%   16-03-2020
+%   18-10-2026
 %
-% See also: movement_correction, initialise_timed_image, imaging
+% See also: movement_correction, initialise_timed_image, imaging, MCSampler
 
 
 
@@ -96,10 +140,16 @@ classdef MCViewer < handle
         title1,title2,title5
         current_rms = 0;
         plot
+        sampler     = [];   % MCSampler. If empty, registers are read at each update() call
+        log_format  = 'text'; % 'text' (.txt) or 'binary' (.mcbin) log file
+        trial       = 0;    % Trial index written in binary records
+        refresh_timer = []; % Timer calling update() when logging sampled data
+        refresh_period = 0.1; % Period of refresh_timer, in s
+        events      = zeros(0, 3); % [t_acq, register index, value] of MC lost / recovered events
     end
     
     methods
-        function obj = MCViewer(plot, name_suffix)
+        function obj = MCViewer(plot, name_suffix, sampling_rate, log_format, refresh_period)
             %% If plot is false, then log data in a file
             if nargin < 1
                 obj.plot = false;
@@ -109,6 +159,27 @@ classdef MCViewer < handle
             if nargin < 2
                 name_suffix = '';
             end
+            if nargin < 3 || isempty(sampling_rate)
+                controller = get_existing_controller_name(true);
+                if isfield(controller.rig_params, 'mc_sampling_rate')
+                    sampling_rate = controller.rig_params.mc_sampling_rate;
+                else
+                    sampling_rate = 0;
+                end
+            end
+            if nargin >= 4 && ~isempty(log_format)
+                obj.log_format = log_format;
+            else
+                if ~exist('controller', 'var')
+                    controller = get_existing_controller_name(true);
+                end
+                if isfield(controller.rig_params, 'mc_log_format')
+                    obj.log_format = controller.rig_params.mc_log_format;
+                end
+            end
+            if nargin >= 5 && ~isempty(refresh_period)
+                obj.refresh_period = refresh_period;
+            end
             
             obj.current_var1 = zeros(1,obj.max_length);
             obj.current_var2 = zeros(1,obj.max_length);
@@ -123,8 +194,37 @@ classdef MCViewer < handle
             else
                 obj.fig = [];
                 cl = clock();
-                obj.filename = sprintf('%d_%d_%d-%d_%d_%d_MC_log_%s.txt',cl(1),cl(2),cl(3),cl(4),cl(5),round(cl(6)),name_suffix);
-                obj.file = fopen(obj.filename, 'w' );
+                if strcmp(obj.log_format, 'binary')
+                    obj.filename = sprintf('%d_%d_%d-%d_%d_%d_MC_log_%s.mcbin',cl(1),cl(2),cl(3),cl(4),cl(5),round(cl(6)),name_suffix);
+                    obj.file = fopen(obj.filename, 'w' );
+                    trial_idx = regexp(name_suffix, 'repeat_(\d+)', 'tokens', 'once');
+                    if ~isempty(trial_idx)
+                        obj.trial = str2double(trial_idx{1});
+                    end
+                    fwrite(obj.file, [uint8('SLMC'), typecast(uint32([1, 24, 0]), 'uint8')], 'uint8'); % See import_MC_binary_log
+                elseif strcmp(obj.log_format, 'text')
+                    obj.filename = sprintf('%d_%d_%d-%d_%d_%d_MC_log_%s.txt',cl(1),cl(2),cl(3),cl(4),cl(5),round(cl(6)),name_suffix);
+                    obj.file = fopen(obj.filename, 'w' );
+                else
+                    error('MC log_format must be ''binary'' or ''text''')
+                end
+            end
+            
+            %% Start background sampling of the MC registers (not in simulation mode)
+            if sampling_rate > 0
+                if ~exist('controller', 'var')
+                    controller = get_existing_controller_name(true);
+                end
+                if ~isempty(controller.daq_fpga.capi.Session)
+                    obj.sampler = MCSampler(controller.daq_fpga.capi, sampling_rate);
+                end
+            end
+            
+            %% When logging sampled data, consume the sampler queues on a timer
+            if ~isempty(obj.sampler) && ~obj.plot
+                obj.refresh_timer = timer('TimerFcn', @(~,~) obj.update(), 'ExecutionMode', 'fixedRate',...
+                                          'Period', obj.refresh_period, 'BusyMode', 'drop', 'Name', 'background_mc_log');
+                start(obj.refresh_timer);
             end
             
             this.type = 'MC_viewer';
@@ -145,7 +245,29 @@ classdef MCViewer < handle
             end
             
             %% Receives or Read from CAPI 6 values (single values or arrays) 
-            if nargin < 4
+            sample_time = [];
+            if nargin < 4 && ~isempty(obj.sampler)
+                %% Get all samples since the last update
+                [sample_time, values] = obj.sampler.read();
+                events = obj.sampler.read_events();
+                if ~isempty(events.t)
+                    [~, reg_idx] = ismember(events.register, obj.sampler.EVENT_REGISTERS);
+                    obj.events = [obj.events; events.t_acq, reg_idx, events.value];
+                end
+                if isempty(sample_time)
+                    return
+                end
+                var1 = values(:, 1)';
+                var2 = values(:, 2)';
+                var3 = values(:, 3)';
+                var4 = values(:, 4)';
+                var5 = values(:, 5)';
+                var6 = values(:, 6)';
+                if ~controller.daq_fpga.capi.Enable_ZMC
+                    var3(:) = NaN;
+                    var6(:) = NaN;
+                end
+            elseif nargin < 4
                 var1 = single(controller.daq_fpga.capi.x_correction_X10)/10;
                 var2 = single(controller.daq_fpga.capi.y_correction_X10)/10;
                 var4 = single(controller.daq_fpga.capi.x_diff_X100)/100;
@@ -166,7 +288,14 @@ classdef MCViewer < handle
 %             end
 
             %% Software auto_relock
-            if controller.daq_fpga.mc_auto_relock
+            if controller.daq_fpga.mc_auto_relock && ~isempty(sample_time)
+                %% Use the last sample instead of reading the registers again
+                xy = max(abs(round(var1(end) * 10)), abs(round(var2(end) * 10)));
+                z = int16(controller.daq_fpga.Z_Lines) * abs(round(values(end, 3) * 100));
+                if controller.daq_fpga.is_correcting && (xy == 1280 || z == 12800)
+                    controller.pause_resume_MC(false) ; pause(0.01);
+                end
+            elseif controller.daq_fpga.mc_auto_relock
                 xy = max(abs(controller.daq_fpga.capi.x_correction_X10), abs(controller.daq_fpga.capi.y_correction_X10));
                 z = int16(controller.daq_fpga.Z_Lines) * abs(controller.daq_fpga.capi.z_correction_X100);
                 if controller.daq_fpga.is_correcting && (xy == 1280 || z == 12800)
@@ -180,6 +309,13 @@ classdef MCViewer < handle
 
             %% Update figure when using a viewer
             if obj.plot && isvalid(obj) && ~isempty(obj.fig)
+                %% Large batches of samples: only display the most recent ones
+                n_max = floor(obj.max_length / 2);
+                if numel(var1) > n_max
+                    [var1, var2, var3, var4, var5, var6] = deal(var1(end-n_max+1:end), var2(end-n_max+1:end), var3(end-n_max+1:end),...
+                                                                var4(end-n_max+1:end), var5(end-n_max+1:end), var6(end-n_max+1:end));
+                end
+                
                 %% Reset array
                 if obj.current_point >= obj.max_length - numel(var1)
                     obj.current_point = 1;
@@ -207,8 +343,8 @@ classdef MCViewer < handle
                 %% Update data arrays
                 obj.update_data_array(controller, var1, var2, var3, var4, var5, var6);
 
-                %% Plot data every plotting_point_frequency points
-                if ~mod(obj.current_point,obj.plotting_point_frequency)
+                %% Plot data every plotting_point_frequency points, or at every batch
+                if ~mod(obj.current_point,obj.plotting_point_frequency) || numel(var1) > 1
                     f = gcf();
                     if ~isvalid(obj.fig) || f.Number ~= 1004
                         obj.fig = figure(1004);
@@ -246,6 +382,26 @@ classdef MCViewer < handle
                 %% Prepare next plot
                 obj.current_point = obj.current_point + numel(var1);
                 
+            elseif isvalid(obj) && strcmp(obj.log_format, 'binary') % When logging in binary, one record per sample
+                if isempty(sample_time)
+                    t_ns = MCViewer.datenum_to_ns(now);
+                    lost = double([controller.daq_fpga.capi.lostx, controller.daq_fpga.capi.lostz]) == 1;
+                else
+                    t_ns = int64(round(obj.sampler.start_posix * 1e9)) + int64(round(sample_time(:) * 1e9)); % monotonic sample times, anchored once
+                    lost = values(:, 7:8) == 1;
+                end
+                flags = uint16(controller.daq_fpga.capi.Enable_ZMC == 1) + 2 * uint16(lost(:, 1)) + 4 * uint16(lost(:, 2)) + 8 * uint16(controller.daq_fpga.is_correcting);
+                raw = int16(round(double([var1; var2; var3; var4; var5; var6]') .* [10, 10, 100, 100, 100, 100])); % NaN are written as 0
+                obj.write_binary_records(t_ns, raw, flags);
+                obj.current_point = obj.current_point + numel(t_ns);
+            elseif isvalid(obj) && ~isempty(sample_time) % When logging sampled data, one line per sample
+                cl = datevec(obj.sampler.start_time + sample_time / 86400);
+                if controller.daq_fpga.capi.Enable_ZMC
+                    fprintf(obj.file, '%d:%d:%2.3f\t%d\t%d\t%d\t%d\t%d\t%d\t\n', [cl(:,4:6), double([var1; var2; var3; var4; var5; var6]')]');
+                else
+                    fprintf(obj.file, '%d:%d:%2.3f\t%d\t%d\t%d\t%d\t\n', [cl(:,4:6), double([var1; var2; var4; var5]')]');
+                end
+                obj.current_point = obj.current_point + numel(sample_time);
             elseif isvalid(obj) % When logging
                 cl = clock();
                 if controller.daq_fpga.capi.Enable_ZMC
@@ -257,6 +413,26 @@ classdef MCViewer < handle
             end
         end
        
+        function mark_acquisition_start(obj)
+            %% Set the acquisition start on the sampler clock, if any
+            % Binary logs also get a marker record (flag 16) at that time,
+            % so MC times can be aligned to the acquisition offline (see
+            % import_MC_binary_log)
+            t_ns = [];
+            if ~isempty(obj.sampler)
+                obj.sampler.mark_acquisition_start();
+                if ~isnan(obj.sampler.acq_start)
+                    t_ns = int64(round(obj.sampler.start_posix * 1e9)) + int64(round(obj.sampler.acq_start * 1e9)); % same clock as the samples
+                end
+            end
+            if ~obj.plot && strcmp(obj.log_format, 'binary') && ~isempty(obj.file)
+                if isempty(t_ns)
+                    t_ns = MCViewer.datenum_to_ns(now);
+                end
+                obj.write_binary_records(t_ns, zeros(1, 6, 'int16'), uint16(16));
+            end
+        end
+        
         function reset(obj)
             obj.current_point = 1;
             %obj.fig = figure(1004);
@@ -325,7 +501,29 @@ classdef MCViewer < handle
         end
         
         
+        function write_binary_records(obj, t_ns, raw, flags)
+            %% Write N records in a binary log (see import_MC_binary_log)
+            % t_ns is [N x 1] INT64, raw is [N x 6] INT16, flags is [N x 1]
+            % UINT16. All records are packed in a [24 x N] byte array and
+            % written at once
+            n   = numel(t_ns);
+            rec = zeros(24, n, 'uint8');
+            rec(1:8, :)     = reshape(typecast(int64(t_ns(:)'), 'uint8'), 8, n);
+            rec(9:20, :)    = reshape(typecast(reshape(int16(raw)', 1, []), 'uint8'), 12, n);
+            rec(21:22, :)   = reshape(typecast(uint16(flags(:)'), 'uint8'), 2, n);
+            rec(23:24, :)   = repmat(typecast(uint16(obj.trial), 'uint8')', 1, n);
+            fwrite(obj.file, rec, 'uint8');
+        end
+        
         function delete(obj)
+            if ~isempty(obj.refresh_timer) && isvalid(obj.refresh_timer)
+                stop(obj.refresh_timer);
+                delete(obj.refresh_timer);
+                obj.update(); % Log the samples acquired since the last timer call
+            end
+            if ~isempty(obj.sampler)
+                obj.sampler.delete();
+            end
             if ~isempty(obj.fig) && isvalid(obj.fig)
                 delete(figure(1004));
                 %stop(timerfind('Name','background_mc_plot'));
@@ -333,6 +531,18 @@ classdef MCViewer < handle
                 fclose(obj.file);
             end
         end
-    end    
+    end
+    
+    methods (Static)
+        function t_ns = datenum_to_ns(t_datenum, offset_s)
+            %% Convert a datenum (+ offset in s) to INT64 ns since 1970-01-01
+            % The offset is added in integer ns, to keep the sampler
+            % resolution despite the limited precision of datenums
+            if nargin < 2 || isempty(offset_s)
+                offset_s = 0;
+            end
+            t_ns = int64(round((t_datenum - datenum(1970, 1, 1)) * 86400 * 1e9)) + int64(round(offset_s(:) * 1e9));
+        end
+    end
 end
 
@@ -44,7 +44,7 @@
 %
 % See also: controller, LiveViewer, set_up_image_viewer, ScanParams
 
-% TODO : we could allow non square ROIs and variable size miniscans here
+% TODO : we could allow non square ROIs here
 
 function create_viewer(controller)
     if nargin < 1 || isempty(controller)
@@ -55,14 +55,17 @@ function create_viewer(controller)
     if ~isempty(controller.viewer) && strcmp(controller.viewer.type, 'live_image')
         bkp = controller.viewer.get_current_parameters_set();
         controller.gui_handles.viewer_mode = controller.viewer.preset_mode;
+        publisher = controller.viewer.publisher;
     else
         bkp = [];
+        publisher = [];
     end
 
     %% Create the GUI if required
     set_up_image_viewer(controller);
 
     %% Prepare Viewer Settings depending on the scan mode
+    layout = [];
     if controller.scan_params.imaging_mode == ImagingMode.Pointing 
         viewer_resolution_x = sqrt(controller.scan_params.num_drives);
         viewer_resolution_y = sqrt(controller.scan_params.num_drives);
@@ -73,7 +76,10 @@ function create_viewer(controller)
         viewer_resolution_x = unique(controller.scan_params.voxels_for_ramp);
         viewer_resolution_y = controller.scan_params.num_drives;
     else
-        error('Unable to generate a frame. Number of voxels varies from ramp to ramp')
+        %% Variable size miniscans are displayed as a mosaic of patches
+        layout = ScanLayout(controller.scan_params);
+        viewer_resolution_x = layout.mosaic_size(1);
+        viewer_resolution_y = layout.mosaic_size(2);
     end
     
     %% QQ - Auto-ADD POINT VIEWER HERE
@@ -86,12 +92,20 @@ function create_viewer(controller)
                                     ~controller.gui_handles.is_gui,...
                                     controller.gui_handles.is_gui,...
                                     controller.gui_handles.frame_averages);
-
+    if ~isempty(layout)
+        controller.viewer.set_layout(layout);
+    end
 
     %% Restore pre-existing LiveViewer settings
     if ~isempty(bkp)
         controller.viewer.set_new_parameters_set(bkp);
     end
+    
+    %% Keep publishing frames with the new geometry
+    if ~isempty(publisher)
+        publisher.set_geometry(controller.scan_params);
+        controller.viewer.publisher = publisher;
+    end
 
    %% Add um scal for conveniency                             
 %    figure(1000); hold on;
@@ -0,0 +1 @@
+mex -O ./frame_publisher.c
\ No newline at end of file
@@ -0,0 +1,493 @@
+/*=================================================================
+ *      Publishes live frames and raw channel blocks in shared memory
+ *
+ *      The calling syntax is:
+ *
+ *        handle = frame_publisher('open', name, n_slots, slot_bytes)
+ *        published = frame_publisher('publish', handle, kind, item_id,
+ *                                    geometry, data0, data1, ...)
+ *        [header, data] = frame_publisher('read', name)
+ *        frame_publisher('close', handle)
+ *
+ *      - each 'open' creates an independent ring and returns its
+ *        handle. Up to 16 rings can be open, with different names.
+ *        Handles are not reused, so a closed handle is always rejected
+ *      - kind is 0 for frames, 1 for raw blocks (see frame_ring.h)
+ *      - geometry is [imaging_mode, num_drives, num_voxels]
+ *      - data0, data1... must have the same class. They are written
+ *        one after the other. For a single array, dims are its
+ *        first 3 dimensions, otherwise [numel(data0), 1, n_arrays]
+ *      - published is false if the payload does not fit in a slot
+ *      - 'read' opens an existing ring and returns the latest item,
+ *        mostly to check the publisher from another MATLAB session.
+ *        data is empty if no consistent copy could be made
+ *      - 'open' refuses a name already used by a live ring, including
+ *        one created by another MATLAB session
+ *
+ *      See frame_ring.h for the memory layout and reading protocol.
+ *
+ *      This is a MEX-file for MATLAB.
+ *=================================================================*/
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include "mex.h"
+#include "frame_ring.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #define memory_barrier() MemoryBarrier()
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <unistd.h>
+    #define memory_barrier() __sync_synchronize()
+#endif
+
+#define MAX_RINGS       16
+#define MAX_RING_BYTES  ((uint64_t)1 << 36)  // 64 GB, far above any real ring
+#define MAP_EXISTS      (-1)                 // map_memory result if a live ring already uses the name
+
+typedef struct {
+    uint32_t           id;            // Handle returned by 'open'. 0 if the entry is free
+    char               name[200];
+    frame_ring_header *ring;
+    uint64_t           bytes;
+#if defined(_WIN32)
+    HANDLE             mapping;
+#else
+    char               shm_name[256];
+#endif
+} ring_entry;
+
+static ring_entry rings[MAX_RINGS];
+static uint32_t next_id = 1;       // Handles are never reused, so a stale handle cannot reach a newer ring
+
+static double now_s(void) {
+#if defined(_WIN32)
+    FILETIME ft;
+    ULARGE_INTEGER t;
+    GetSystemTimeAsFileTime(&ft);
+    t.LowPart = ft.dwLowDateTime;
+    t.HighPart = ft.dwHighDateTime;
+    return (double)(t.QuadPart - 116444736000000000ULL) * 1e-7; // 100 ns since 1601 to s since 1970
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static frame_slot_header *slot_at(frame_ring_header *r, uint32_t n_slots, uint32_t slot_bytes, uint64_t index) {
+    return (frame_slot_header *)((char *)r + sizeof(frame_ring_header)
+                                 + (index % n_slots) * FRAME_RING_SLOT_STRIDE(slot_bytes));
+}
+
+static frame_slot_header *get_slot(frame_ring_header *r, uint64_t index) {
+    return slot_at(r, r->n_slots, r->slot_bytes, index); // Writer side, the header was validated by open_ring
+}
+
+static size_t data_type_size(uint32_t data_type) {
+    static const size_t sizes[] = {1, 2, 2, 4, 4, 4, 8};
+    return (data_type >= 1 && data_type <= 7) ? sizes[data_type - 1] : 0;
+}
+
+static uint32_t get_data_type(const mxArray *a) {
+    switch (mxGetClassID(a)) {
+        case mxUINT8_CLASS:  return FRAME_RING_UINT8;
+        case mxUINT16_CLASS: return FRAME_RING_UINT16;
+        case mxINT16_CLASS:  return FRAME_RING_INT16;
+        case mxUINT32_CLASS: return FRAME_RING_UINT32;
+        case mxINT32_CLASS:  return FRAME_RING_INT32;
+        case mxSINGLE_CLASS: return FRAME_RING_SINGLE;
+        case mxDOUBLE_CLASS: return FRAME_RING_DOUBLE;
+        default: mexErrMsgTxt("Unsupported data class. Use uint8, uint16, int16, uint32, int32, single or double");
+    }
+    return 0;
+}
+
+#if !defined(_WIN32)
+static int is_live_ring(const char *shm_name) {
+    // True if shm_name holds an initialised ring, which may still have readers and a writer
+    frame_ring_header *r;
+    struct stat st;
+    int live = 0;
+    int fd = shm_open(shm_name, O_RDONLY, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= sizeof(frame_ring_header)) {
+        r = (frame_ring_header *)mmap(NULL, sizeof(frame_ring_header), PROT_READ, MAP_SHARED, fd, 0);
+        if (r != MAP_FAILED) {
+            live = r->magic == FRAME_RING_MAGIC;
+            munmap(r, sizeof(frame_ring_header));
+        }
+    }
+    close(fd);
+    return live;
+}
+#endif
+
+static int map_memory(ring_entry *e, const char *name, uint64_t bytes, int create) {
+    void *ptr = NULL;
+#if defined(_WIN32)
+    char full_name[256];
+    snprintf(full_name, sizeof(full_name), "Local\\%s", name);
+    if (create) {
+        e->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        (DWORD)(bytes >> 32), (DWORD)(bytes & 0xFFFFFFFF), full_name);
+    } else {
+        e->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, full_name);
+    }
+    if (e->mapping == NULL) {
+        return 0;
+    }
+    if (create && GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(e->mapping); // Already used by another ring. Never reset it under its readers
+        e->mapping = NULL;
+        return MAP_EXISTS;
+    }
+    ptr = MapViewOfFile(e->mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, create ? (SIZE_T)bytes : 0);
+    if (ptr == NULL) {
+        CloseHandle(e->mapping);
+        e->mapping = NULL;
+        return 0;
+    }
+#else
+    int fd;
+    struct stat st;
+    snprintf(e->shm_name, sizeof(e->shm_name), "/%s", name);
+    fd = shm_open(e->shm_name, create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDONLY, 0666);
+    if (fd < 0 && create && errno == EEXIST) {
+        if (is_live_ring(e->shm_name)) {
+            return MAP_EXISTS;
+        }
+        shm_unlink(e->shm_name); // Not a ring, or never initialised. Safe to replace
+        fd = shm_open(e->shm_name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    }
+    if (fd < 0) {
+        return 0;
+    }
+    if (create && ftruncate(fd, (off_t)bytes) != 0) {
+        close(fd);
+        shm_unlink(e->shm_name);
+        return 0;
+    }
+    if (!create) {
+        if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(frame_ring_header)) {
+            close(fd);
+            return 0;
+        }
+        bytes = (uint64_t)st.st_size;
+    }
+    ptr = mmap(NULL, (size_t)bytes, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        if (create) {
+            shm_unlink(e->shm_name);
+        }
+        return 0;
+    }
+#endif
+    e->ring = (frame_ring_header *)ptr;
+    e->bytes = bytes;
+#if defined(_WIN32)
+    if (!create) {
+        MEMORY_BASIC_INFORMATION info; // Views are rounded to pages, use the region size as the mapped size
+        e->bytes = VirtualQuery(ptr, &info, sizeof(info)) ? (uint64_t)info.RegionSize : 0;
+    }
+#endif
+    return 1;
+}
+
+static void unmap_memory(ring_entry *e, int unlink_name) {
+    if (e->ring == NULL) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(e->ring);
+    CloseHandle(e->mapping);
+    e->mapping = NULL;
+#else
+    munmap(e->ring, (size_t)e->bytes);
+    if (unlink_name) {
+        shm_unlink(e->shm_name);
+    }
+#endif
+    e->ring = NULL;
+    e->bytes = 0;
+    e->id = 0;
+    e->name[0] = '\0';
+}
+
+static void close_all(void) {
+    int i;
+    for (i = 0; i < MAX_RINGS; i++) {
+        unmap_memory(&rings[i], 1);
+    }
+}
+
+static ring_entry *get_ring(const mxArray *handle) {
+    uint32_t id;
+    int i;
+    if (!mxIsNumeric(handle) || mxGetNumberOfElements(handle) != 1) {
+        mexErrMsgTxt("The publisher handle must be the scalar returned by frame_publisher('open', ...)");
+    }
+    id = (uint32_t)mxGetScalar(handle);
+    for (i = 0; id && i < MAX_RINGS; i++) {
+        if (rings[i].id == id) {
+            return &rings[i];
+        }
+    }
+    mexErrMsgTxt("Invalid publisher handle. The ring was closed or never opened");
+    return NULL;
+}
+
+static uint32_t open_ring(const char *name, double n_slots_in, double slot_bytes_in) {
+    uint32_t n_slots, slot_bytes;
+    uint64_t bytes;
+    ring_entry *e = NULL;
+    int i, mapped;
+
+    // Validate the geometry before anything is created
+    if (!(n_slots_in >= 1) || n_slots_in > 0xFFFFFFFFu) {
+        mexErrMsgTxt("n_slots must be at least 1");
+    }
+    if (!(slot_bytes_in >= 1) || slot_bytes_in > 0xFFFFFFFFu - 63u) {
+        mexErrMsgTxt("slot_bytes must be at least 1, and fit in 32 bits");
+    }
+    n_slots = (uint32_t)n_slots_in;
+    slot_bytes = (uint32_t)slot_bytes_in;
+    if (FRAME_RING_SLOT_STRIDE(slot_bytes) > (MAX_RING_BYTES - sizeof(frame_ring_header)) / n_slots) {
+        mexErrMsgTxt("n_slots x slot_bytes is too large for a shared memory ring");
+    }
+    bytes = FRAME_RING_TOTAL_BYTES(n_slots, slot_bytes);
+    if (bytes > (uint64_t)(size_t)-1) {
+        mexErrMsgTxt("n_slots x slot_bytes is too large for this platform");
+    }
+
+    for (i = 0; i < MAX_RINGS; i++) {
+        if (rings[i].id && !strcmp(rings[i].name, name)) {
+            mexErrMsgTxt("A frame publisher with this name is already open in this session. Close it first");
+        } else if (!rings[i].id && e == NULL) {
+            e = &rings[i];
+        }
+    }
+    if (e == NULL) {
+        mexErrMsgTxt("Too many frame publishers open in this session");
+    }
+    mapped = map_memory(e, name, bytes, 1);
+    if (mapped == MAP_EXISTS) {
+        mexErrMsgTxt("A frame publisher with this name is already running, possibly in another MATLAB session. Choose another name");
+    } else if (!mapped) {
+        mexErrMsgTxt("Unable to create shared memory");
+    }
+    memset(e->ring, 0, (size_t)bytes);
+    e->ring->n_slots    = n_slots;
+    e->ring->slot_bytes = slot_bytes;
+    e->ring->version    = FRAME_RING_VERSION;
+    memory_barrier();
+    e->ring->magic      = FRAME_RING_MAGIC; // Written last, so readers never see a half initialised ring
+    strncpy(e->name, name, sizeof(e->name) - 1);
+    e->id = next_id++;
+    mexAtExit(close_all);
+    return e->id;
+}
+
+static int publish(int nrhs, const mxArray *prhs[]) {
+    frame_slot_header *slot;
+    const double *geometry;
+    char *payload;
+    size_t elem_bytes, n_elem, n_bytes, i;
+    uint32_t data_type;
+    int n_arrays = nrhs - 5;
+    frame_ring_header *ring = get_ring(prhs[1])->ring;
+    const mwSize *dims;
+
+    if (n_arrays < 1 || mxGetNumberOfElements(prhs[4]) < 3) {
+        mexErrMsgTxt("Syntax is frame_publisher('publish', handle, kind, item_id, [imaging_mode, num_drives, num_voxels], data0, ...)");
+    }
+
+    // Check payload type and size before touching the slot
+    data_type = get_data_type(prhs[5]);
+    elem_bytes = mxGetElementSize(prhs[5]);
+    n_elem = mxGetNumberOfElements(prhs[5]);
+    for (i = 1; i < (size_t)n_arrays; i++) {
+        if (mxGetClassID(prhs[5 + i]) != mxGetClassID(prhs[5])) {
+            mexErrMsgTxt("All published arrays must have the same class");
+        }
+        if (mxGetNumberOfElements(prhs[5 + i]) < n_elem) {
+            n_elem = mxGetNumberOfElements(prhs[5 + i]); // Channels are cropped to the shortest one
+        }
+    }
+    n_bytes = n_elem * elem_bytes * n_arrays;
+    if (n_bytes > ring->slot_bytes) {
+        return 0;
+    }
+
+    // Open the slot (odd sequence number)
+    slot = get_slot(ring, ring->write_count);
+    slot->seq++;
+    memory_barrier();
+
+    // Header and payload
+    geometry = mxGetPr(prhs[4]);
+    slot->item_id      = (uint64_t)mxGetScalar(prhs[3]);
+    slot->timestamp    = now_s();
+    slot->kind         = (uint32_t)mxGetScalar(prhs[2]);
+    slot->data_type    = data_type;
+    slot->n_bytes      = (uint32_t)n_bytes;
+    slot->imaging_mode = (uint32_t)geometry[0];
+    slot->num_drives   = (uint32_t)geometry[1];
+    slot->num_voxels   = (uint32_t)geometry[2];
+    if (n_arrays == 1) {
+        dims = mxGetDimensions(prhs[5]);
+        slot->dims[0] = (uint32_t)dims[0];
+        slot->dims[1] = (uint32_t)(mxGetNumberOfDimensions(prhs[5]) > 1 ? dims[1] : 1);
+        slot->dims[2] = (uint32_t)(mxGetNumberOfDimensions(prhs[5]) > 2 ? n_elem / (dims[0] * dims[1]) : 1);
+    } else {
+        slot->dims[0] = (uint32_t)n_elem;
+        slot->dims[1] = 1;
+        slot->dims[2] = (uint32_t)n_arrays;
+    }
+    payload = (char *)slot + sizeof(frame_slot_header);
+    for (i = 0; i < (size_t)n_arrays; i++) {
+        memcpy(payload + i * n_elem * elem_bytes, mxGetData(prhs[5 + i]), n_elem * elem_bytes);
+    }
+
+    // Close the slot (even sequence number), then make it visible
+    memory_barrier();
+    slot->seq++;
+    memory_barrier();
+    ring->write_count++;
+    return 1;
+}
+
+static mxArray *dims_to_array(const uint32_t *dims) {
+    mxArray *out = mxCreateDoubleMatrix(1, 3, mxREAL);
+    double *pr = mxGetPr(out);
+    pr[0] = dims[0]; pr[1] = dims[1]; pr[2] = dims[2];
+    return out;
+}
+
+static void read_latest(const char *name, int nlhs, mxArray *plhs[]) {
+    static const char *fields[] = {"item_id", "timestamp", "kind", "dims", "imaging_mode", "num_drives", "num_voxels", "write_count"};
+    static const mxClassID classes[] = {mxUINT8_CLASS, mxUINT16_CLASS, mxINT16_CLASS, mxUINT32_CLASS, mxINT32_CLASS, mxSINGLE_CLASS, mxDOUBLE_CLASS};
+    ring_entry reader = {0};
+    frame_ring_header *r;
+    frame_slot_header *slot, copy;
+    mxArray *data = NULL;
+    mwSize dims[3];
+    uint64_t n, s1, s2, payload_bytes;
+    uint32_t n_slots, slot_bytes;
+    size_t copy_bytes;
+    int attempt;
+
+    // Map an existing ring, read only
+    if (!map_memory(&reader, name, 0, 0)) {
+        mexErrMsgTxt("No frame publisher found with this name");
+    }
+    r = reader.ring;
+    if (r->magic != FRAME_RING_MAGIC) {
+        unmap_memory(&reader, 0);
+        mexErrMsgTxt("No frame publisher found with this name");
+    }
+
+    // Never trust the shared header : the ring must fit in what was mapped
+    n_slots = r->n_slots;
+    slot_bytes = r->slot_bytes;
+    if (reader.bytes < sizeof(frame_ring_header) || n_slots < 1 || slot_bytes < 1 || slot_bytes > 0xFFFFFFFFu - 63u
+        || FRAME_RING_SLOT_STRIDE(slot_bytes) > (reader.bytes - sizeof(frame_ring_header)) / n_slots) {
+        unmap_memory(&reader, 0);
+        mexErrMsgTxt("Corrupted frame publisher : the ring header does not match the shared memory size");
+    }
+
+    plhs[0] = mxCreateStructMatrix(1, 1, 8, fields);
+    n = r->write_count;
+    for (attempt = 0; n && attempt < 100; attempt++) {
+        slot = slot_at(r, n_slots, slot_bytes, n - 1);
+        s1 = slot->seq;
+        memory_barrier();
+        if (s1 & 1) {
+            continue;
+        }
+        copy = *slot;
+
+        // Reject torn or corrupted headers before allocating anything
+        // Each partial product stays below 2^64 as the previous one is <= slot_bytes
+        payload_bytes = data_type_size(copy.data_type);
+        payload_bytes = (payload_bytes && copy.dims[0] && copy.dims[1] && copy.dims[2]
+                         && payload_bytes * copy.dims[0] <= slot_bytes
+                         && payload_bytes * copy.dims[0] * copy.dims[1] <= slot_bytes)
+                        ? payload_bytes * copy.dims[0] * copy.dims[1] * copy.dims[2] : (uint64_t)slot_bytes + 1;
+        if (payload_bytes > slot_bytes || copy.n_bytes > slot_bytes) {
+            n = r->write_count;
+            continue;
+        }
+        dims[0] = copy.dims[0]; dims[1] = copy.dims[1]; dims[2] = copy.dims[2];
+        data = mxCreateNumericArray(3, dims, classes[copy.data_type - 1], mxREAL);
+        copy_bytes = (size_t)(copy.n_bytes < payload_bytes ? copy.n_bytes : payload_bytes);
+        memcpy(mxGetData(data), (char *)slot + sizeof(frame_slot_header), copy_bytes);
+        memory_barrier();
+        s2 = slot->seq;
+        if (s1 != s2) {
+            mxDestroyArray(data); // Torn copy, never returned
+            data = NULL;
+        } else {
+            mxSetField(plhs[0], 0, "item_id",      mxCreateDoubleScalar((double)copy.item_id));
+            mxSetField(plhs[0], 0, "timestamp",    mxCreateDoubleScalar(copy.timestamp));
+            mxSetField(plhs[0], 0, "kind",         mxCreateDoubleScalar((double)copy.kind));
+            mxSetField(plhs[0], 0, "dims",         dims_to_array(copy.dims));
+            mxSetField(plhs[0], 0, "imaging_mode", mxCreateDoubleScalar((double)copy.imaging_mode));
+            mxSetField(plhs[0], 0, "num_drives",   mxCreateDoubleScalar((double)copy.num_drives));
+            mxSetField(plhs[0], 0, "num_voxels",   mxCreateDoubleScalar((double)copy.num_voxels));
+            mxSetField(plhs[0], 0, "write_count",  mxCreateDoubleScalar((double)n));
+            break;
+        }
+        n = r->write_count; // Overwritten while reading, try the newest item again
+    }
+    if (nlhs > 1) {
+        plhs[1] = data ? data : mxCreateDoubleMatrix(0, 0, mxREAL);
+    } else if (data) {
+        mxDestroyArray(data);
+    }
+
+    // Unmap without unlinking, the publisher may be in another session
+    unmap_memory(&reader, 0);
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    char command[16], name[200];
+
+    if (nrhs < 1 || mxGetString(prhs[0], command, sizeof(command))) {
+        mexErrMsgTxt("First argument must be 'open', 'publish', 'read' or 'close'");
+    }
+
+    if (!strcmp(command, "publish")) {
+        if (nrhs < 2) {
+            mexErrMsgTxt("Syntax is frame_publisher('publish', handle, kind, item_id, [imaging_mode, num_drives, num_voxels], data0, ...)");
+        }
+        plhs[0] = mxCreateLogicalScalar(publish(nrhs, prhs));
+    } else if (!strcmp(command, "open")) {
+        if (nrhs != 4 || mxGetString(prhs[1], name, sizeof(name))) {
+            mexErrMsgTxt("Syntax is frame_publisher('open', name, n_slots, slot_bytes)");
+        }
+        plhs[0] = mxCreateDoubleScalar((double)open_ring(name, mxGetScalar(prhs[2]), mxGetScalar(prhs[3])));
+    } else if (!strcmp(command, "read")) {
+        if (nrhs != 2 || mxGetString(prhs[1], name, sizeof(name))) {
+            mexErrMsgTxt("Syntax is [header, data] = frame_publisher('read', name)");
+        }
+        read_latest(name, nlhs, plhs);
+    } else if (!strcmp(command, "close")) {
+        if (nrhs != 2) {
+            mexErrMsgTxt("Syntax is frame_publisher('close', handle)");
+        }
+        unmap_memory(get_ring(prhs[1]), 1);
+    } else {
+        mexErrMsgTxt("Unknown command. Use 'open', 'publish', 'read' or 'close'");
+    }
+}
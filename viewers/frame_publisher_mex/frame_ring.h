@@ -0,0 +1,89 @@
+/*=================================================================
+ *      Shared memory layout of the live frame ring
+ *
+ *      This header is the only thing an external reader (C, C++,
+ *      Python through ctypes/numpy...) needs to consume frames and
+ *      raw channel blocks published by frame_publisher.c
+ *
+ *      Memory is named "/<name>" (POSIX shm_open) or "Local\<name>"
+ *      (Windows file mapping) and contains :
+ *
+ *        [frame_ring_header][slot 0][slot 1]...[slot n_slots - 1]
+ *
+ *      where each slot is a frame_slot_header followed by slot_bytes
+ *      of payload. All fields are little-endian, slots are 64 bytes
+ *      aligned.
+ *
+ *      Writing protocol (single writer, seqlock per slot) :
+ *          1 - slot = write_count % n_slots
+ *          2 - seq += 1 (odd : slot is being written)
+ *          3 - write slot header and payload
+ *          4 - seq += 1 (even : slot is valid)
+ *          5 - write_count += 1
+ *
+ *      Reading protocol (any number of readers, never blocks the writer) :
+ *          1 - n = write_count ; if n == 0, nothing published yet
+ *          2 - slot = (n - 1) % n_slots (or any older slot still in
+ *              the ring if you want every item)
+ *          3 - s1 = seq ; retry if s1 is odd
+ *          4 - copy slot header and payload
+ *          5 - s2 = seq ; the copy is valid only if s1 == s2
+ *
+ *      item_id increases by 1 for each item of a given kind, so readers
+ *      can detect dropped items.
+ *
+ *      Copyright (c) 2015-2020 University College London
+ *      Licensed under the Apache License, Version 2.0
+ *=================================================================*/
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <stdint.h>
+
+#define FRAME_RING_MAGIC        0x52464c53u  /* "SLFR" */
+#define FRAME_RING_VERSION      1u
+
+/* Item kinds */
+#define FRAME_RING_KIND_FRAME   0u  /* A completed frame, [x, y, channels]          */
+#define FRAME_RING_KIND_BLOCK   1u  /* A raw FIFO block, [points, 1, channels]      */
+
+/* Payload data types */
+#define FRAME_RING_UINT8        1u
+#define FRAME_RING_UINT16       2u
+#define FRAME_RING_INT16        3u
+#define FRAME_RING_UINT32       4u
+#define FRAME_RING_INT32        5u
+#define FRAME_RING_SINGLE       6u
+#define FRAME_RING_DOUBLE       7u
+
+typedef struct {
+    uint32_t          magic;          /* FRAME_RING_MAGIC                        */
+    uint32_t          version;        /* FRAME_RING_VERSION                      */
+    uint32_t          n_slots;        /* Number of slots in the ring             */
+    uint32_t          slot_bytes;     /* Max payload size of one slot            */
+    volatile uint64_t write_count;    /* Number of items published so far        */
+    uint8_t           reserved[40];   /* Pad to 64 bytes                         */
+} frame_ring_header;
+
+typedef struct {
+    volatile uint64_t seq;            /* Seqlock. Odd while the slot is written  */
+    uint64_t          item_id;        /* Frame or block counter, per kind        */
+    double            timestamp;      /* Publication time, s since 1970-01-01    */
+    uint32_t          kind;           /* FRAME_RING_KIND_*                       */
+    uint32_t          data_type;      /* FRAME_RING_* data type                  */
+    uint32_t          dims[3];        /* Column-major (MATLAB) dimensions        */
+    uint32_t          n_bytes;        /* Payload size                            */
+    uint32_t          imaging_mode;   /* ImagingMode value of the current scan   */
+    uint32_t          num_drives;     /* ScanParams.num_drives                   */
+    uint32_t          num_voxels;     /* ScanParams.num_voxels                   */
+    uint32_t          reserved;       /* Pad to 64 bytes                         */
+} frame_slot_header;
+
+#define FRAME_RING_SLOT_STRIDE(slot_bytes) \
+    (sizeof(frame_slot_header) + ((((uint64_t)(slot_bytes)) + 63u) & ~(uint64_t)63u))
+
+#define FRAME_RING_TOTAL_BYTES(n_slots, slot_bytes) \
+    (sizeof(frame_ring_header) + (uint64_t)(n_slots) * FRAME_RING_SLOT_STRIDE(slot_bytes))
+
+#endif /* FRAME_RING_H */